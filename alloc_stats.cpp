@@ -0,0 +1,143 @@
+#include <open62541/types.h>
+#include <cstdlib>
+#include <new>
+
+#include "alloc_stats.h"
+
+std::atomic<uint64_t> AllocStats::allocations(0);
+std::atomic<uint64_t> AllocStats::deallocations(0);
+std::atomic<uint64_t> AllocStats::bytes(0);
+
+// ============================== ПЕРЕХВАТ malloc В open62541 ==============================
+#if defined(UA_ENABLE_MALLOC_SINGLETON)
+
+static void* (*previousMalloc)(size_t) = nullptr;
+static void (*previousFree)(void*) = nullptr;
+static void* (*previousCalloc)(size_t, size_t) = nullptr;
+static void* (*previousRealloc)(void*, size_t) = nullptr;
+
+static void* countingMalloc(size_t size) {
+    AllocStats::recordAlloc(size);
+    return previousMalloc(size);
+}
+
+static void countingFree(void* ptr) {
+    if (ptr) AllocStats::recordFree();
+    previousFree(ptr);
+}
+
+static void* countingCalloc(size_t count, size_t size) {
+    AllocStats::recordAlloc(count * size);
+    return previousCalloc(count, size);
+}
+
+static void* countingRealloc(void* ptr, size_t size) {
+    // realloc учитываем как новое выделение и освобождение старого блока
+    if (ptr) AllocStats::recordFree();
+    AllocStats::recordAlloc(size);
+    return previousRealloc(ptr, size);
+}
+
+bool AllocStats::tracksLibraryAllocations() { return true; }
+
+void AllocStats::install() {
+    if (previousMalloc) return;
+    previousMalloc = UA_mallocSingleton;
+    previousFree = UA_freeSingleton;
+    previousCalloc = UA_callocSingleton;
+    previousRealloc = UA_reallocSingleton;
+    UA_mallocSingleton = countingMalloc;
+    UA_freeSingleton = countingFree;
+    UA_callocSingleton = countingCalloc;
+    UA_reallocSingleton = countingRealloc;
+}
+
+#elif defined(ALLOC_STATS_WRAP_MALLOC)
+
+extern "C" {
+void* __real_malloc(size_t size);
+void __real_free(void* ptr);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+void* __wrap_malloc(size_t size) {
+    AllocStats::recordAlloc(size);
+    return __real_malloc(size);
+}
+
+void __wrap_free(void* ptr) {
+    if (ptr) AllocStats::recordFree();
+    __real_free(ptr);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+    AllocStats::recordAlloc(count * size);
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+    if (ptr) AllocStats::recordFree();
+    AllocStats::recordAlloc(size);
+    return __real_realloc(ptr, size);
+}
+}
+
+bool AllocStats::tracksLibraryAllocations() { return true; }
+void AllocStats::install() {}
+
+#else
+
+bool AllocStats::tracksLibraryAllocations() { return false; }
+void AllocStats::install() {}
+
+#endif
+
+// ============================== ГЛОБАЛЬНЫЕ operator new / delete ==============================
+// При ALLOC_STATS_WRAP_MALLOC вызов malloc отсюда уже проходит через __wrap_malloc,
+// поэтому повторно не считаем.
+#if defined(ALLOC_STATS_WRAP_MALLOC) && !defined(UA_ENABLE_MALLOC_SINGLETON)
+static inline void countNew(size_t) {}
+static inline void countDelete() {}
+#else
+static inline void countNew(size_t size) { AllocStats::recordAlloc(size); }
+static inline void countDelete() { AllocStats::recordFree(); }
+#endif
+
+void* operator new(size_t size) {
+    countNew(size);
+    if (void* ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    countNew(size);
+    return std::malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return operator new(size, std::nothrow);
+}
+
+void operator delete(void* ptr) noexcept {
+    if (!ptr) return;
+    countDelete();
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    operator delete(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    operator delete(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+    operator delete(ptr);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+// ============================== СЧЕТЧИКИ ВЫДЕЛЕНИЙ ПАМЯТИ ==============================
+// Реализация в alloc_stats.cpp: заменяет глобальные operator new/delete и, если
+// это возможно, перехватывает malloc/free библиотеки open62541:
+//  - UA_ENABLE_MALLOC_SINGLETON: через UA_mallocSingleton и т.п.;
+//  - ALLOC_STATS_WRAP_MALLOC (Linux): через -Wl,--wrap=malloc,... при статической
+//    линковке open62541.
+// Без этого учитываются только выделения через operator new.
+struct AllocSnapshot {
+    uint64_t allocations = 0;
+    uint64_t deallocations = 0;
+    uint64_t bytes = 0;
+
+    AllocSnapshot operator-(const AllocSnapshot& other) const {
+        AllocSnapshot d;
+        d.allocations = allocations - other.allocations;
+        d.deallocations = deallocations - other.deallocations;
+        d.bytes = bytes - other.bytes;
+        return d;
+    }
+};
+
+class AllocStats {
+public:
+    static std::atomic<uint64_t> allocations;
+    static std::atomic<uint64_t> deallocations;
+    static std::atomic<uint64_t> bytes;
+
+    static void recordAlloc(size_t size) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        bytes.fetch_add(size, std::memory_order_relaxed);
+    }
+
+    static void recordFree() {
+        deallocations.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static AllocSnapshot snapshot() {
+        AllocSnapshot s;
+        s.allocations = allocations.load(std::memory_order_relaxed);
+        s.deallocations = deallocations.load(std::memory_order_relaxed);
+        s.bytes = bytes.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    // Учитываются ли выделения внутри open62541
+    static bool tracksLibraryAllocations();
+
+    // Подключает счетчики к open62541 (нужно для UA_ENABLE_MALLOC_SINGLETON)
+    static void install();
+};
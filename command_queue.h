@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// ============================== ОЧЕРЕДЬ КОМАНД ==============================
+// Ограниченная очередь без блокировок: много писателей (сервисы Write) и один
+// читатель (цикл симуляции), который забирает команды пакетами на границе такта.
+// Каждая ячейка несет номер последовательности, по которому писатель видит, что
+// ячейка свободна, а читатель - что она заполнена (схема Д. Вьюкова).
+//
+// Счетчики enqueuedCount()/appliedCount() монотонны: команда, принятая до
+// чтения enqueuedCount() = N, выполнена, когда appliedCount() >= N.
+template<typename T>
+class CommandQueue {
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask;
+    alignas(64) std::atomic<size_t> enqueuePos;
+    alignas(64) std::atomic<size_t> dequeuePos;
+    alignas(64) std::atomic<uint64_t> applied;
+
+public:
+    // capacity - степень двойки
+    explicit CommandQueue(size_t capacity)
+        : cells(new Cell[capacity]), mask(capacity - 1), enqueuePos(0), dequeuePos(0), applied(0) {
+        for (size_t i = 0; i < capacity; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    CommandQueue(const CommandQueue&) = delete;
+    CommandQueue& operator=(const CommandQueue&) = delete;
+
+    size_t capacity() const { return mask + 1; }
+
+    // false, если очередь заполнена
+    bool push(const T& item) {
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells[pos & mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->data = item;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Только читатель: выполняет fn для накопленных команд (не больше емкости
+    // очереди за вызов, чтобы непрерывный поток записей не задерживал такт)
+    template<typename Fn>
+    size_t drain(Fn fn) {
+        size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        size_t count = 0;
+        while (count <= mask) {
+            Cell& cell = cells[pos & mask];
+            if (cell.sequence.load(std::memory_order_acquire) != pos + 1) {
+                break;
+            }
+            T item = cell.data;
+            cell.sequence.store(pos + mask + 1, std::memory_order_release);
+            ++pos;
+            ++count;
+            fn(item);
+        }
+        dequeuePos.store(pos, std::memory_order_relaxed);
+        if (count > 0) {
+            applied.fetch_add(count, std::memory_order_release);
+        }
+        return count;
+    }
+
+    uint64_t enqueuedCount() const { return enqueuePos.load(std::memory_order_acquire); }
+    uint64_t appliedCount() const { return applied.load(std::memory_order_acquire); }
+};
+
+// ============================== КОМАНДА УСТАВКИ ==============================
+// Получатель - переменная-уставка (OPCUASetpointVariable); значение применяется
+// в потоке симуляции.
+class SetpointTarget {
+public:
+    virtual void applySetpoint(double value) = 0;
+
+protected:
+    ~SetpointTarget() = default;
+};
+
+struct SetpointCommand {
+    SetpointTarget* target;
+    double value;
+};
+
+using SetpointQueue = CommandQueue<SetpointCommand>;
@@ -0,0 +1,341 @@
+#include <open62541/types.h>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <random>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+
+#include "dashboard_stream.h"
+
+#ifdef __linux__
+#include <sys/resource.h>
+#endif
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// ============================== ПАРАМЕТРЫ ==============================
+// Рассылка DashboardStream сотням зрителей на loopback: каждый зритель - настоящее
+// WebSocket-соединение, кадры читает отдельный поток. Для каждого числа зрителей
+// измеряется стоимость publish() в потоке симуляции (должна быть постоянной),
+// время рассылки на такт и на зрителя и задержка доставки кадра последнему зрителю.
+struct DashboardBenchOptions {
+    std::vector<int> viewers = {1, 10, 100, 200, 400};
+    int ticks = 500;
+    double tickUs = 2000.0;
+    size_t values = 18;        // как у Multimeter + Machine + Computer
+    double changeRatio = 0.3;  // доля значений, меняющихся за такт
+    std::string csvPath;
+};
+
+struct DashboardBenchResult {
+    int viewers = 0;
+    int connected = 0;
+    double encodeUsPerTick = 0.0;
+    double fanoutUsPerTick = 0.0;
+    double fanoutUsPerViewer = 0.0;
+    double deliveryP50Us = 0.0;
+    double deliveryP99Us = 0.0;
+    double bytesPerTick = 0.0;
+    uint64_t resyncs = 0;
+};
+
+// ============================== ЗРИТЕЛИ ==============================
+using Clock = std::chrono::steady_clock;
+
+struct ViewerConnection {
+    DashboardSocket::Handle socket = DashboardSocket::INVALID;
+    std::string inbound;
+};
+
+static bool openViewer(uint16_t port, ViewerConnection& viewer) {
+    viewer.socket = DashboardSocket::connectTo("127.0.0.1", port);
+    if (viewer.socket == DashboardSocket::INVALID) {
+        return false;
+    }
+    const std::string request =
+        "GET /stream HTTP/1.1\r\nHost: localhost\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+        "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n";
+    if (DashboardSocket::send(viewer.socket, request.data(), request.size()) !=
+        static_cast<long>(request.size())) {
+        return false;
+    }
+
+    // Ответ читается блокирующе; данные после заголовков остаются в inbound
+    char buffer[1024];
+    while (viewer.inbound.find("\r\n\r\n") == std::string::npos) {
+        long received = DashboardSocket::recv(viewer.socket, buffer, sizeof(buffer));
+        if (received <= 0) {
+            return false;
+        }
+        viewer.inbound.append(buffer, static_cast<size_t>(received));
+    }
+    size_t end = viewer.inbound.find("\r\n\r\n");
+    bool upgraded = viewer.inbound.compare(0, 12, "HTTP/1.1 101") == 0 &&
+                    viewer.inbound.find("Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=") < end;
+    viewer.inbound.erase(0, end + 4);
+    DashboardSocket::setNonBlocking(viewer.socket);
+    return upgraded;
+}
+
+// Номер такта из заголовка кадра: {"type":"...","tick":N,...}
+static long frameTick(const std::string& payload) {
+    size_t pos = payload.find("\"tick\":");
+    return pos == std::string::npos ? -1 : std::atol(payload.c_str() + pos + 7);
+}
+
+// Разбирает кадры сервера (без маски) и отмечает время получения такта
+static void consumeFrames(ViewerConnection& viewer, std::vector<std::atomic<int>>& received,
+                          std::vector<int64_t>& lastReceiveNs, Clock::time_point origin) {
+    std::string& in = viewer.inbound;
+    size_t offset = 0;
+    for (;;) {
+        if (in.size() - offset < 2) break;
+        uint64_t length = static_cast<uint8_t>(in[offset + 1]) & 0x7F;
+        size_t header = 2;
+        if (length == 126) {
+            if (in.size() - offset < 4) break;
+            length = (uint64_t(uint8_t(in[offset + 2])) << 8) | uint8_t(in[offset + 3]);
+            header = 4;
+        } else if (length == 127) {
+            if (in.size() - offset < 10) break;
+            length = 0;
+            for (int i = 0; i < 8; ++i) length = (length << 8) | uint8_t(in[offset + 2 + i]);
+            header = 10;
+        }
+        if (in.size() - offset < header + length) break;
+
+        long tick = frameTick(in.substr(offset + header, std::min<size_t>(static_cast<size_t>(length), 64)));
+        if (tick >= 0 && static_cast<size_t>(tick) < received.size()) {
+            int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - origin).count();
+            lastReceiveNs[tick] = std::max(lastReceiveNs[tick], now);
+            received[tick].fetch_add(1, std::memory_order_release);
+        }
+        offset += header + static_cast<size_t>(length);
+    }
+    in.erase(0, offset);
+}
+
+// ============================== ОДИН ПРОГОН ==============================
+static DashboardBenchResult runViewers(const DashboardBenchOptions& options, int viewerCount) {
+    DashboardBenchResult result;
+    result.viewers = viewerCount;
+
+    ValueStore store;
+    DashboardStream stream(0, 1024);
+    std::vector<ValueStore::Slot> slots;
+    for (size_t i = 0; i < options.values; ++i) {
+        double initial = 0.0;
+        slots.push_back(store.allocate(UA_NODEID_NUMERIC(1, static_cast<UA_UInt32>(1000 + i)),
+                                       &UA_TYPES[UA_TYPES_DOUBLE], &initial));
+        stream.track("Bench.Value" + std::to_string(i), &store, slots.back());
+    }
+    if (!stream.start()) {
+        return result;
+    }
+
+    std::vector<ViewerConnection> viewers(viewerCount);
+    for (auto& viewer : viewers) {
+        if (openViewer(stream.getPort(), viewer)) {
+            ++result.connected;
+        } else if (viewer.socket != DashboardSocket::INVALID) {
+            DashboardSocket::close(viewer.socket);
+            viewer.socket = DashboardSocket::INVALID;
+        }
+    }
+
+    // Такт 0 - снимок для всех подключившихся
+    std::vector<std::atomic<int>> received(options.ticks + 1);
+    std::vector<int64_t> lastReceiveNs(options.ticks + 1, 0);
+    std::vector<int64_t> publishNs(options.ticks + 1, 0);
+    const auto origin = Clock::now();
+    std::atomic<bool> stop(false);
+
+    std::thread reader([&]() {
+        std::vector<pollfd> fds;
+        for (auto& viewer : viewers) {
+            if (viewer.socket != DashboardSocket::INVALID) fds.push_back({viewer.socket, POLLIN, 0});
+        }
+        std::vector<ViewerConnection*> owners;
+        for (auto& viewer : viewers) {
+            if (viewer.socket != DashboardSocket::INVALID) owners.push_back(&viewer);
+        }
+        char buffer[16384];
+        while (!stop) {
+            if (DashboardSocket::poll(fds.data(), fds.size(), 10) <= 0) continue;
+            for (size_t i = 0; i < fds.size(); ++i) {
+                if (!(fds[i].revents & POLLIN)) continue;
+                long n;
+                while ((n = DashboardSocket::recv(owners[i]->socket, buffer, sizeof(buffer))) > 0) {
+                    owners[i]->inbound.append(buffer, static_cast<size_t>(n));
+                }
+                consumeFrames(*owners[i], received, lastReceiveNs, origin);
+            }
+        }
+    });
+
+    auto waitForTick = [&](int tick, double timeoutSec) {
+        auto deadline = Clock::now() + std::chrono::duration<double>(timeoutSec);
+        while (received[tick].load(std::memory_order_acquire) < result.connected && Clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    };
+
+    // Зрители ждут снимка; publish(0) строит его, как только все рукопожатия обработаны
+    for (int attempt = 0; attempt < 500 && stream.stats().viewers < static_cast<uint64_t>(result.connected);
+         ++attempt) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    stream.publish(0);
+    waitForTick(0, 5.0);
+
+    DashboardStats before = stream.stats();
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::micro>(options.tickUs));
+    auto next = Clock::now();
+    for (int tick = 1; tick <= options.ticks; ++tick) {
+        for (size_t i = 0; i < slots.size(); ++i) {
+            // Хотя бы одно значение меняется в каждом такте
+            if (i == static_cast<size_t>(tick) % slots.size() || unit(rng) < options.changeRatio) {
+                store.writeAs<double>(slots[i], unit(rng) * 1000.0);
+            }
+        }
+        publishNs[tick] = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - origin).count();
+        stream.publish(static_cast<uint64_t>(tick));
+        next += period;
+        std::this_thread::sleep_until(next);
+    }
+    waitForTick(options.ticks, 5.0);
+    DashboardStats after = stream.stats();
+
+    stop = true;
+    reader.join();
+    for (auto& viewer : viewers) {
+        if (viewer.socket != DashboardSocket::INVALID) DashboardSocket::close(viewer.socket);
+    }
+    stream.stop();
+
+    std::vector<double> deliveryUs;
+    for (int tick = 1; tick <= options.ticks; ++tick) {
+        if (result.connected > 0 && received[tick].load() >= result.connected) {
+            deliveryUs.push_back((lastReceiveNs[tick] - publishNs[tick]) / 1000.0);
+        }
+    }
+    std::sort(deliveryUs.begin(), deliveryUs.end());
+    auto percentile = [&](double p) {
+        if (deliveryUs.empty()) return 0.0;
+        return deliveryUs[static_cast<size_t>(p / 100.0 * (deliveryUs.size() - 1) + 0.5)];
+    };
+
+    uint64_t frames = (after.deltas - before.deltas) + (after.snapshots - before.snapshots);
+    result.encodeUsPerTick = (after.encodeNs - before.encodeNs) / 1000.0 / options.ticks;
+    result.fanoutUsPerTick = frames ? (after.fanoutNs - before.fanoutNs) / 1000.0 / frames : 0.0;
+    result.fanoutUsPerViewer = result.connected ? result.fanoutUsPerTick / result.connected : 0.0;
+    result.deliveryP50Us = percentile(50.0);
+    result.deliveryP99Us = percentile(99.0);
+    result.bytesPerTick = static_cast<double>(after.bytesSent - before.bytesSent) / options.ticks;
+    result.resyncs = after.resyncs - before.resyncs;
+    return result;
+}
+
+// ============================== ТОЧКА ВХОДА ==============================
+static void printUsage() {
+    std::cout << "Usage: server_dashboard_bench [--viewers 1,10,100,200,400] [--ticks <n>] [--tick-us <us>]\n"
+                 "                              [--values <n>] [--change-ratio <0..1>] [--csv <file>]"
+              << std::endl;
+}
+
+static bool parseList(const std::string& text, std::vector<int>& values) {
+    values.clear();
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        int n = std::atoi(item.c_str());
+        if (n <= 0) return false;
+        values.push_back(n);
+    }
+    return !values.empty();
+}
+
+int main(int argc, char** argv) {
+#ifdef _WIN32
+    SetConsoleOutputCP(CP_UTF8);
+#endif
+
+    DashboardBenchOptions options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--viewers" && hasValue) {
+            if (!parseList(argv[++i], options.viewers)) {
+                std::cerr << "Неверный формат --viewers" << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--ticks" && hasValue) options.ticks = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--tick-us" && hasValue) options.tickUs = std::max(10.0, std::atof(argv[++i]));
+        else if (arg == "--values" && hasValue) options.values = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--change-ratio" && hasValue) options.changeRatio = std::atof(argv[++i]);
+        else if (arg == "--csv" && hasValue) options.csvPath = argv[++i];
+        else {
+            printUsage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+#ifdef __linux__
+    // Зритель - два дескриптора (клиент и сервер)
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+#endif
+#ifdef _WIN32
+    WSADATA wsaData;
+    WSAStartup(MAKEWORD(2, 2), &wsaData);
+#endif
+
+    std::cout << "Значений: " << options.values << ", тактов: " << options.ticks << " по "
+              << options.tickUs << " мкс, меняется за такт: " << options.changeRatio * 100.0 << "%\n" << std::endl;
+    std::cout << std::right << std::setw(8) << "viewers" << std::setw(11) << "connected"
+              << std::setw(14) << "encode us" << std::setw(14) << "fanout us" << std::setw(16) << "us/viewer"
+              << std::setw(14) << "p50 us" << std::setw(14) << "p99 us" << std::setw(14) << "bytes/tick"
+              << std::setw(9) << "resync" << std::endl;
+
+    std::vector<DashboardBenchResult> results;
+    for (int count : options.viewers) {
+        DashboardBenchResult r = runViewers(options, count);
+        results.push_back(r);
+        std::cout << std::setw(8) << r.viewers << std::setw(11) << r.connected << std::fixed << std::setprecision(2)
+                  << std::setw(14) << r.encodeUsPerTick << std::setw(14) << r.fanoutUsPerTick
+                  << std::setw(16) << r.fanoutUsPerViewer << std::setprecision(1)
+                  << std::setw(14) << r.deliveryP50Us << std::setw(14) << r.deliveryP99Us
+                  << std::setw(14) << r.bytesPerTick << std::setw(9) << r.resyncs << std::endl;
+    }
+
+    if (!options.csvPath.empty()) {
+        std::ofstream csv(options.csvPath);
+        csv << "viewers,connected,encode_us_per_tick,fanout_us_per_tick,fanout_us_per_viewer,"
+               "delivery_p50_us,delivery_p99_us,bytes_per_tick,resyncs\n";
+        for (const auto& r : results) {
+            csv << r.viewers << ',' << r.connected << ',' << r.encodeUsPerTick << ',' << r.fanoutUsPerTick << ','
+                << r.fanoutUsPerViewer << ',' << r.deliveryP50Us << ',' << r.deliveryP99Us << ','
+                << r.bytesPerTick << ',' << r.resyncs << '\n';
+        }
+    }
+
+    bool allConnected = std::all_of(results.begin(), results.end(),
+                                    [](const DashboardBenchResult& r) { return r.connected == r.viewers; });
+    return allConnected ? 0 : 1;
+}
@@ -0,0 +1,830 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include "opcua_nodes.h"
+#include "trace.h"
+
+// ============================== СОКЕТЫ ==============================
+// Минимальная прослойка над BSD sockets / Winsock: неблокирующие сокеты и poll.
+class DashboardSocket {
+public:
+#ifdef _WIN32
+    using Handle = SOCKET;
+    static constexpr Handle INVALID = INVALID_SOCKET;
+    static void close(Handle s) { closesocket(s); }
+    static int poll(pollfd* fds, size_t count, int timeoutMs) {
+        return WSAPoll(fds, static_cast<ULONG>(count), timeoutMs);
+    }
+    static bool setNonBlocking(Handle s) {
+        u_long mode = 1;
+        return ioctlsocket(s, FIONBIO, &mode) == 0;
+    }
+    static bool wouldBlock() { return WSAGetLastError() == WSAEWOULDBLOCK; }
+    static long send(Handle s, const char* data, size_t length) {
+        return ::send(s, data, static_cast<int>(length), 0);
+    }
+    static long recv(Handle s, char* data, size_t length) {
+        return ::recv(s, data, static_cast<int>(length), 0);
+    }
+#else
+    using Handle = int;
+    static constexpr Handle INVALID = -1;
+    static void close(Handle s) { ::close(s); }
+    static int poll(pollfd* fds, size_t count, int timeoutMs) {
+        return ::poll(fds, static_cast<nfds_t>(count), timeoutMs);
+    }
+    static bool setNonBlocking(Handle s) {
+        int flags = fcntl(s, F_GETFL, 0);
+        return flags >= 0 && fcntl(s, F_SETFL, flags | O_NONBLOCK) == 0;
+    }
+    static bool wouldBlock() { return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR; }
+    static long send(Handle s, const char* data, size_t length) {
+#ifdef MSG_NOSIGNAL
+        return ::send(s, data, length, MSG_NOSIGNAL);
+#else
+        return ::send(s, data, length, 0);
+#endif
+    }
+    static long recv(Handle s, char* data, size_t length) {
+        return ::recv(s, data, length, 0);
+    }
+#endif
+
+    // Слушающий сокет на порту (0 - любой свободный); INVALID при ошибке
+    static Handle listenOn(const char* address, uint16_t port) {
+        Handle s = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (s == INVALID) {
+            return INVALID;
+        }
+        int reuse = 1;
+        setsockopt(s, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+
+        sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        inet_pton(AF_INET, address, &addr.sin_addr);
+        if (bind(s, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(s, 128) != 0 ||
+            !setNonBlocking(s)) {
+            close(s);
+            return INVALID;
+        }
+        return s;
+    }
+
+    static uint16_t localPort(Handle s) {
+        sockaddr_in addr;
+        socklen_t length = sizeof(addr);
+        if (getsockname(s, reinterpret_cast<sockaddr*>(&addr), &length) != 0) {
+            return 0;
+        }
+        return ntohs(addr.sin_port);
+    }
+
+    static Handle connectTo(const char* address, uint16_t port) {
+        Handle s = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (s == INVALID) {
+            return INVALID;
+        }
+        sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        inet_pton(AF_INET, address, &addr.sin_addr);
+        if (::connect(s, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            close(s);
+            return INVALID;
+        }
+        int noDelay = 1;
+        setsockopt(s, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+        return s;
+    }
+};
+
+// ============================== РУКОПОЖАТИЕ WEBSOCKET ==============================
+// Sec-WebSocket-Accept = base64(SHA-1(key + GUID)), RFC 6455
+inline std::string sha1Digest(const std::string& data) {
+    auto rotl = [](uint32_t x, int n) { return (x << n) | (x >> (32 - n)); };
+    uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+
+    std::string message = data;
+    uint64_t bitLength = static_cast<uint64_t>(data.size()) * 8;
+    message.push_back(static_cast<char>(0x80));
+    while (message.size() % 64 != 56) {
+        message.push_back(0);
+    }
+    for (int i = 7; i >= 0; --i) {
+        message.push_back(static_cast<char>(bitLength >> (i * 8)));
+    }
+
+    for (size_t chunk = 0; chunk < message.size(); chunk += 64) {
+        uint32_t w[80];
+        for (int i = 0; i < 16; ++i) {
+            const unsigned char* p = reinterpret_cast<const unsigned char*>(message.data() + chunk + i * 4);
+            w[i] = (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+        }
+        for (int i = 16; i < 80; ++i) {
+            w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+        }
+
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (int i = 0; i < 80; ++i) {
+            uint32_t f, k;
+            if (i < 20)      { f = (b & c) | (~b & d);           k = 0x5A827999; }
+            else if (i < 40) { f = b ^ c ^ d;                    k = 0x6ED9EBA1; }
+            else if (i < 60) { f = (b & c) | (b & d) | (c & d);  k = 0x8F1BBCDC; }
+            else             { f = b ^ c ^ d;                    k = 0xCA62C1D6; }
+            uint32_t temp = rotl(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = rotl(b, 30);
+            b = a;
+            a = temp;
+        }
+        h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+    }
+
+    std::string digest(20, '\0');
+    for (int i = 0; i < 5; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            digest[i * 4 + j] = static_cast<char>(h[i] >> (24 - j * 8));
+        }
+    }
+    return digest;
+}
+
+inline std::string base64Encode(const std::string& data) {
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    size_t i = 0;
+    for (; i + 2 < data.size(); i += 3) {
+        uint32_t n = (uint32_t(uint8_t(data[i])) << 16) | (uint32_t(uint8_t(data[i + 1])) << 8) |
+                     uint32_t(uint8_t(data[i + 2]));
+        out += alphabet[(n >> 18) & 63];
+        out += alphabet[(n >> 12) & 63];
+        out += alphabet[(n >> 6) & 63];
+        out += alphabet[n & 63];
+    }
+    if (i < data.size()) {
+        uint32_t n = uint32_t(uint8_t(data[i])) << 16;
+        if (i + 1 < data.size()) n |= uint32_t(uint8_t(data[i + 1])) << 8;
+        out += alphabet[(n >> 18) & 63];
+        out += alphabet[(n >> 12) & 63];
+        out += i + 1 < data.size() ? alphabet[(n >> 6) & 63] : '=';
+        out += '=';
+    }
+    return out;
+}
+
+inline std::string webSocketAccept(const std::string& key) {
+    return base64Encode(sha1Digest(key + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"));
+}
+
+// Кадр сервера (без маски) целиком: заголовок + данные
+inline std::string webSocketFrame(uint8_t opcode, const std::string& payload) {
+    std::string frame;
+    frame.reserve(payload.size() + 10);
+    frame.push_back(static_cast<char>(0x80 | opcode));
+    if (payload.size() < 126) {
+        frame.push_back(static_cast<char>(payload.size()));
+    } else if (payload.size() <= 0xFFFF) {
+        frame.push_back(126);
+        frame.push_back(static_cast<char>(payload.size() >> 8));
+        frame.push_back(static_cast<char>(payload.size()));
+    } else {
+        frame.push_back(127);
+        for (int i = 7; i >= 0; --i) {
+            frame.push_back(static_cast<char>(static_cast<uint64_t>(payload.size()) >> (i * 8)));
+        }
+    }
+    frame += payload;
+    return frame;
+}
+
+// ============================== ПОТОК ЗНАЧЕНИЙ ДЛЯ ПАНЕЛЕЙ ==============================
+// Встроенная точка HTTP/WebSocket для простых веб-панелей вместо опроса шлюза OPC UA.
+//   GET /        - страница с таблицей значений
+//   GET /stream  - WebSocket, текстовые кадры JSON:
+//     {"type":"snapshot","tick":N,"names":["Multimeter.Voltage",...],"values":[...]}
+//     {"type":"delta","tick":N,"changes":[[index,value],...]}
+// Снимок приходит при подключении, затем только изменившиеся за такт значения
+// (индексы - позиции в names).
+//
+// publish() вызывается потоком симуляции раз за такт: изменения сериализуются
+// один раз в готовый кадр, который собственный поток рассылки отправляет всем
+// зрителям одним и тем же буфером - стоимость такта для симуляции не зависит от
+// числа зрителей. Снимок строится в том же такте, только если его ждет хотя бы
+// один зритель (новый или отставший). Зритель, у которого в очереди больше
+// maxQueuedFrames кадров, теряет очередь и получает следующий снимок. После
+// смены набора значений (untrackAll и новые track между тактами) снимок с
+// новыми names получают все зрители.
+struct DashboardStats {
+    uint64_t viewers = 0;
+    uint64_t deltas = 0;           // сериализованных кадров изменений
+    uint64_t snapshots = 0;
+    uint64_t encodeNs = 0;         // время publish() в потоке симуляции
+    uint64_t fanoutNs = 0;         // время рассылки в потоке зрителей
+    uint64_t frameSends = 0;       // кадров, поставленных зрителям
+    uint64_t bytesSent = 0;
+    uint64_t resyncs = 0;          // отставшие зрители, переведенные на снимок
+};
+
+class DashboardStream {
+private:
+    using Socket = DashboardSocket;
+    using Clock = std::chrono::steady_clock;
+
+    struct Frame {
+        bool snapshot;
+        bool reset;    // снимок для всех зрителей: сменился набор значений
+        std::shared_ptr<const std::string> bytes;
+    };
+
+    struct Viewer {
+        enum State { HANDSHAKE, WAITING_SNAPSHOT, STREAMING };
+
+        Socket::Handle socket;
+        State state = HANDSHAKE;
+        std::string inbound;
+        std::deque<std::shared_ptr<const std::string>> outbound;
+        size_t outboundOffset = 0;
+        bool closeWhenFlushed = false;
+        bool closed = false;
+    };
+
+    static constexpr size_t MAX_INBOUND = 16 * 1024;
+
+    // Отслеживаемые значения (меняются только в потоке симуляции)
+    std::vector<std::string> names;
+    std::vector<std::pair<const ValueStore*, ValueStore::Slot>> sources;
+    std::vector<double> published; // состояние после последнего кадра
+    bool havePublished = false;
+    bool layoutChanged = false;
+
+    uint16_t port;
+    size_t maxQueuedFrames;
+    Socket::Handle listener = Socket::INVALID;
+    Socket::Handle wakeReader = Socket::INVALID;
+    Socket::Handle wakeWriter = Socket::INVALID;
+    std::thread thread;
+    std::atomic<bool> running{false};
+    std::atomic<bool> snapshotRequested{false};
+
+    std::mutex pendingLock;
+    std::vector<Frame> pending;
+
+    std::vector<std::unique_ptr<Viewer>> viewers;
+
+    std::atomic<uint64_t> viewerCount{0};
+    std::atomic<uint64_t> deltaCount{0};
+    std::atomic<uint64_t> snapshotCount{0};
+    std::atomic<uint64_t> encodeNs{0};
+    std::atomic<uint64_t> fanoutNs{0};
+    std::atomic<uint64_t> frameSends{0};
+    std::atomic<uint64_t> bytesSent{0};
+    std::atomic<uint64_t> resyncCount{0};
+
+public:
+    explicit DashboardStream(uint16_t listenPort, size_t maxQueued = 64)
+        : port(listenPort), maxQueuedFrames(maxQueued) {}
+
+    ~DashboardStream() {
+        stop();
+    }
+
+    DashboardStream(const DashboardStream&) = delete;
+    DashboardStream& operator=(const DashboardStream&) = delete;
+
+    // ---------- набор значений (до start или в потоке симуляции между тактами) ----------
+
+    void track(const std::string& name, const ValueStore* store, ValueStore::Slot slot) {
+        names.push_back(name);
+        sources.emplace_back(store, slot);
+    }
+
+    // Все числовые скаляры устройства под именами "<Устройство>.<Переменная>"
+    void trackDevice(const OPCUADevice& device) {
+        device.forEachVariable([&](const OPCUAVariableBase& variable) {
+            double probe;
+            if (variable.getStore()->readNumeric(variable.getSlot(), probe)) {
+                track(device.getBrowseName() + "." + variable.getBrowseName(), variable.getStore(),
+                      variable.getSlot());
+            }
+        });
+    }
+
+    // Забывает все значения; следующий publish() разошлет снимок всем зрителям.
+    // Вызывать до освобождения слотов, на которые ссылаются sources
+    void untrackAll() {
+        names.clear();
+        sources.clear();
+        published.clear();
+        havePublished = false;
+        layoutChanged = true;
+    }
+
+    bool start() {
+#ifdef _WIN32
+        WSADATA wsaData;
+        WSAStartup(MAKEWORD(2, 2), &wsaData);
+#endif
+        listener = Socket::listenOn("0.0.0.0", port);
+        if (listener == Socket::INVALID) {
+            std::cerr << "Dashboard: не удалось открыть порт " << port << std::endl;
+            return false;
+        }
+        port = Socket::localPort(listener);
+
+        // Канал пробуждения потока рассылки (пара сокетов на loopback: WSAPoll
+        // работает только с сокетами)
+        Socket::Handle wakeListener = Socket::listenOn("127.0.0.1", 0);
+        if (wakeListener != Socket::INVALID) {
+            wakeWriter = Socket::connectTo("127.0.0.1", Socket::localPort(wakeListener));
+            for (int attempt = 0; attempt < 100 && wakeReader == Socket::INVALID; ++attempt) {
+                wakeReader = ::accept(wakeListener, nullptr, nullptr);
+                if (wakeReader == Socket::INVALID) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            }
+            Socket::close(wakeListener);
+        }
+        if (wakeReader == Socket::INVALID || wakeWriter == Socket::INVALID) {
+            std::cerr << "Dashboard: не удалось создать канал пробуждения" << std::endl;
+            stop();
+            return false;
+        }
+        Socket::setNonBlocking(wakeReader);
+        Socket::setNonBlocking(wakeWriter);
+
+        running = true;
+        thread = std::thread([this]() { serve(); });
+        return true;
+    }
+
+    void stop() {
+        if (running.exchange(false)) {
+            wake();
+            thread.join();
+        }
+        for (auto& viewer : viewers) {
+            Socket::close(viewer->socket);
+        }
+        viewers.clear();
+        for (Socket::Handle* s : {&listener, &wakeReader, &wakeWriter}) {
+            if (*s != Socket::INVALID) {
+                Socket::close(*s);
+                *s = Socket::INVALID;
+            }
+        }
+    }
+
+    uint16_t getPort() const { return port; }
+    const std::vector<std::string>& getNames() const { return names; }
+
+    DashboardStats stats() const {
+        DashboardStats s;
+        s.viewers = viewerCount.load(std::memory_order_relaxed);
+        s.deltas = deltaCount.load(std::memory_order_relaxed);
+        s.snapshots = snapshotCount.load(std::memory_order_relaxed);
+        s.encodeNs = encodeNs.load(std::memory_order_relaxed);
+        s.fanoutNs = fanoutNs.load(std::memory_order_relaxed);
+        s.frameSends = frameSends.load(std::memory_order_relaxed);
+        s.bytesSent = bytesSent.load(std::memory_order_relaxed);
+        s.resyncs = resyncCount.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    // ---------- поток симуляции ----------
+
+    // Раз за такт, после обновления устройств
+    void publish(uint64_t tick) {
+        TRACE_SPAN("dashboard");
+        auto started = Clock::now();
+
+        std::vector<double> current(sources.size());
+        for (size_t i = 0; i < sources.size(); ++i) {
+            if (!sources[i].first->readNumeric(sources[i].second, current[i])) {
+                current[i] = NAN;
+            }
+        }
+
+        std::vector<Frame> frames;
+        if (havePublished) {
+            std::string changes;
+            for (size_t i = 0; i < current.size(); ++i) {
+                // Побитовое сравнение: NaN -> NaN не считается изменением
+                if (std::memcmp(&current[i], &published[i], sizeof(double)) != 0) {
+                    if (!changes.empty()) changes += ',';
+                    changes += '[';
+                    changes += std::to_string(i);
+                    changes += ',';
+                    appendNumber(changes, current[i]);
+                    changes += ']';
+                }
+            }
+            if (!changes.empty()) {
+                std::string json = "{\"type\":\"delta\",\"tick\":" + std::to_string(tick) +
+                                   ",\"changes\":[" + changes + "]}";
+                frames.push_back({false, false, std::make_shared<const std::string>(webSocketFrame(0x1, json))});
+                deltaCount.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        published.swap(current);
+        havePublished = true;
+        if (!running.load(std::memory_order_relaxed)) {
+            return; // рассылка не запущена - только состояние
+        }
+
+        bool reset = layoutChanged;
+        layoutChanged = false;
+        if (snapshotRequested.exchange(false, std::memory_order_acq_rel) || reset) {
+            frames.push_back({true, reset, std::make_shared<const std::string>(webSocketFrame(0x1, snapshotJson(tick)))});
+            snapshotCount.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        if (!frames.empty()) {
+            {
+                std::lock_guard<std::mutex> guard(pendingLock);
+                for (auto& frame : frames) {
+                    pending.push_back(std::move(frame));
+                }
+            }
+            wake();
+        }
+        encodeNs.fetch_add(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - started).count()),
+            std::memory_order_relaxed);
+    }
+
+private:
+    static void appendNumber(std::string& out, double value) {
+        if (!std::isfinite(value)) {
+            out += "null";
+            return;
+        }
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+        out += buffer;
+    }
+
+    std::string snapshotJson(uint64_t tick) const {
+        std::string json = "{\"type\":\"snapshot\",\"tick\":" + std::to_string(tick) + ",\"names\":[";
+        for (size_t i = 0; i < names.size(); ++i) {
+            if (i > 0) json += ',';
+            json += '"';
+            for (char c : names[i]) {
+                if (c == '"' || c == '\\') json += '\\';
+                json += c;
+            }
+            json += '"';
+        }
+        json += "],\"values\":[";
+        for (size_t i = 0; i < published.size(); ++i) {
+            if (i > 0) json += ',';
+            appendNumber(json, published[i]);
+        }
+        json += "]}";
+        return json;
+    }
+
+    void wake() {
+        char byte = 1;
+        if (wakeWriter != Socket::INVALID) {
+            Socket::send(wakeWriter, &byte, 1); // переполнение канала не страшно: поток уже разбужен
+        }
+    }
+
+    // ---------- поток рассылки ----------
+
+    void serve() {
+        std::vector<pollfd> fds;
+        while (running) {
+            fds.clear();
+            fds.push_back({listener, POLLIN, 0});
+            fds.push_back({wakeReader, POLLIN, 0});
+            for (auto& viewer : viewers) {
+                short events = POLLIN;
+                if (!viewer->outbound.empty()) events |= POLLOUT;
+                fds.push_back({viewer->socket, events, 0});
+            }
+
+            if (Socket::poll(fds.data(), fds.size(), 100) < 0) {
+                continue;
+            }
+
+            for (size_t i = 0; i < viewers.size(); ++i) {
+                Viewer& viewer = *viewers[i];
+                short revents = fds[i + 2].revents;
+                if (revents & POLLIN) readViewer(viewer);
+                if (!viewer.closed && (revents & POLLOUT)) flush(viewer);
+                if (revents & (POLLERR | POLLHUP | POLLNVAL)) viewer.closed = true;
+            }
+
+            if (fds[1].revents & POLLIN) {
+                char drain[256];
+                while (Socket::recv(wakeReader, drain, sizeof(drain)) > 0) {
+                }
+            }
+            fanOut();
+
+            if (fds[0].revents & POLLIN) {
+                acceptViewers();
+            }
+
+            size_t before = viewers.size();
+            viewers.erase(std::remove_if(viewers.begin(), viewers.end(), [](const std::unique_ptr<Viewer>& v) {
+                if (v->closed) Socket::close(v->socket);
+                return v->closed;
+            }), viewers.end());
+            if (viewers.size() != before) {
+                viewerCount.store(countStreaming(), std::memory_order_relaxed);
+            }
+        }
+    }
+
+    uint64_t countStreaming() const {
+        uint64_t n = 0;
+        for (auto& viewer : viewers) {
+            n += viewer->state != Viewer::HANDSHAKE ? 1 : 0;
+        }
+        return n;
+    }
+
+    void fanOut() {
+        std::vector<Frame> frames;
+        {
+            std::lock_guard<std::mutex> guard(pendingLock);
+            frames.swap(pending);
+        }
+        if (frames.empty()) {
+            return;
+        }
+
+        TRACE_SPAN("dashboard fan-out");
+        auto started = Clock::now();
+        uint64_t sends = 0;
+        for (const Frame& frame : frames) {
+            for (auto& pointer : viewers) {
+                Viewer& viewer = *pointer;
+                if (viewer.closed) continue;
+                bool wanted = frame.snapshot
+                    ? viewer.state == Viewer::WAITING_SNAPSHOT || (frame.reset && viewer.state == Viewer::STREAMING)
+                    : viewer.state == Viewer::STREAMING;
+                if (wanted) {
+                    viewer.state = Viewer::STREAMING;
+                    enqueue(viewer, frame.bytes);
+                    ++sends;
+                }
+            }
+        }
+        for (auto& viewer : viewers) {
+            if (!viewer->closed && !viewer->outbound.empty()) flush(*viewer);
+        }
+        frameSends.fetch_add(sends, std::memory_order_relaxed);
+        fanoutNs.fetch_add(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - started).count()),
+            std::memory_order_relaxed);
+    }
+
+    void enqueue(Viewer& viewer, const std::shared_ptr<const std::string>& bytes) {
+        viewer.outbound.push_back(bytes);
+        if (viewer.outbound.size() <= maxQueuedFrames) {
+            return;
+        }
+        // Отставший зритель: недописанный кадр нужно закончить, остальное
+        // заменит следующий снимок
+        std::shared_ptr<const std::string> partial;
+        if (viewer.outboundOffset > 0) partial = viewer.outbound.front();
+        viewer.outbound.clear();
+        if (partial) viewer.outbound.push_back(partial);
+        viewer.state = Viewer::WAITING_SNAPSHOT;
+        snapshotRequested = true;
+        resyncCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void flush(Viewer& viewer) {
+        while (!viewer.outbound.empty()) {
+            const std::string& bytes = *viewer.outbound.front();
+            long sent = Socket::send(viewer.socket, bytes.data() + viewer.outboundOffset,
+                                     bytes.size() - viewer.outboundOffset);
+            if (sent < 0) {
+                if (!Socket::wouldBlock()) viewer.closed = true;
+                return;
+            }
+            bytesSent.fetch_add(static_cast<uint64_t>(sent), std::memory_order_relaxed);
+            viewer.outboundOffset += static_cast<size_t>(sent);
+            if (viewer.outboundOffset < bytes.size()) {
+                return;
+            }
+            viewer.outbound.pop_front();
+            viewer.outboundOffset = 0;
+        }
+        if (viewer.closeWhenFlushed) {
+            viewer.closed = true;
+        }
+    }
+
+    void acceptViewers() {
+        for (;;) {
+            Socket::Handle s = ::accept(listener, nullptr, nullptr);
+            if (s == Socket::INVALID) {
+                return;
+            }
+            Socket::setNonBlocking(s);
+            int noDelay = 1;
+            setsockopt(s, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+            auto viewer = std::make_unique<Viewer>();
+            viewer->socket = s;
+            viewers.push_back(std::move(viewer));
+        }
+    }
+
+    void readViewer(Viewer& viewer) {
+        char buffer[4096];
+        for (;;) {
+            long received = Socket::recv(viewer.socket, buffer, sizeof(buffer));
+            if (received == 0 || (received < 0 && !Socket::wouldBlock())) {
+                viewer.closed = true;
+                return;
+            }
+            if (received < 0) {
+                break;
+            }
+            viewer.inbound.append(buffer, static_cast<size_t>(received));
+            if (viewer.inbound.size() > MAX_INBOUND) {
+                viewer.closed = true;
+                return;
+            }
+        }
+        if (viewer.state == Viewer::HANDSHAKE) {
+            handleHandshake(viewer);
+        } else {
+            handleClientFrames(viewer);
+        }
+    }
+
+    // Значение заголовка (без учета регистра имени); пустая строка, если нет
+    static std::string headerValue(const std::string& request, const std::string& lowerName) {
+        std::string lower = request;
+        std::transform(lower.begin(), lower.end(), lower.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        size_t pos = lower.find("\r\n" + lowerName + ":");
+        if (pos == std::string::npos) {
+            return std::string();
+        }
+        pos += lowerName.size() + 3;
+        size_t end = request.find("\r\n", pos);
+        std::string value = request.substr(pos, end - pos);
+        value.erase(0, value.find_first_not_of(" \t"));
+        value.erase(value.find_last_not_of(" \t") + 1);
+        return value;
+    }
+
+    void respond(Viewer& viewer, const std::string& response, bool close) {
+        viewer.closeWhenFlushed = close;
+        viewer.outbound.push_back(std::make_shared<const std::string>(response));
+        flush(viewer);
+    }
+
+    void handleHandshake(Viewer& viewer) {
+        size_t end = viewer.inbound.find("\r\n\r\n");
+        if (end == std::string::npos) {
+            return;
+        }
+        std::string request = viewer.inbound.substr(0, end + 2);
+        viewer.inbound.erase(0, end + 4);
+
+        size_t pathStart = request.find(' ');
+        size_t pathEnd = pathStart == std::string::npos ? std::string::npos : request.find(' ', pathStart + 1);
+        if (request.compare(0, 4, "GET ") != 0 || pathEnd == std::string::npos) {
+            respond(viewer, "HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\nConnection: close\r\n\r\n", true);
+            return;
+        }
+        std::string path = request.substr(pathStart + 1, pathEnd - pathStart - 1);
+        std::string key = headerValue(request, "sec-websocket-key");
+
+        if (path == "/stream" && !key.empty()) {
+            respond(viewer,
+                    "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                    "Sec-WebSocket-Accept: " + webSocketAccept(key) + "\r\n\r\n",
+                    false);
+            viewer.state = Viewer::WAITING_SNAPSHOT;
+            snapshotRequested = true;
+            viewerCount.store(countStreaming(), std::memory_order_relaxed);
+        } else if (path == "/") {
+            std::string page = dashboardPage();
+            respond(viewer,
+                    "HTTP/1.1 200 OK\r\nContent-Type: text/html; charset=utf-8\r\nContent-Length: " +
+                    std::to_string(page.size()) + "\r\nConnection: close\r\n\r\n" + page,
+                    true);
+        } else {
+            respond(viewer, "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n", true);
+        }
+    }
+
+    // Кадры от браузера (всегда с маской): close закрывает соединение, ping
+    // получает pong, остальное игнорируется
+    void handleClientFrames(Viewer& viewer) {
+        std::string& in = viewer.inbound;
+        for (;;) {
+            if (in.size() < 2) return;
+            uint8_t opcode = static_cast<uint8_t>(in[0]) & 0x0F;
+            bool masked = (static_cast<uint8_t>(in[1]) & 0x80) != 0;
+            uint64_t length = static_cast<uint8_t>(in[1]) & 0x7F;
+            size_t header = 2;
+            if (length == 126) {
+                if (in.size() < 4) return;
+                length = (uint64_t(uint8_t(in[2])) << 8) | uint8_t(in[3]);
+                header = 4;
+            } else if (length == 127) {
+                if (in.size() < 10) return;
+                length = 0;
+                for (int i = 0; i < 8; ++i) length = (length << 8) | uint8_t(in[2 + i]);
+                header = 10;
+            }
+            size_t maskOffset = header;
+            if (masked) header += 4;
+            if (length > MAX_INBOUND || in.size() < header + length) {
+                if (length > MAX_INBOUND) viewer.closed = true;
+                return;
+            }
+
+            std::string payload = in.substr(header, static_cast<size_t>(length));
+            if (masked) {
+                for (size_t i = 0; i < payload.size(); ++i) {
+                    payload[i] = static_cast<char>(payload[i] ^ in[maskOffset + (i & 3)]);
+                }
+            }
+            in.erase(0, header + static_cast<size_t>(length));
+
+            if (opcode == 0x8) {
+                viewer.closed = true;
+                return;
+            }
+            if (opcode == 0x9) {
+                viewer.outbound.push_back(std::make_shared<const std::string>(webSocketFrame(0xA, payload)));
+                flush(viewer);
+            }
+        }
+    }
+
+    static std::string dashboardPage() {
+        return R"(<!DOCTYPE html>
+<html><head><meta charset="utf-8"><title>Equipment</title>
+<style>body{font-family:sans-serif}td{padding:2px 12px}td.v{text-align:right;font-family:monospace}</style>
+</head><body><h3>Equipment <span id="tick"></span></h3><table id="t"></table>
+<script>
+const cells = [];
+const ws = new WebSocket("ws://" + location.host + "/stream");
+ws.onmessage = (e) => {
+  const m = JSON.parse(e.data);
+  if (m.type === "snapshot") {
+    const t = document.getElementById("t");
+    t.innerHTML = "";
+    cells.length = 0;
+    m.names.forEach((n, i) => {
+      const r = t.insertRow();
+      r.insertCell().textContent = n;
+      const c = r.insertCell();
+      c.className = "v";
+      c.textContent = m.values[i];
+      cells.push(c);
+    });
+  } else {
+    m.changes.forEach(([i, v]) => { cells[i].textContent = v; });
+  }
+  document.getElementById("tick").textContent = "#" + m.tick;
+};
+</script></body></html>
+)";
+    }
+};
@@ -0,0 +1,419 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <queue>
+#include <functional>
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+
+// ============================== СКОМПИЛИРОВАННОЕ ВЫРАЖЕНИЕ ==============================
+// Выражение хранится в виде обратной польской записи: плоский массив инструкций
+// над стеком double. Ветвлений нет, "a ? b : c" вычисляет обе ветви и выбирает.
+enum class DerivedOp : uint8_t {
+    PushConst, PushSlot,
+    Add, Sub, Mul, Div, Pow, Neg,
+    Lt, Le, Gt, Ge, Eq, Ne, And, Or, Not,
+    Select, Min, Max, Abs, Sqrt, Exp, Log
+};
+
+struct DerivedInstr {
+    DerivedOp op;
+    uint32_t arg; // индекс константы или слота
+};
+
+class DerivedExpression {
+private:
+    std::vector<DerivedInstr> code;
+    std::vector<double> constants;
+    std::vector<uint32_t> inputs; // уникальные слоты, от которых зависит выражение
+    size_t stackDepth = 0;
+
+    friend class DerivedExpressionCompiler;
+
+public:
+    const std::vector<uint32_t>& getInputs() const { return inputs; }
+    size_t getStackDepth() const { return stackDepth; }
+
+    // stack должен вмещать getStackDepth() элементов
+    double evaluate(const double* slots, double* stack) const {
+        double* top = stack; // указывает на первую свободную ячейку
+        for (const DerivedInstr& in : code) {
+            switch (in.op) {
+            case DerivedOp::PushConst: *top++ = constants[in.arg]; break;
+            case DerivedOp::PushSlot:  *top++ = slots[in.arg]; break;
+            case DerivedOp::Add: --top; top[-1] += top[0]; break;
+            case DerivedOp::Sub: --top; top[-1] -= top[0]; break;
+            case DerivedOp::Mul: --top; top[-1] *= top[0]; break;
+            case DerivedOp::Div: --top; top[-1] /= top[0]; break;
+            case DerivedOp::Pow: --top; top[-1] = std::pow(top[-1], top[0]); break;
+            case DerivedOp::Neg: top[-1] = -top[-1]; break;
+            case DerivedOp::Lt:  --top; top[-1] = top[-1] <  top[0] ? 1.0 : 0.0; break;
+            case DerivedOp::Le:  --top; top[-1] = top[-1] <= top[0] ? 1.0 : 0.0; break;
+            case DerivedOp::Gt:  --top; top[-1] = top[-1] >  top[0] ? 1.0 : 0.0; break;
+            case DerivedOp::Ge:  --top; top[-1] = top[-1] >= top[0] ? 1.0 : 0.0; break;
+            case DerivedOp::Eq:  --top; top[-1] = top[-1] == top[0] ? 1.0 : 0.0; break;
+            case DerivedOp::Ne:  --top; top[-1] = top[-1] != top[0] ? 1.0 : 0.0; break;
+            case DerivedOp::And: --top; top[-1] = (top[-1] != 0.0 && top[0] != 0.0) ? 1.0 : 0.0; break;
+            case DerivedOp::Or:  --top; top[-1] = (top[-1] != 0.0 || top[0] != 0.0) ? 1.0 : 0.0; break;
+            case DerivedOp::Not: top[-1] = top[-1] == 0.0 ? 1.0 : 0.0; break;
+            case DerivedOp::Select: // [cond, a, b] -> cond ? a : b
+                top -= 2;
+                top[-1] = top[-1] != 0.0 ? top[0] : top[1];
+                break;
+            case DerivedOp::Min: --top; top[-1] = std::min(top[-1], top[0]); break;
+            case DerivedOp::Max: --top; top[-1] = std::max(top[-1], top[0]); break;
+            case DerivedOp::Abs:  top[-1] = std::fabs(top[-1]); break;
+            case DerivedOp::Sqrt: top[-1] = std::sqrt(top[-1]); break;
+            case DerivedOp::Exp:  top[-1] = std::exp(top[-1]); break;
+            case DerivedOp::Log:  top[-1] = std::log(top[-1]); break;
+            }
+        }
+        return stack[0];
+    }
+};
+
+// ============================== КОМПИЛЯТОР ВЫРАЖЕНИЙ ==============================
+// Грамматика (по возрастанию приоритета):
+//   expr    := or ('?' expr ':' expr)?
+//   or      := and ('||' and)*
+//   and     := cmp ('&&' cmp)*
+//   cmp     := add (('<' | '<=' | '>' | '>=' | '==' | '!=') add)?
+//   add     := mul (('+' | '-') mul)*
+//   mul     := unary (('*' | '/') unary)*
+//   unary   := ('-' | '!') unary | power
+//   power   := primary ('^' unary)?
+//   primary := число | имя | функция '(' expr (',' expr)* ')' | '(' expr ')'
+// Функции: min, max, abs, sqrt, exp, log.
+class DerivedExpressionCompiler {
+public:
+    using Resolver = std::function<uint32_t(const std::string&)>;
+
+private:
+    const std::string& src;
+    size_t pos;
+    const Resolver& resolve;
+    DerivedExpression out;
+    size_t depth;
+
+public:
+    DerivedExpressionCompiler(const std::string& source, const Resolver& resolver)
+        : src(source), pos(0), resolve(resolver), depth(0) {}
+
+    // Бросает std::invalid_argument при синтаксической ошибке или неизвестном имени
+    DerivedExpression compile() {
+        parseExpr();
+        skipSpaces();
+        if (pos != src.size()) {
+            fail("лишние символы");
+        }
+        return std::move(out);
+    }
+
+private:
+    [[noreturn]] void fail(const std::string& what) const {
+        throw std::invalid_argument("Ошибка в выражении \"" + src + "\" (позиция " +
+                                    std::to_string(pos) + "): " + what);
+    }
+
+    void skipSpaces() {
+        while (pos < src.size() && std::isspace(static_cast<unsigned char>(src[pos]))) {
+            ++pos;
+        }
+    }
+
+    bool accept(const char* token) {
+        skipSpaces();
+        size_t len = std::char_traits<char>::length(token);
+        if (src.compare(pos, len, token) != 0) {
+            return false;
+        }
+        // Не путаем "<" с "<=", "!" с "!=" и т.п.
+        if (len == 1 && pos + 1 < src.size() && src[pos + 1] == '=' &&
+            (token[0] == '<' || token[0] == '>' || token[0] == '!' || token[0] == '=')) {
+            return false;
+        }
+        pos += len;
+        return true;
+    }
+
+    void expect(const char* token) {
+        if (!accept(token)) {
+            fail(std::string("ожидалось '") + token + "'");
+        }
+    }
+
+    // Учет глубины стека: push увеличивает, бинарная операция уменьшает на 1
+    void emit(DerivedOp op, uint32_t arg, int stackDelta) {
+        out.code.push_back({op, arg});
+        depth = static_cast<size_t>(static_cast<long>(depth) + stackDelta);
+        out.stackDepth = std::max(out.stackDepth, depth);
+    }
+
+    void parseExpr() {
+        parseOr();
+        if (accept("?")) {
+            parseExpr();
+            expect(":");
+            parseExpr();
+            emit(DerivedOp::Select, 0, -2);
+        }
+    }
+
+    void parseOr() {
+        parseAnd();
+        while (accept("||")) {
+            parseAnd();
+            emit(DerivedOp::Or, 0, -1);
+        }
+    }
+
+    void parseAnd() {
+        parseCmp();
+        while (accept("&&")) {
+            parseCmp();
+            emit(DerivedOp::And, 0, -1);
+        }
+    }
+
+    void parseCmp() {
+        parseAdd();
+        static const struct { const char* token; DerivedOp op; } ops[] = {
+            {"<=", DerivedOp::Le}, {">=", DerivedOp::Ge}, {"==", DerivedOp::Eq},
+            {"!=", DerivedOp::Ne}, {"<", DerivedOp::Lt}, {">", DerivedOp::Gt},
+        };
+        for (const auto& o : ops) {
+            if (accept(o.token)) {
+                parseAdd();
+                emit(o.op, 0, -1);
+                return;
+            }
+        }
+    }
+
+    void parseAdd() {
+        parseMul();
+        for (;;) {
+            if (accept("+")) { parseMul(); emit(DerivedOp::Add, 0, -1); }
+            else if (accept("-")) { parseMul(); emit(DerivedOp::Sub, 0, -1); }
+            else break;
+        }
+    }
+
+    void parseMul() {
+        parseUnary();
+        for (;;) {
+            if (accept("*")) { parseUnary(); emit(DerivedOp::Mul, 0, -1); }
+            else if (accept("/")) { parseUnary(); emit(DerivedOp::Div, 0, -1); }
+            else break;
+        }
+    }
+
+    void parseUnary() {
+        if (accept("-")) { parseUnary(); emit(DerivedOp::Neg, 0, 0); return; }
+        if (accept("!")) { parseUnary(); emit(DerivedOp::Not, 0, 0); return; }
+        parsePower();
+    }
+
+    void parsePower() {
+        parsePrimary();
+        if (accept("^")) {
+            parseUnary();
+            emit(DerivedOp::Pow, 0, -1);
+        }
+    }
+
+    void parsePrimary() {
+        skipSpaces();
+        if (pos >= src.size()) {
+            fail("неожиданный конец выражения");
+        }
+
+        char c = src[pos];
+        if (accept("(")) {
+            parseExpr();
+            expect(")");
+            return;
+        }
+
+        if (std::isdigit(static_cast<unsigned char>(c)) || c == '.') {
+            const char* begin = src.c_str() + pos;
+            char* end = nullptr;
+            double value = std::strtod(begin, &end);
+            if (end == begin) {
+                fail("неверное число");
+            }
+            pos += static_cast<size_t>(end - begin);
+            out.constants.push_back(value);
+            emit(DerivedOp::PushConst, static_cast<uint32_t>(out.constants.size() - 1), +1);
+            return;
+        }
+
+        if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+            size_t start = pos;
+            while (pos < src.size() &&
+                   (std::isalnum(static_cast<unsigned char>(src[pos])) || src[pos] == '_' || src[pos] == '.')) {
+                ++pos;
+            }
+            std::string name = src.substr(start, pos - start);
+            if (accept("(")) {
+                parseCall(name);
+                return;
+            }
+
+            uint32_t slot = resolve(name);
+            if (std::find(out.inputs.begin(), out.inputs.end(), slot) == out.inputs.end()) {
+                out.inputs.push_back(slot);
+            }
+            emit(DerivedOp::PushSlot, slot, +1);
+            return;
+        }
+
+        fail(std::string("неожиданный символ '") + c + "'");
+    }
+
+    void parseCall(const std::string& name) {
+        static const struct { const char* name; DerivedOp op; int args; } funcs[] = {
+            {"min", DerivedOp::Min, 2}, {"max", DerivedOp::Max, 2},
+            {"abs", DerivedOp::Abs, 1}, {"sqrt", DerivedOp::Sqrt, 1},
+            {"exp", DerivedOp::Exp, 1}, {"log", DerivedOp::Log, 1},
+        };
+        for (const auto& f : funcs) {
+            if (name != f.name) continue;
+            for (int i = 0; i < f.args; ++i) {
+                if (i > 0) expect(",");
+                parseExpr();
+            }
+            expect(")");
+            emit(f.op, 0, 1 - f.args);
+            return;
+        }
+        fail("неизвестная функция '" + name + "'");
+    }
+};
+
+// ============================== ДВИЖОК ВЫЧИСЛЯЕМЫХ ТЕГОВ ==============================
+// Входные и вычисляемые теги лежат в одном массиве слотов. Выражение может
+// ссылаться только на уже объявленные теги, поэтому порядок объявления является
+// топологическим порядком графа зависимостей и циклы невозможны. При изменении
+// входа в очередь попадают только зависящие от него теги; пересчитанный тег,
+// значение которого изменилось, в свою очередь ставит в очередь своих потребителей.
+class DerivedTagEngine {
+public:
+    using Slot = uint32_t;
+
+private:
+    struct Tag {
+        DerivedExpression expression;
+        Slot slot;
+    };
+
+    std::vector<double> values;
+    std::vector<std::string> names;
+    std::unordered_map<std::string, Slot> slotByName;
+    std::vector<std::vector<uint32_t>> dependents; // слот -> индексы тегов
+    std::vector<Tag> tags;                         // в топологическом порядке
+    std::vector<uint8_t> scheduled;                // по индексу тега
+    std::priority_queue<uint32_t, std::vector<uint32_t>, std::greater<uint32_t>> queue;
+    std::vector<double> stack;
+
+public:
+    Slot addInput(const std::string& name, double initialValue = 0.0) {
+        return addSlot(name, initialValue);
+    }
+
+    Slot addTag(const std::string& name, const std::string& expression) {
+        DerivedExpressionCompiler::Resolver resolver = [this](const std::string& ref) {
+            return find(ref);
+        };
+        DerivedExpression compiled = DerivedExpressionCompiler(expression, resolver).compile();
+
+        if (stack.size() < compiled.getStackDepth()) {
+            stack.resize(compiled.getStackDepth());
+        }
+
+        double initialValue = compiled.evaluate(values.data(), stack.data());
+        Slot slot = addSlot(name, initialValue);
+
+        uint32_t tagIndex = static_cast<uint32_t>(tags.size());
+        for (Slot input : compiled.getInputs()) {
+            dependents[input].push_back(tagIndex);
+        }
+        tags.push_back({std::move(compiled), slot});
+        scheduled.push_back(0);
+        return slot;
+    }
+
+    Slot find(const std::string& name) const {
+        auto it = slotByName.find(name);
+        if (it == slotByName.end()) {
+            throw std::invalid_argument("Неизвестный тег: " + name);
+        }
+        return it->second;
+    }
+
+    const std::string& getName(Slot slot) const { return names[slot]; }
+    double get(Slot slot) const { return values[slot]; }
+    size_t size() const { return values.size(); }
+    size_t tagCount() const { return tags.size(); }
+
+    // Установка входа; зависимые теги пересчитаются при следующем evaluate()
+    void set(Slot slot, double value) {
+        if (values[slot] == value) {
+            return;
+        }
+        values[slot] = value;
+        schedule(slot);
+    }
+
+    // Пересчитывает только затронутые теги и вызывает onChanged(slot, value)
+    // для каждого тега, значение которого изменилось. Возвращает число пересчетов.
+    template<typename Fn>
+    size_t evaluate(Fn&& onChanged) {
+        size_t recomputed = 0;
+        while (!queue.empty()) {
+            uint32_t tagIndex = queue.top();
+            queue.pop();
+            scheduled[tagIndex] = 0;
+
+            const Tag& tag = tags[tagIndex];
+            double value = tag.expression.evaluate(values.data(), stack.data());
+            ++recomputed;
+
+            if (values[tag.slot] == value) {
+                continue;
+            }
+            values[tag.slot] = value;
+            schedule(tag.slot);
+            onChanged(tag.slot, value);
+        }
+        return recomputed;
+    }
+
+private:
+    Slot addSlot(const std::string& name, double initialValue) {
+        if (slotByName.count(name)) {
+            throw std::invalid_argument("Тег уже существует: " + name);
+        }
+        Slot slot = static_cast<Slot>(values.size());
+        values.push_back(initialValue);
+        names.push_back(name);
+        dependents.emplace_back();
+        slotByName.emplace(name, slot);
+        return slot;
+    }
+
+    void schedule(Slot slot) {
+        for (uint32_t tagIndex : dependents[slot]) {
+            if (!scheduled[tagIndex]) {
+                scheduled[tagIndex] = 1;
+                queue.push(tagIndex);
+            }
+        }
+    }
+};
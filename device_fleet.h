@@ -0,0 +1,354 @@
+#pragma once
+
+#include <open62541/server.h>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "devices.h"
+#include "trace.h"
+
+// ============================== ПАРК УСТРОЙСТВ ==============================
+// Устройства сервера, которые добавляются и удаляются без перезапуска.
+//
+// Запросы (requestAdd/requestRemove) принимаются из любого потока - методы
+// EquipmentControl вызывает поток сервисов - и только ставятся в очередь; NodeId
+// новых устройств выдаются сразу. Поток симуляции в начале такта (apply)
+// создает и удаляет узлы, не больше maxChangesPerTick устройств за такт, чтобы
+// большая партия не задерживала ни такт, ни запросы клиентов к остальным
+// устройствам. Сессии и подписки на другие устройства при этом не прерываются.
+//
+// Удаленное устройство сразу исчезает из адресного пространства и из обхода
+// (updateValues, acquireWaveforms), но его объект и слоты ValueStore живут еще
+// RETIRE_TICKS тактов: за это время завершаются чтения, начатые до удаления, и
+// разбираются уже поставленные в очередь команды его уставок.
+//
+// Запрос выполнен, когда appliedCount() >= номера, выданного при постановке
+// (как у очереди уставок).
+class DeviceFleet {
+public:
+    enum class Kind { Multimeter, Machine, Computer };
+
+    static constexpr UA_UInt32 FIRST_DYNAMIC_ID = 1000; // 100, 200, 300 - устройства по умолчанию
+    static constexpr UA_UInt32 ID_STEP = 100;
+    // Устройство занимает номера [id, id + ID_STEP), свойства его компонентов -
+    // PROPERTY_ID_BASE + номер компонента. Блоки не должны заходить в диапазон
+    // свойств, а свойства - в автоматические номера nodestore
+    static constexpr UA_UInt32 ID_LIMIT = std::min(
+        OPCUANode::PROPERTY_ID_BASE, EquipmentNodestore::AUTO_ID_BASE - OPCUANode::PROPERTY_ID_BASE);
+    static constexpr size_t SLOTS_PER_DEVICE = 8;       // с запасом: до 6 скаляров в ValueStore
+    static constexpr uint64_t RETIRE_TICKS = 2;
+
+    static bool parseKind(const std::string& text, Kind& kind) {
+        if (text == "Multimeter") kind = Kind::Multimeter;
+        else if (text == "Machine") kind = Kind::Machine;
+        else if (text == "Computer") kind = Kind::Computer;
+        else return false;
+        return true;
+    }
+
+    static const char* kindName(Kind kind) {
+        switch (kind) {
+        case Kind::Multimeter: return "Multimeter";
+        case Kind::Machine: return "Machine";
+        case Kind::Computer: return "Computer";
+        }
+        return "";
+    }
+
+private:
+    struct Request {
+        bool add;
+        Kind kind;
+        UA_UInt32 id;
+    };
+
+    struct Retired {
+        uint64_t tick;
+        std::unique_ptr<OPCUADevice> device;
+    };
+
+    UA_Server* server;
+    UA_UInt16 namespaceIndex;
+    ValueStore* store;
+    std::atomic<size_t> maxChangesPerTick;
+    bool verbose = true;
+
+    // Меняет только поток симуляции; сетевой поток обходит под liveLock
+    std::vector<std::unique_ptr<OPCUADevice>> live;
+    std::mutex liveLock;
+    std::vector<Retired> retired;
+    std::atomic<size_t> liveCount{0};
+
+    // Очередь запросов; known - устройства, которые есть или будут созданы
+    // (значение - удаление уже запрошено)
+    std::mutex requestLock;
+    std::deque<Request> requests;
+    std::unordered_map<UA_UInt32, bool> known;
+    UA_UInt32 nextId;
+    size_t reservedSlots = 0;
+
+    std::atomic<uint64_t> enqueued{0};
+    std::atomic<uint64_t> applied{0};
+
+    // Статистика потока симуляции
+    uint64_t added = 0;
+    uint64_t removed = 0;
+    uint64_t failed = 0;
+    uint64_t addNs = 0;
+    uint64_t removeNs = 0;
+
+    std::unique_ptr<OPCUADevice> createDevice(Kind kind, UA_UInt32 id, const std::string& name) {
+        std::unique_ptr<OPCUADevice> device;
+        try {
+            switch (kind) {
+            case Kind::Multimeter: device = std::make_unique<Multimeter>(server, namespaceIndex, id, name); break;
+            case Kind::Machine: device = std::make_unique<Machine>(server, namespaceIndex, id, name); break;
+            case Kind::Computer: device = std::make_unique<Computer>(server, namespaceIndex, id, name); break;
+            }
+        } catch (const std::exception& e) {
+            // Слоты уже созданных компонентов вернули их деструкторы
+            std::cerr << "DeviceFleet: не удалось создать " << name << ": " << e.what() << std::endl;
+            return nullptr;
+        }
+        device->setVerbose(verbose);
+        device->initialize();
+        return device;
+    }
+
+    void insertLive(std::unique_ptr<OPCUADevice> device) {
+        std::lock_guard<std::mutex> guard(liveLock);
+        live.push_back(std::move(device));
+        liveCount.store(live.size(), std::memory_order_relaxed);
+    }
+
+    // Только из потока симуляции: он единственный меняет live
+    OPCUADevice* findLive(UA_UInt32 id) const {
+        for (const auto& device : live) {
+            if (device->getNodeId().identifier.numeric == id) {
+                return device.get();
+            }
+        }
+        return nullptr;
+    }
+
+    std::unique_ptr<OPCUADevice> takeLive(UA_UInt32 id) {
+        std::lock_guard<std::mutex> guard(liveLock);
+        for (auto it = live.begin(); it != live.end(); ++it) {
+            if ((*it)->getNodeId().identifier.numeric == id) {
+                std::unique_ptr<OPCUADevice> device = std::move(*it);
+                live.erase(it);
+                liveCount.store(live.size(), std::memory_order_relaxed);
+                return device;
+            }
+        }
+        return nullptr;
+    }
+
+    static uint64_t elapsedNs(std::chrono::steady_clock::time_point since) {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - since).count());
+    }
+
+public:
+    // maxChanges - устройств за такт, 0 - без ограничения; firstId - номер
+    // первого устройства AddDevices (не по умолчанию - только для проверки ID_LIMIT)
+    DeviceFleet(UA_Server* srv, UA_UInt16 nsIndex, size_t maxChanges = 64,
+                UA_UInt32 firstId = FIRST_DYNAMIC_ID)
+        : server(srv), namespaceIndex(nsIndex), store(&EquipmentNodestore::storeFor(srv)),
+          maxChangesPerTick(maxChanges), nextId(std::min(firstId, ID_LIMIT)) {}
+
+    ~DeviceFleet() {
+        clear();
+    }
+
+    DeviceFleet(const DeviceFleet&) = delete;
+    DeviceFleet& operator=(const DeviceFleet&) = delete;
+
+    // ---------- настройка ----------
+
+    // Устройство с заданным NodeId сразу; до запуска цикла или из потока симуляции
+    OPCUADevice* addNow(Kind kind, UA_UInt32 id, const std::string& name) {
+        std::unique_ptr<OPCUADevice> device = createDevice(kind, id, name);
+        if (!device) {
+            return nullptr;
+        }
+        OPCUADevice* raw = device.get();
+        insertLive(std::move(device));
+        std::lock_guard<std::mutex> guard(requestLock);
+        known[id] = false;
+        return raw;
+    }
+
+    void setMaxChangesPerTick(size_t maxChanges) { maxChangesPerTick.store(maxChanges, std::memory_order_relaxed); }
+
+    // Вывод значений в консоль для текущих и будущих устройств
+    void setVerbose(bool enabled) {
+        verbose = enabled;
+        for (auto& device : live) {
+            device->setVerbose(enabled);
+        }
+    }
+
+    // Удаляет все устройства без удаления узлов; вызывать перед UA_Server_delete
+    void clear() {
+        std::lock_guard<std::mutex> guard(liveLock);
+        live.clear();
+        retired.clear();
+        liveCount.store(0, std::memory_order_relaxed);
+    }
+
+    // ---------- запросы (любой поток) ----------
+
+    // Ставит в очередь count устройств; ids - их NodeId (числовая часть),
+    // ticket - значение appliedCount(), после которого все они созданы.
+    // BadOutOfRange, если блоки номеров дошли бы до ID_LIMIT;
+    // BadResourceUnavailable, если не хватит места в ValueStore. При ошибке
+    // не ставится ни одно устройство.
+    UA_StatusCode requestAdd(Kind kind, size_t count, std::vector<UA_UInt32>& ids, uint64_t& ticket) {
+        std::lock_guard<std::mutex> guard(requestLock);
+        if (count > (ID_LIMIT - nextId) / ID_STEP) {
+            return UA_STATUSCODE_BADOUTOFRANGE;
+        }
+        size_t needed = count * SLOTS_PER_DEVICE;
+        if (store->available() < reservedSlots + needed) {
+            return UA_STATUSCODE_BADRESOURCEUNAVAILABLE;
+        }
+        reservedSlots += needed;
+        ids.clear();
+        for (size_t i = 0; i < count; ++i) {
+            UA_UInt32 id = nextId;
+            nextId += ID_STEP;
+            requests.push_back(Request{true, kind, id});
+            known[id] = false;
+            ids.push_back(id);
+        }
+        ticket = enqueued.fetch_add(count, std::memory_order_relaxed) + count;
+        return UA_STATUSCODE_GOOD;
+    }
+
+    // false, если устройства нет или его удаление уже запрошено
+    bool requestRemove(UA_UInt32 id, uint64_t& ticket) {
+        std::lock_guard<std::mutex> guard(requestLock);
+        auto it = known.find(id);
+        if (it == known.end() || it->second) {
+            return false;
+        }
+        it->second = true;
+        requests.push_back(Request{false, Kind::Machine, id});
+        ticket = enqueued.fetch_add(1, std::memory_order_relaxed) + 1;
+        return true;
+    }
+
+    uint64_t enqueuedCount() const { return enqueued.load(std::memory_order_relaxed); }
+    uint64_t appliedCount() const { return applied.load(std::memory_order_relaxed); }
+    size_t size() const { return liveCount.load(std::memory_order_relaxed); }
+
+    // ---------- поток симуляции ----------
+
+    // Освобождает устройства, удаленные RETIRE_TICKS тактов назад, и выполняет
+    // очередные запросы; возвращает число добавленных и удаленных устройств
+    size_t apply(uint64_t tick) {
+        TRACE_SPAN("fleet");
+        if (!retired.empty()) {
+            auto expired = std::remove_if(retired.begin(), retired.end(), [tick](const Retired& r) {
+                return r.tick + RETIRE_TICKS <= tick;
+            });
+            for (auto it = expired; it != retired.end(); ++it) {
+                it->device->releaseSlots();
+            }
+            retired.erase(expired, retired.end());
+        }
+
+        std::vector<Request> batch;
+        {
+            std::lock_guard<std::mutex> guard(requestLock);
+            size_t maxChanges = maxChangesPerTick.load(std::memory_order_relaxed);
+            size_t limit = maxChanges == 0 ? requests.size() : std::min(requests.size(), maxChanges);
+            batch.assign(requests.begin(), requests.begin() + static_cast<std::ptrdiff_t>(limit));
+            requests.erase(requests.begin(), requests.begin() + static_cast<std::ptrdiff_t>(limit));
+        }
+
+        for (const Request& request : batch) {
+            auto started = std::chrono::steady_clock::now();
+            if (request.add) {
+                std::string name = std::string(kindName(request.kind)) + "_" + std::to_string(request.id);
+                std::unique_ptr<OPCUADevice> device = createDevice(request.kind, request.id, name);
+                if (device) {
+                    insertLive(std::move(device));
+                    ++added;
+                } else {
+                    ++failed;
+                    std::lock_guard<std::mutex> guard(requestLock);
+                    known.erase(request.id);
+                }
+                std::lock_guard<std::mutex> guard(requestLock);
+                reservedSlots -= std::min(reservedSlots, SLOTS_PER_DEVICE);
+                addNs += elapsedNs(started);
+            } else {
+                OPCUADevice* device = findLive(request.id);
+                UA_StatusCode status = device ? device->removeNodes() : UA_STATUSCODE_BADNODEIDUNKNOWN;
+                std::lock_guard<std::mutex> guard(requestLock);
+                if (status == UA_STATUSCODE_GOOD) {
+                    retired.push_back(Retired{tick, takeLive(request.id)});
+                    ++removed;
+                    known.erase(request.id);
+                } else if (device) {
+                    // Узлы на месте: устройство остается в работе, удаление
+                    // можно запросить снова
+                    std::cerr << "DeviceFleet: не удалось удалить " << device->getBrowseName() << ": "
+                              << UA_StatusCode_name(status) << std::endl;
+                    ++failed;
+                    known[request.id] = false;
+                } else {
+                    ++failed; // создание не удалось
+                    known.erase(request.id);
+                }
+                removeNs += elapsedNs(started);
+            }
+            applied.fetch_add(1, std::memory_order_relaxed);
+        }
+        return batch.size();
+    }
+
+    void updateValues() {
+        for (auto& device : live) {
+            device->updateValues();
+        }
+    }
+
+    // Обход устройств в потоке симуляции (или до запуска цикла)
+    template<typename Fn>
+    void forEach(Fn fn) const {
+        for (const auto& device : live) {
+            fn(*device);
+        }
+    }
+
+    // ---------- сетевой поток ----------
+
+    // См. OPCUADevice::acquireWaveforms
+    void acquireWaveforms() {
+        std::lock_guard<std::mutex> guard(liveLock);
+        for (auto& device : live) {
+            device->acquireWaveforms();
+        }
+    }
+
+    void print(std::ostream& out) const {
+        out << "Устройства: " << size() << ", добавлено " << added << ", удалено " << removed;
+        out << std::fixed << std::setprecision(1);
+        if (added > 0) out << ", " << addNs / 1000.0 / added << " мкс на добавление";
+        if (removed > 0) out << ", " << removeNs / 1000.0 / removed << " мкс на удаление";
+        if (failed > 0) out << ", ошибок: " << failed;
+        out << std::endl;
+    }
+};
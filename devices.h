@@ -0,0 +1,383 @@
+#pragma once
+
+#include <iostream>
+#include <random>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "opcua_nodes.h"
+#include "trace.h"
+
+// ============================== КЛАСС МУЛЬТИМЕТРА ==============================
+class Multimeter : public OPCUADevice {
+private:
+    OPCUAComponentVariable<float>* voltage;
+    OPCUAComponentVariable<float>* current;
+    OPCUAComponentVariable<float>* resistance;
+    OPCUAComponentVariable<float>* power;
+    DerivedTagEngine::Slot voltageSlot;
+    DerivedTagEngine::Slot currentSlot;
+    DerivedTagEngine::Slot resistanceSlot;
+    DerivedTagEngine::Slot powerSlot;
+    std::mt19937 rng;
+    
+    // Осциллограммы сетевого напряжения и тока
+    static constexpr double MAINS_FREQUENCY = 50.0; // Гц
+    static constexpr double CURRENT_LAG = 0.3;      // сдвиг фазы тока, рад
+    OPCUAWaveformVariable<float>* voltageWaveform;
+    OPCUAWaveformVariable<float>* currentWaveform;
+    double waveformRate;
+    double phase;
+    double pendingSamples;
+    std::chrono::steady_clock::time_point lastWaveformUpdate;
+    std::vector<float> voltageSamples;
+    std::vector<float> currentSamples;
+    
+public:
+    // baseId - NodeId устройства, компоненты получают baseId+1..baseId+6;
+    // waveformRateHz - частота дискретизации осциллограмм, waveformLength - отсчетов в кадре
+    Multimeter(UA_Server* srv, UA_UInt16 nsIndex, UA_UInt32 baseId = 100,
+               const std::string& name = "Multimeter",
+               double waveformRateHz = 1000.0, size_t waveformLength = 1000)
+        : OPCUADevice(srv, nsIndex, baseId, name, "Мультиметр", 
+                     "Электрический измерительный прибор"),
+          voltage(nullptr),
+          current(nullptr),
+          resistance(nullptr),
+          power(nullptr),
+          rng(std::random_device{}()),
+          voltageWaveform(nullptr),
+          currentWaveform(nullptr),
+          waveformRate(waveformRateHz),
+          phase(0.0),
+          pendingSamples(0.0),
+          lastWaveformUpdate(std::chrono::steady_clock::now()) {
+        
+        // Создаем измеряемые компоненты мультиметра
+        // Точности float достаточно для показаний прибора
+        auto voltageVar = std::make_unique<OPCUAComponentVariable<float>>(
+            srv, nsIndex, baseId + 1, "Voltage", "Напряжение", 
+            "Измеренное напряжение (Вольты)", 220.0f, nodeId);
+        
+        auto currentVar = std::make_unique<OPCUAComponentVariable<float>>(
+            srv, nsIndex, baseId + 2, "Current", "Сила тока", 
+            "Измеренная сила тока (Амперы)", 5.0f, nodeId);
+        
+        voltage = voltageVar.get();
+        current = currentVar.get();
+        
+        voltageSlot = bindInput(voltage, "Voltage", 220.0);
+        currentSlot = bindInput(current, "Current", 5.0);
+        
+        addComponent(std::move(voltageVar));
+        addComponent(std::move(currentVar));
+        
+        // Расчетные компоненты
+        resistance = addDerivedComponent<float>(baseId + 3, "Resistance", "Сопротивление",
+            "Измеренное сопротивление (Омы)", "Current > 0.1 ? Voltage / Current : 100"); // R = U/I
+        power = addDerivedComponent<float>(baseId + 4, "Power", "Мощность",
+            "Расчетная мощность (Ватты)", "Voltage * Current"); // P = U*I
+        
+        resistanceSlot = derived.find("Resistance");
+        powerSlot = derived.find("Power");
+        
+        voltageWaveform = addWaveformComponent<float>(baseId + 5, "VoltageWaveform", "Осциллограмма напряжения",
+            "Мгновенные значения напряжения (Вольты)", waveformLength, waveformRateHz);
+        currentWaveform = addWaveformComponent<float>(baseId + 6, "CurrentWaveform", "Осциллограмма тока",
+            "Мгновенные значения силы тока (Амперы)", waveformLength, waveformRateHz);
+        
+        // Не более секунды отсчетов за одно обновление
+        size_t maxBurst = static_cast<size_t>(std::ceil(waveformRateHz));
+        voltageSamples.reserve(maxBurst);
+        currentSamples.reserve(maxBurst);
+    }
+    
+    void updateValues() override {
+        TRACE_SPAN("Multimeter::updateValues");
+        std::uniform_real_distribution<double> voltageDist(190.0, 240.0);
+        std::uniform_real_distribution<double> currentDist(0.5, 15.0);
+        
+        double v, c;
+        {
+            TRACE_SPAN("rng");
+            v = voltageDist(rng);
+            c = currentDist(rng);
+        }
+        
+        {
+            TRACE_SPAN("write");
+            setInput(voltageSlot, v);
+            setInput(currentSlot, c);
+            commitDerived();
+        }
+        
+        {
+            TRACE_SPAN("waveform");
+            generateWaveforms(v, c);
+        }
+        
+        double r = derived.get(resistanceSlot);
+        double p = derived.get(powerSlot);
+        
+        if (verbose) {
+            TRACE_SPAN("console");
+            std::cout << "Мультиметр: Напряжение = " << v << " В, Ток = " << c 
+                      << " А, Сопротивление = " << r << " Ом, Мощность = " << p << " Вт" << std::endl;
+        }
+    }
+    
+private:
+    // Синусоиды с действующими значениями vRms/cRms за время с прошлого обновления
+    void generateWaveforms(double vRms, double cRms) {
+        auto now = std::chrono::steady_clock::now();
+        double elapsed = std::chrono::duration<double>(now - lastWaveformUpdate).count();
+        lastWaveformUpdate = now;
+        
+        // После долгой паузы не догоняем больше секунды
+        pendingSamples += std::min(elapsed, 1.0) * waveformRate;
+        size_t count = static_cast<size_t>(pendingSamples);
+        pendingSamples -= static_cast<double>(count);
+        if (count == 0) {
+            return;
+        }
+        
+        const double twoPi = 2.0 * 3.14159265358979323846;
+        const double step = twoPi * MAINS_FREQUENCY / waveformRate;
+        const double vAmplitude = vRms * std::sqrt(2.0);
+        const double cAmplitude = cRms * std::sqrt(2.0);
+        std::normal_distribution<float> noise(0.0f, 0.01f);
+        
+        voltageSamples.resize(count);
+        currentSamples.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            voltageSamples[i] = static_cast<float>(vAmplitude * std::sin(phase)) * (1.0f + noise(rng));
+            currentSamples[i] = static_cast<float>(cAmplitude * std::sin(phase - CURRENT_LAG)) * (1.0f + noise(rng));
+            phase += step;
+            if (phase >= twoPi) phase -= twoPi;
+        }
+        
+        UA_DateTime lastSampleTime = UA_DateTime_now();
+        voltageWaveform->append(voltageSamples.data(), count, lastSampleTime);
+        currentWaveform->append(currentSamples.data(), count, lastSampleTime);
+    }
+};
+
+// ============================== КЛАСС СТАНКА ==============================
+class Machine : public OPCUADevice {
+private:
+    OPCUAComponentVariable<float>* flywheelRPM;
+    OPCUAComponentVariable<float>* power;
+    OPCUAComponentVariable<int16_t>* voltage;
+    OPCUAComponentVariable<double>* energyConsumption;
+    OPCUAComponentVariable<bool>* running;
+    OPCUASetpointVariable<double>* baseRPMSetpoint;
+    DerivedTagEngine::Slot flywheelRPMSlot;
+    DerivedTagEngine::Slot powerSlot;
+    DerivedTagEngine::Slot voltageSlot;
+    DerivedTagEngine::Slot energySlot;
+    DerivedTagEngine::Slot runningSlot;
+    std::mt19937 rng;
+    double baseRPM;
+    
+public:
+    // baseId - NodeId устройства, компоненты получают baseId+1..baseId+6
+    Machine(UA_Server* srv, UA_UInt16 nsIndex, UA_UInt32 baseId = 200, const std::string& name = "Machine")
+        : OPCUADevice(srv, nsIndex, baseId, name, "Станок", 
+                     "Промышленный станок с электроприводом"),
+          flywheelRPM(nullptr),
+          power(nullptr),
+          voltage(nullptr),
+          energyConsumption(nullptr),
+          running(nullptr),
+          baseRPMSetpoint(nullptr),
+          rng(std::random_device{}()),
+          baseRPM(1500.0) {
+        
+        // Создаем компоненты станка
+        auto flywheelRPMVar = std::make_unique<OPCUAComponentVariable<float>>(
+            srv, nsIndex, baseId + 1, "FlywheelRPM", "Обороты маховика", 
+            "Скорость вращения маховика (об/мин)", static_cast<float>(baseRPM), nodeId);
+        
+        auto powerVar = std::make_unique<OPCUAComponentVariable<float>>(
+            srv, nsIndex, baseId + 2, "Power", "Мощность", 
+            "Потребляемая мощность (кВт)", 7.5f, nodeId);
+        
+        // Напряжение сети меняется с шагом 1 В
+        auto voltageVar = std::make_unique<OPCUAComponentVariable<int16_t>>(
+            srv, nsIndex, baseId + 3, "Voltage", "Напряжение", 
+            "Рабочее напряжение (Вольты)", static_cast<int16_t>(380), nodeId);
+        
+        flywheelRPM = flywheelRPMVar.get();
+        power = powerVar.get();
+        voltage = voltageVar.get();
+        
+        flywheelRPMSlot = bindInput(flywheelRPM, "FlywheelRPM", baseRPM);
+        powerSlot = bindInput(power, "Power", 7.5);
+        voltageSlot = bindInput(voltage, "Voltage", 380.0);
+        
+        addComponent(std::move(flywheelRPMVar));
+        addComponent(std::move(powerVar));
+        addComponent(std::move(voltageVar));
+        
+        // Увеличиваем пропорционально мощности
+        energyConsumption = addDerivedComponent<double>(baseId + 4, "EnergyConsumption", "Потребление энергии",
+            "Потребление энергии (кВт·ч)", "56.3 + Power * 0.001");
+        running = addDerivedComponent<bool>(baseId + 5, "Running", "В работе",
+            "Маховик вращается", "FlywheelRPM > 100");
+        energySlot = derived.find("EnergyConsumption");
+        runningSlot = derived.find("Running");
+        
+        // Заданные обороты - единственный параметр, который меняют клиенты
+        baseRPMSetpoint = addSetpointComponent<double>(baseId + 6, "BaseRPM", "Заданные обороты",
+            "Уставка скорости вращения маховика (об/мин)", baseRPM, 0.0, 3000.0);
+    }
+    
+    void onSetpoint(OPCUAVariableBase* setpoint, double value) override {
+        if (setpoint == baseRPMSetpoint) {
+            baseRPM = value;
+        }
+    }
+    
+    void updateValues() override {
+        TRACE_SPAN("Machine::updateValues");
+        // Симуляция работы станка с небольшими флуктуациями
+        std::normal_distribution<double> rpmNoise(0.0, 10.0);
+        std::normal_distribution<double> powerNoise(0.0, 0.1);
+        
+        double rpm, pwr, volt;
+        {
+            TRACE_SPAN("rng");
+            rpm = std::max(0.0, baseRPM + rpmNoise(rng));
+            pwr = 7.5 + powerNoise(rng);
+            volt = 380.0 + (static_cast<int>(rng() % 20) - 10); // ±10V
+        }
+        
+        {
+            TRACE_SPAN("write");
+            setInput(flywheelRPMSlot, rpm);
+            setInput(powerSlot, pwr);
+            setInput(voltageSlot, volt);
+            commitDerived();
+        }
+        
+        double energy = derived.get(energySlot);
+        bool isRunning = derived.get(runningSlot) != 0.0;
+        
+        if (verbose) {
+            TRACE_SPAN("console");
+            std::cout << "Станок: Обороты = " << rpm << " об/мин, Мощность = " << pwr 
+                      << " кВт, Напряжение = " << volt << " В, Энергия = " << energy << " кВт·ч"
+                      << (isRunning ? "" : " (остановлен)") << std::endl;
+        }
+    }
+    
+    void setBaseRPM(double rpm) {
+        baseRPM = rpm;
+        baseRPMSetpoint->writeValue(rpm);
+    }
+};
+
+// ============================== КЛАСС КОМПЬЮТЕРА ==============================
+class Computer : public OPCUADevice {
+private:
+    OPCUAComponentVariable<uint16_t>* fan1;
+    OPCUAComponentVariable<uint16_t>* fan2;
+    OPCUAComponentVariable<uint16_t>* fan3;
+    OPCUAComponentVariable<float>* cpuLoad;
+    OPCUAComponentVariable<float>* gpuLoad;
+    OPCUAComponentVariable<uint8_t>* ramUsage;
+    DerivedTagEngine::Slot fan1Slot;
+    DerivedTagEngine::Slot fan2Slot;
+    DerivedTagEngine::Slot fan3Slot;
+    DerivedTagEngine::Slot cpuLoadSlot;
+    DerivedTagEngine::Slot gpuLoadSlot;
+    DerivedTagEngine::Slot ramUsageSlot;
+    std::mt19937 rng;
+    
+public:
+    // baseId - NodeId устройства, компоненты получают baseId+1..baseId+6
+    Computer(UA_Server* srv, UA_UInt16 nsIndex, UA_UInt32 baseId = 300, const std::string& name = "Computer")
+        : OPCUADevice(srv, nsIndex, baseId, name, "Компьютер", 
+                     "Системный блок с мониторингом параметров"),
+          fan1(nullptr),
+          fan2(nullptr),
+          fan3(nullptr),
+          cpuLoad(nullptr),
+          gpuLoad(nullptr),
+          ramUsage(nullptr),
+          rng(std::random_device{}()) {
+        
+        // Создаем измеряемые компоненты компьютера
+        auto cpuLoadVar = std::make_unique<OPCUAComponentVariable<float>>(
+            srv, nsIndex, baseId + 4, "CPULoad", "Загрузка ЦП", 
+            "Загрузка центрального процессора (%)", 30.0f, nodeId);
+        
+        auto gpuLoadVar = std::make_unique<OPCUAComponentVariable<float>>(
+            srv, nsIndex, baseId + 5, "GPULoad", "Загрузка ГП", 
+            "Загрузка графического процессора (%)", 25.0f, nodeId);
+        
+        // Целые проценты - один байт
+        auto ramUsageVar = std::make_unique<OPCUAComponentVariable<uint8_t>>(
+            srv, nsIndex, baseId + 6, "RAMUsage", "Использование ОЗУ", 
+            "Использование оперативной памяти (%)", static_cast<uint8_t>(45), nodeId);
+        
+        cpuLoad = cpuLoadVar.get();
+        gpuLoad = gpuLoadVar.get();
+        ramUsage = ramUsageVar.get();
+        
+        cpuLoadSlot = bindInput(cpuLoad, "CPULoad", 30.0);
+        gpuLoadSlot = bindInput(gpuLoad, "GPULoad", 25.0);
+        ramUsageSlot = bindInput(ramUsage, "RAMUsage", 45.0);
+        
+        // Вентиляторы реагируют на загрузку
+        fan1 = addDerivedComponent<uint16_t>(baseId + 1, "Fan1", "Вентилятор 1",
+            "Скорость вентилятора ЦП (об/мин)", "1000 + CPULoad * 10");
+        fan2 = addDerivedComponent<uint16_t>(baseId + 2, "Fan2", "Вентилятор 2",
+            "Скорость вентилятора корпуса (об/мин)", "800 + (CPULoad + GPULoad) * 5");
+        fan3 = addDerivedComponent<uint16_t>(baseId + 3, "Fan3", "Вентилятор 3",
+            "Скорость вентилятора блока питания (об/мин)", "900 + (CPULoad * 0.7 + GPULoad * 0.3) * 8");
+        
+        fan1Slot = derived.find("Fan1");
+        fan2Slot = derived.find("Fan2");
+        fan3Slot = derived.find("Fan3");
+        
+        addComponent(std::move(cpuLoadVar));
+        addComponent(std::move(gpuLoadVar));
+        addComponent(std::move(ramUsageVar));
+    }
+    
+    void updateValues() override {
+        TRACE_SPAN("Computer::updateValues");
+        // Симуляция параметров компьютера
+        std::uniform_real_distribution<double> loadDist(20.0, 80.0);
+        std::uniform_real_distribution<double> ramDist(30.0, 70.0);
+        
+        double cpu, gpu, ram;
+        {
+            TRACE_SPAN("rng");
+            cpu = loadDist(rng);
+            gpu = loadDist(rng);
+            ram = ramDist(rng);
+        }
+        
+        {
+            TRACE_SPAN("write");
+            setInput(cpuLoadSlot, cpu);
+            setInput(gpuLoadSlot, gpu);
+            setInput(ramUsageSlot, ram);
+            commitDerived();
+        }
+        
+        double f1 = derived.get(fan1Slot);
+        double f2 = derived.get(fan2Slot);
+        double f3 = derived.get(fan3Slot);
+        
+        if (verbose) {
+            TRACE_SPAN("console");
+            std::cout << "Компьютер: Вентиляторы = [" << f1 << ", " << f2 << ", " << f3 
+                      << "] об/мин, ЦП = " << cpu << "%, ГП = " << gpu 
+                      << "%, ОЗУ = " << ram << "%" << std::endl;
+        }
+    }
+};
@@ -0,0 +1,336 @@
+#pragma once
+
+#include <open62541/server.h>
+
+#include <string>
+#include <vector>
+
+#include "opcua_nodes.h"
+#include "device_fleet.h"
+
+#ifdef SERVER_POOLED_ALLOCATOR
+#include "pool_allocator.h"
+#endif
+
+// ============================== КЛАСС УПРАВЛЯЮЩЕГО ОБЪЕКТА ==============================
+// Служебный объект EquipmentControl (ns=<ns>;i=10) с методами сервера.
+//
+// RegisterHandles (i=11): стандартный сервис RegisterNodes в open62541 возвращает
+// переданные NodeId без изменений и не допускает переопределения, поэтому
+// компактные ручки выдаются этим методом. Для переменных оборудования
+// возвращается NodeId ns=<ns>;i=HANDLE_BASE+(поколение<<SLOT_BITS)+слот
+// (0x80000000, 16 бит на слот), который сервер разрешает прямым обращением к
+// массиву ValueStore. Поколение сверяется с текущим поколением слота, поэтому
+// ручка удаленной переменной дает BadNodeIdUnknown, а не значение новой
+// переменной в том же слоте. Остальные NodeId возвращаются как есть.
+//
+// CommandsEnqueued (i=12) / CommandsApplied (i=13): счетчики очереди уставок.
+// Клиент, записавший уставку, читает CommandsEnqueued = N; запись вступила в
+// силу, когда CommandsApplied >= N.
+//
+// PooledAllocations (i=14) / SystemAllocations (i=15): счетчики пула памяти
+// (только при SERVER_POOLED_ALLOCATOR). В установившемся режиме второй почти
+// не растет.
+//
+// AddDevices (i=16) / RemoveDevices (i=17): добавление и удаление устройств без
+// перезапуска (см. DeviceFleet). AddDevices(DeviceType, Count) сразу возвращает
+// NodeId будущих устройств и номер Ticket; узлы появляются, когда
+// FleetChangesApplied (i=19) >= Ticket. FleetChangesEnqueued (i=18) - принято
+// запросов. Если места в ValueStore не хватит, AddDevices возвращает
+// BadResourceUnavailable, если кончились номера устройств (DeviceFleet::ID_LIMIT) -
+// BadOutOfRange. Методы и счетчики есть, только если передан парк устройств.
+class EquipmentControl : public OPCUANode {
+private:
+    ValueStore* store;
+    SetpointQueue* commands;
+    DeviceFleet* fleet;
+
+public:
+    static constexpr UA_UInt32 OBJECT_ID = 10;
+    static constexpr UA_UInt32 REGISTER_HANDLES_ID = 11;
+    static constexpr UA_UInt32 COMMANDS_ENQUEUED_ID = 12;
+    static constexpr UA_UInt32 COMMANDS_APPLIED_ID = 13;
+    static constexpr UA_UInt32 POOLED_ALLOCATIONS_ID = 14;
+    static constexpr UA_UInt32 SYSTEM_ALLOCATIONS_ID = 15;
+    static constexpr UA_UInt32 ADD_DEVICES_ID = 16;
+    static constexpr UA_UInt32 REMOVE_DEVICES_ID = 17;
+    static constexpr UA_UInt32 FLEET_ENQUEUED_ID = 18;
+    static constexpr UA_UInt32 FLEET_APPLIED_ID = 19;
+    static constexpr UA_UInt32 MAX_DEVICES_PER_CALL = 10000;
+
+    EquipmentControl(UA_Server* srv, UA_UInt16 nsIndex, DeviceFleet* deviceFleet = nullptr)
+        : OPCUANode(srv, UA_NODEID_NUMERIC(nsIndex, OBJECT_ID)),
+          store(&EquipmentNodestore::storeFor(srv)),
+          commands(&EquipmentNodestore::commandsFor(srv)),
+          fleet(deviceFleet) {}
+
+    void initialize() override {
+        UA_ObjectAttributes attr = UA_ObjectAttributes_default;
+
+        UALocalizedText displayNameText("en-US", "Управление оборудованием");
+        UALocalizedText descriptionText("en-US", "Служебные методы сервера оборудования");
+        UAQualifiedName qualifiedName(nodeId.namespaceIndex, "EquipmentControl");
+
+        attr.displayName = *displayNameText.get();
+        attr.description = *descriptionText.get();
+
+        UA_Server_addObjectNode(
+            server, nodeId,
+            UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+            UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+            *qualifiedName.get(),
+            UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+            attr, NULL, NULL);
+
+        addRegisterHandlesMethod();
+        addCounterVariable(COMMANDS_ENQUEUED_ID, "CommandsEnqueued", "Принято записей в уставки");
+        addCounterVariable(COMMANDS_APPLIED_ID, "CommandsApplied", "Применено записей в уставки");
+#ifdef SERVER_POOLED_ALLOCATOR
+        addCounterVariable(POOLED_ALLOCATIONS_ID, "PooledAllocations", "Выделений памяти из пула");
+        addCounterVariable(SYSTEM_ALLOCATIONS_ID, "SystemAllocations", "Выделений памяти системным malloc");
+#endif
+        if (fleet) {
+            addFleetMethods();
+            addCounterVariable(FLEET_ENQUEUED_ID, "FleetChangesEnqueued", "Принято запросов на добавление и удаление устройств");
+            addCounterVariable(FLEET_APPLIED_ID, "FleetChangesApplied", "Выполнено запросов на добавление и удаление устройств");
+        }
+    }
+
+private:
+    void addCounterVariable(UA_UInt32 id, const char* name, const char* description) {
+        UA_VariableAttributes attr = UA_VariableAttributes_default;
+        UALocalizedText displayNameText("en-US", name);
+        UALocalizedText descriptionText("en-US", description);
+        UAQualifiedName qualifiedName(nodeId.namespaceIndex, name);
+        attr.displayName = *displayNameText.get();
+        attr.description = *descriptionText.get();
+        attr.dataType = UA_TYPES[UA_TYPES_UINT64].typeId;
+        attr.valueRank = UA_VALUERANK_SCALAR;
+        attr.accessLevel = UA_ACCESSLEVELMASK_READ;
+        attr.userAccessLevel = UA_ACCESSLEVELMASK_READ;
+
+        UA_DataSource dataSource;
+        dataSource.read = &EquipmentControl::readCounter;
+        dataSource.write = NULL;
+
+        UA_Server_addDataSourceVariableNode(server, UA_NODEID_NUMERIC(nodeId.namespaceIndex, id),
+            nodeId,
+            UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+            *qualifiedName.get(),
+            UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+            attr, dataSource, this, NULL);
+    }
+
+    static UA_StatusCode readCounter(UA_Server*, const UA_NodeId*, void*, const UA_NodeId* counterId,
+                                     void* nodeContext, UA_Boolean, const UA_NumericRange* range,
+                                     UA_DataValue* value) {
+        EquipmentControl* self = static_cast<EquipmentControl*>(nodeContext);
+        if (!self) {
+            return UA_STATUSCODE_BADINTERNALERROR;
+        }
+        if (range) {
+            value->hasStatus = true;
+            value->status = UA_STATUSCODE_BADINDEXRANGEINVALID;
+            return UA_STATUSCODE_GOOD;
+        }
+        UA_UInt64 count = 0;
+        switch (counterId->identifier.numeric) {
+        case COMMANDS_ENQUEUED_ID: count = self->commands->enqueuedCount(); break;
+        case COMMANDS_APPLIED_ID: count = self->commands->appliedCount(); break;
+#ifdef SERVER_POOLED_ALLOCATOR
+        case POOLED_ALLOCATIONS_ID: count = PoolAllocator::snapshot().pooledAllocations; break;
+        case SYSTEM_ALLOCATIONS_ID: count = PoolAllocator::snapshot().systemAllocations; break;
+#endif
+        case FLEET_ENQUEUED_ID: count = self->fleet ? self->fleet->enqueuedCount() : 0; break;
+        case FLEET_APPLIED_ID: count = self->fleet ? self->fleet->appliedCount() : 0; break;
+        default: return UA_STATUSCODE_BADNODEIDUNKNOWN;
+        }
+        UA_StatusCode status = UA_Variant_setScalarCopy(&value->value, &count, &UA_TYPES[UA_TYPES_UINT64]);
+        value->hasValue = status == UA_STATUSCODE_GOOD;
+        return status;
+    }
+
+    void addRegisterHandlesMethod() {
+        UA_Argument input;
+        UA_Argument_init(&input);
+        input.name = UA_STRING(const_cast<char*>("NodesToRegister"));
+        input.dataType = UA_TYPES[UA_TYPES_NODEID].typeId;
+        input.valueRank = UA_VALUERANK_ONE_DIMENSION;
+
+        UA_Argument output;
+        UA_Argument_init(&output);
+        output.name = UA_STRING(const_cast<char*>("RegisteredNodeIds"));
+        output.dataType = UA_TYPES[UA_TYPES_NODEID].typeId;
+        output.valueRank = UA_VALUERANK_ONE_DIMENSION;
+
+        UA_MethodAttributes attr = UA_MethodAttributes_default;
+        UALocalizedText displayNameText("en-US", "RegisterHandles");
+        UALocalizedText descriptionText("en-US", "Выдает компактные ручки для переменных оборудования");
+        UAQualifiedName qualifiedName(nodeId.namespaceIndex, "RegisterHandles");
+        attr.displayName = *displayNameText.get();
+        attr.description = *descriptionText.get();
+        attr.executable = true;
+        attr.userExecutable = true;
+
+        UA_Server_addMethodNode(server, UA_NODEID_NUMERIC(nodeId.namespaceIndex, REGISTER_HANDLES_ID),
+            nodeId,
+            UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+            *qualifiedName.get(),
+            attr, &EquipmentControl::registerHandles,
+            1, &input, 1, &output, this, NULL);
+    }
+
+    static UA_StatusCode registerHandles(UA_Server*, const UA_NodeId*, void*, const UA_NodeId*,
+                                         void* methodContext, const UA_NodeId*, void*,
+                                         size_t inputSize, const UA_Variant* input,
+                                         size_t outputSize, UA_Variant* output) {
+        EquipmentControl* self = static_cast<EquipmentControl*>(methodContext);
+        if (!self || inputSize != 1 || outputSize != 1 ||
+            input[0].type != &UA_TYPES[UA_TYPES_NODEID]) {
+            return UA_STATUSCODE_BADINVALIDARGUMENT;
+        }
+
+        const UA_NodeId* nodes = static_cast<const UA_NodeId*>(input[0].data);
+        size_t count = UA_Variant_isScalar(&input[0]) ? 1 : input[0].arrayLength;
+
+        UA_NodeId* handles = static_cast<UA_NodeId*>(
+            UA_Array_new(count, &UA_TYPES[UA_TYPES_NODEID]));
+        if (!handles && count > 0) {
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            ValueStore::Slot slot;
+            if (self->store->findSlot(nodes[i], slot)) {
+                handles[i] = self->store->handleNodeId(slot);
+            } else {
+                UA_NodeId_copy(&nodes[i], &handles[i]);
+            }
+        }
+
+        UA_Variant_setArray(&output[0], handles, count, &UA_TYPES[UA_TYPES_NODEID]);
+        return UA_STATUSCODE_GOOD;
+    }
+
+    static UA_Argument argument(const char* name, UA_UInt32 typeIndex, UA_Int32 valueRank) {
+        UA_Argument arg;
+        UA_Argument_init(&arg);
+        arg.name = UA_STRING(const_cast<char*>(name));
+        arg.dataType = UA_TYPES[typeIndex].typeId;
+        arg.valueRank = valueRank;
+        return arg;
+    }
+
+    void addMethod(UA_UInt32 id, const char* name, const char* description, UA_MethodCallback callback,
+                   size_t inputSize, const UA_Argument* inputs, size_t outputSize, const UA_Argument* outputs) {
+        UA_MethodAttributes attr = UA_MethodAttributes_default;
+        UALocalizedText displayNameText("en-US", name);
+        UALocalizedText descriptionText("en-US", description);
+        UAQualifiedName qualifiedName(nodeId.namespaceIndex, name);
+        attr.displayName = *displayNameText.get();
+        attr.description = *descriptionText.get();
+        attr.executable = true;
+        attr.userExecutable = true;
+
+        UA_Server_addMethodNode(server, UA_NODEID_NUMERIC(nodeId.namespaceIndex, id),
+            nodeId,
+            UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+            *qualifiedName.get(),
+            attr, callback,
+            inputSize, inputs, outputSize, outputs, this, NULL);
+    }
+
+    void addFleetMethods() {
+        UA_Argument addInputs[2] = {
+            argument("DeviceType", UA_TYPES_STRING, UA_VALUERANK_SCALAR),
+            argument("Count", UA_TYPES_UINT32, UA_VALUERANK_SCALAR)
+        };
+        UA_Argument addOutputs[2] = {
+            argument("DeviceIds", UA_TYPES_NODEID, UA_VALUERANK_ONE_DIMENSION),
+            argument("Ticket", UA_TYPES_UINT64, UA_VALUERANK_SCALAR)
+        };
+        addMethod(ADD_DEVICES_ID, "AddDevices", "Добавляет устройства Multimeter, Machine или Computer",
+                  &EquipmentControl::addDevices, 2, addInputs, 2, addOutputs);
+
+        UA_Argument removeInput = argument("DeviceIds", UA_TYPES_NODEID, UA_VALUERANK_ONE_DIMENSION);
+        UA_Argument removeOutputs[2] = {
+            argument("Results", UA_TYPES_STATUSCODE, UA_VALUERANK_ONE_DIMENSION),
+            argument("Ticket", UA_TYPES_UINT64, UA_VALUERANK_SCALAR)
+        };
+        addMethod(REMOVE_DEVICES_ID, "RemoveDevices", "Удаляет устройства вместе с их узлами",
+                  &EquipmentControl::removeDevices, 1, &removeInput, 2, removeOutputs);
+    }
+
+    static UA_StatusCode addDevices(UA_Server*, const UA_NodeId*, void*, const UA_NodeId*,
+                                    void* methodContext, const UA_NodeId*, void*,
+                                    size_t inputSize, const UA_Variant* input,
+                                    size_t outputSize, UA_Variant* output) {
+        EquipmentControl* self = static_cast<EquipmentControl*>(methodContext);
+        if (!self || !self->fleet || inputSize != 2 || outputSize != 2 ||
+            !UA_Variant_hasScalarType(&input[0], &UA_TYPES[UA_TYPES_STRING]) ||
+            !UA_Variant_hasScalarType(&input[1], &UA_TYPES[UA_TYPES_UINT32])) {
+            return UA_STATUSCODE_BADINVALIDARGUMENT;
+        }
+
+        const UA_String* typeName = static_cast<const UA_String*>(input[0].data);
+        UA_UInt32 count = *static_cast<const UA_UInt32*>(input[1].data);
+        DeviceFleet::Kind kind;
+        if (!DeviceFleet::parseKind(std::string(reinterpret_cast<const char*>(typeName->data), typeName->length), kind) ||
+            count == 0 || count > MAX_DEVICES_PER_CALL) {
+            return UA_STATUSCODE_BADINVALIDARGUMENT;
+        }
+
+        std::vector<UA_UInt32> ids;
+        UA_UInt64 ticket = 0;
+        UA_StatusCode status = self->fleet->requestAdd(kind, count, ids, ticket);
+        if (status != UA_STATUSCODE_GOOD) {
+            return status;
+        }
+
+        UA_NodeId* deviceIds = static_cast<UA_NodeId*>(UA_Array_new(ids.size(), &UA_TYPES[UA_TYPES_NODEID]));
+        if (!deviceIds) {
+            return UA_STATUSCODE_BADOUTOFMEMORY; // устройства все равно будут созданы
+        }
+        for (size_t i = 0; i < ids.size(); ++i) {
+            deviceIds[i] = UA_NODEID_NUMERIC(self->nodeId.namespaceIndex, ids[i]);
+        }
+        UA_Variant_setArray(&output[0], deviceIds, ids.size(), &UA_TYPES[UA_TYPES_NODEID]);
+        return UA_Variant_setScalarCopy(&output[1], &ticket, &UA_TYPES[UA_TYPES_UINT64]);
+    }
+
+    static UA_StatusCode removeDevices(UA_Server*, const UA_NodeId*, void*, const UA_NodeId*,
+                                       void* methodContext, const UA_NodeId*, void*,
+                                       size_t inputSize, const UA_Variant* input,
+                                       size_t outputSize, UA_Variant* output) {
+        EquipmentControl* self = static_cast<EquipmentControl*>(methodContext);
+        if (!self || !self->fleet || inputSize != 1 || outputSize != 2 ||
+            input[0].type != &UA_TYPES[UA_TYPES_NODEID]) {
+            return UA_STATUSCODE_BADINVALIDARGUMENT;
+        }
+
+        const UA_NodeId* nodes = static_cast<const UA_NodeId*>(input[0].data);
+        size_t count = UA_Variant_isScalar(&input[0]) ? 1 : input[0].arrayLength;
+
+        UA_StatusCode* results = static_cast<UA_StatusCode*>(
+            UA_Array_new(count, &UA_TYPES[UA_TYPES_STATUSCODE]));
+        if (!results && count > 0) {
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        }
+
+        UA_UInt64 ticket = self->fleet->enqueuedCount();
+        for (size_t i = 0; i < count; ++i) {
+            uint64_t removeTicket = 0;
+            bool ours = nodes[i].namespaceIndex == self->nodeId.namespaceIndex &&
+                        nodes[i].identifierType == UA_NODEIDTYPE_NUMERIC;
+            if (ours && self->fleet->requestRemove(nodes[i].identifier.numeric, removeTicket)) {
+                results[i] = UA_STATUSCODE_GOOD;
+                ticket = removeTicket;
+            } else {
+                results[i] = UA_STATUSCODE_BADNODEIDUNKNOWN;
+            }
+        }
+
+        UA_Variant_setArray(&output[0], results, count, &UA_TYPES[UA_TYPES_STATUSCODE]);
+        return UA_Variant_setScalarCopy(&output[1], &ticket, &UA_TYPES[UA_TYPES_UINT64]);
+    }
+};
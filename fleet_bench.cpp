@@ -0,0 +1,465 @@
+#include <open62541/server_config_default.h>
+#include <open62541/client.h>
+#include <open62541/client_config_default.h>
+#include <open62541/client_highlevel.h>
+#include <open62541/plugin/log_stdout.h>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <stdexcept>
+
+#include "opcua_server.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// ============================== ПАРАМЕТРЫ ПРОГОНА ==============================
+// Рабочий OPCUAServer (ускоренные такты, без вывода в консоль) и клиенты работают
+// в одном процессе на loopback; такт и обслуживание сети те же, что в server.
+// Читающие клиенты непрерывно опрашивают переменные устройств по умолчанию, а
+// оператор через методы EquipmentControl добавляет и удаляет партии устройств. Для каждой фазы
+// печатаются скорость изменений (устройств в секунду от вызова метода до
+// FleetChangesApplied >= Ticket), задержки чтений клиентов и длительность
+// такта - видно, во что обходится изменение состава остальным клиентам.
+struct FleetBenchOptions {
+    int devices = 1000;
+    std::vector<int> perTick = {16, 64, 0};
+    int sessions = 4;
+    double tickMs = 10.0;
+    double phaseSec = 2.0;
+    UA_UInt16 port = 4843;
+    std::string kind = "Machine";
+};
+
+static const UA_UInt32 readVariableIds[] = {101, 102, 103, 104, 201, 202, 203, 204, 205, 206,
+                                            301, 302, 303, 304, 305, 306};
+
+// ============================== ЗАДЕРЖКИ ==============================
+class LatencyWindow {
+private:
+    std::mutex lock;
+    std::vector<uint64_t> samplesNs;
+
+public:
+    void record(uint64_t ns) {
+        std::lock_guard<std::mutex> guard(lock);
+        samplesNs.push_back(ns);
+    }
+
+    // Забирает накопленное за фазу; percentiles - p50, p99, max в мкс
+    size_t take(double percentiles[3]) {
+        std::vector<uint64_t> window;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            window.swap(samplesNs);
+        }
+        std::sort(window.begin(), window.end());
+        const double ranks[3] = {50.0, 99.0, 100.0};
+        for (int i = 0; i < 3; ++i) {
+            if (window.empty()) {
+                percentiles[i] = 0.0;
+                continue;
+            }
+            size_t index = static_cast<size_t>(ranks[i] / 100.0 * (window.size() - 1) + 0.5);
+            percentiles[i] = window[index] / 1000.0;
+        }
+        return window.size();
+    }
+};
+
+// ============================== КЛИЕНТЫ ==============================
+static UA_Client* connectClient(const std::string& url) {
+    UA_ClientConfig config;
+    memset(&config, 0, sizeof(UA_ClientConfig));
+    config.logging = UA_Log_Stdout_new(UA_LOGLEVEL_ERROR);
+    UA_ClientConfig_setDefault(&config);
+    UA_Client* client = UA_Client_newWithConfig(&config);
+    if (client && UA_Client_connect(client, url.c_str()) != UA_STATUSCODE_GOOD) {
+        UA_Client_delete(client);
+        client = nullptr;
+    }
+    return client;
+}
+
+// Одна сессия: чтение всех переменных устройств по умолчанию без пауз
+static void runReader(const std::string& url, UA_UInt16 ns, const std::atomic<bool>& stop,
+                      LatencyWindow& latencies, std::atomic<uint64_t>& errors) {
+    UA_Client* client = connectClient(url);
+    if (!client) {
+        errors++;
+        return;
+    }
+
+    std::vector<UA_ReadValueId> readIds;
+    for (UA_UInt32 id : readVariableIds) {
+        UA_ReadValueId item;
+        UA_ReadValueId_init(&item);
+        item.nodeId = UA_NODEID_NUMERIC(ns, id);
+        item.attributeId = UA_ATTRIBUTEID_VALUE;
+        readIds.push_back(item);
+    }
+
+    while (!stop) {
+        UA_ReadRequest request;
+        UA_ReadRequest_init(&request);
+        request.nodesToRead = readIds.data();
+        request.nodesToReadSize = readIds.size();
+        auto started = std::chrono::steady_clock::now();
+        UA_ReadResponse response = UA_Client_Service_read(client, request);
+        latencies.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - started).count()));
+        if (response.responseHeader.serviceResult != UA_STATUSCODE_GOOD) {
+            errors++;
+        }
+        UA_ReadResponse_clear(&response);
+    }
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+}
+
+// ============================== ОПЕРАТОР ==============================
+class FleetOperator {
+private:
+    UA_Client* client;
+    UA_UInt16 ns;
+
+    UA_StatusCode call(UA_UInt32 methodId, size_t inputSize, const UA_Variant* input,
+                       size_t& outputSize, UA_Variant*& output) {
+        return UA_Client_call(client, UA_NODEID_NUMERIC(ns, EquipmentControl::OBJECT_ID),
+                              UA_NODEID_NUMERIC(ns, methodId), inputSize, input, &outputSize, &output);
+    }
+
+public:
+    FleetOperator(const std::string& url, UA_UInt16 nsIndex) : client(connectClient(url)), ns(nsIndex) {
+        if (!client) {
+            throw std::runtime_error("Оператор не подключился к " + url);
+        }
+    }
+
+    ~FleetOperator() {
+        UA_Client_disconnect(client);
+        UA_Client_delete(client);
+    }
+
+    FleetOperator(const FleetOperator&) = delete;
+    FleetOperator& operator=(const FleetOperator&) = delete;
+
+    // AddDevices; ids дополняются NodeId новых устройств, возвращает Ticket или 0
+    uint64_t add(const std::string& kind, UA_UInt32 count, std::vector<UA_NodeId>& ids) {
+        UA_Variant input[2];
+        UA_String kindName = UA_STRING(const_cast<char*>(kind.c_str()));
+        UA_Variant_setScalar(&input[0], &kindName, &UA_TYPES[UA_TYPES_STRING]);
+        UA_Variant_setScalar(&input[1], &count, &UA_TYPES[UA_TYPES_UINT32]);
+
+        size_t outputSize = 0;
+        UA_Variant* output = nullptr;
+        uint64_t ticket = 0;
+        UA_StatusCode status = call(EquipmentControl::ADD_DEVICES_ID, 2, input, outputSize, output);
+        if (status == UA_STATUSCODE_GOOD && outputSize == 2 &&
+            UA_Variant_hasScalarType(&output[1], &UA_TYPES[UA_TYPES_UINT64])) {
+            const UA_NodeId* nodes = static_cast<const UA_NodeId*>(output[0].data);
+            for (size_t i = 0; i < output[0].arrayLength; ++i) {
+                ids.push_back(nodes[i]);
+            }
+            ticket = *static_cast<const UA_UInt64*>(output[1].data);
+        } else {
+            std::cerr << "AddDevices: " << UA_StatusCode_name(status) << std::endl;
+        }
+        UA_Array_delete(output, outputSize, &UA_TYPES[UA_TYPES_VARIANT]);
+        return ticket;
+    }
+
+    // RemoveDevices; возвращает Ticket или 0
+    uint64_t remove(const std::vector<UA_NodeId>& ids) {
+        UA_Variant input;
+        UA_Variant_setArray(&input, const_cast<UA_NodeId*>(ids.data()), ids.size(), &UA_TYPES[UA_TYPES_NODEID]);
+
+        size_t outputSize = 0;
+        UA_Variant* output = nullptr;
+        uint64_t ticket = 0;
+        UA_StatusCode status = call(EquipmentControl::REMOVE_DEVICES_ID, 1, &input, outputSize, output);
+        if (status == UA_STATUSCODE_GOOD && outputSize == 2 &&
+            UA_Variant_hasScalarType(&output[1], &UA_TYPES[UA_TYPES_UINT64])) {
+            ticket = *static_cast<const UA_UInt64*>(output[1].data);
+        } else {
+            std::cerr << "RemoveDevices: " << UA_StatusCode_name(status) << std::endl;
+        }
+        UA_Array_delete(output, outputSize, &UA_TYPES[UA_TYPES_VARIANT]);
+        return ticket;
+    }
+
+    // Ждет FleetChangesApplied >= ticket; false по таймауту
+    bool waitApplied(uint64_t ticket, std::chrono::seconds timeout) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (std::chrono::steady_clock::now() < deadline) {
+            UA_Variant value;
+            UA_Variant_init(&value);
+            UA_StatusCode status = UA_Client_readValueAttribute(
+                client, UA_NODEID_NUMERIC(ns, EquipmentControl::FLEET_APPLIED_ID), &value);
+            bool done = status == UA_STATUSCODE_GOOD &&
+                        UA_Variant_hasScalarType(&value, &UA_TYPES[UA_TYPES_UINT64]) &&
+                        *static_cast<const UA_UInt64*>(value.data) >= ticket;
+            UA_Variant_clear(&value);
+            if (done) {
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return false;
+    }
+};
+
+// ============================== ФАЗЫ ==============================
+struct PhaseResult {
+    std::string name;
+    int devices = 0;
+    double seconds = 0.0;
+    size_t reads = 0;
+    double readUs[3] = {0.0, 0.0, 0.0};
+    double tickUs[3] = {0.0, 0.0, 0.0};
+};
+
+static void printPhase(const PhaseResult& r) {
+    std::cout << std::left << std::setw(18) << r.name << std::right << std::fixed
+              << std::setw(8) << r.devices << std::setprecision(3) << std::setw(9) << r.seconds
+              << std::setprecision(0) << std::setw(11);
+    if (r.devices > 0 && r.seconds > 0.0) {
+        std::cout << r.devices / r.seconds;
+    } else {
+        std::cout << "-";
+    }
+    std::cout << std::setw(9) << r.reads << std::setprecision(1)
+              << std::setw(10) << r.readUs[0] << std::setw(10) << r.readUs[1] << std::setw(10) << r.readUs[2]
+              << std::setw(10) << r.tickUs[1] << std::setw(10) << r.tickUs[2] << std::endl;
+}
+
+static std::vector<int> parseList(const std::string& text) {
+    std::vector<int> values;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) values.push_back(std::max(0, std::atoi(item.c_str())));
+    }
+    return values;
+}
+
+// ============================== ГРАНИЦА НОМЕРОВ ==============================
+// Номера устройств выдаются блоками по ID_STEP до DeviceFleet::ID_LIMIT. Дойти до
+// границы настоящими вызовами - миллионы устройств, поэтому парк на отдельном,
+// не запущенном сервере начинается за два блока до нее. Узлы не создаются:
+// проверяется только выдача номеров.
+static bool checkIdLimit() {
+    UA_ServerConfig config;
+    memset(&config, 0, sizeof(UA_ServerConfig));
+    config.logging = UA_Log_Stdout_new(UA_LOGLEVEL_WARNING);
+    UA_ServerConfig_setMinimal(&config, 0, NULL);
+    UA_Server* server = UA_Server_newWithConfig(&config);
+    if (!server) {
+        return false;
+    }
+
+    bool ok = false;
+    {
+        DeviceFleet fleet(server, UA_Server_addNamespace(server, "EquipmentNamespace"), 0,
+                          DeviceFleet::ID_LIMIT - 2 * DeviceFleet::ID_STEP);
+        std::vector<UA_UInt32> ids;
+        uint64_t ticket = 0;
+        // Три блока не помещаются и не должны занять ни одного номера
+        UA_StatusCode tooMany = fleet.requestAdd(DeviceFleet::Kind::Machine, 3, ids, ticket);
+        UA_StatusCode lastTwo = fleet.requestAdd(DeviceFleet::Kind::Machine, 2, ids, ticket);
+        bool lastBlock = ids.size() == 2 && ids.back() + DeviceFleet::ID_STEP == DeviceFleet::ID_LIMIT;
+        UA_StatusCode beyond = fleet.requestAdd(DeviceFleet::Kind::Machine, 1, ids, ticket);
+
+        ok = tooMany == UA_STATUSCODE_BADOUTOFRANGE && lastTwo == UA_STATUSCODE_GOOD && lastBlock &&
+             beyond == UA_STATUSCODE_BADOUTOFRANGE;
+        if (!ok) {
+            std::cerr << "Граница номеров устройств: 3 блока - " << UA_StatusCode_name(tooMany)
+                      << ", 2 последних - " << UA_StatusCode_name(lastTwo)
+                      << (lastBlock ? "" : " (не те номера)")
+                      << ", за границей - " << UA_StatusCode_name(beyond) << std::endl;
+        }
+    }
+    UA_Server_delete(server);
+    return ok;
+}
+
+static void printUsage() {
+    std::cout << "Usage: server_fleet_bench [--devices <n>] [--per-tick <n,...>] [--sessions <n>]\n"
+                 "                          [--tick-ms <ms>] [--phase-sec <s>] [--port <n>]\n"
+                 "                          [--kind Multimeter|Machine|Computer]\n"
+                 "  --per-tick  устройств за такт для каждого прогона, 0 - без ограничения"
+              << std::endl;
+}
+
+// ============================== ТОЧКА ВХОДА ==============================
+int main(int argc, char** argv) {
+#ifdef _WIN32
+    SetConsoleOutputCP(CP_UTF8);
+#endif
+
+    FleetBenchOptions options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--devices" && hasValue) options.devices = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--per-tick" && hasValue) options.perTick = parseList(argv[++i]);
+        else if (arg == "--sessions" && hasValue) options.sessions = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--tick-ms" && hasValue) options.tickMs = std::max(1.0, std::atof(argv[++i]));
+        else if (arg == "--phase-sec" && hasValue) options.phaseSec = std::max(0.1, std::atof(argv[++i]));
+        else if (arg == "--port" && hasValue) options.port = static_cast<UA_UInt16>(std::atoi(argv[++i]));
+        else if (arg == "--kind" && hasValue) options.kind = argv[++i];
+        else {
+            printUsage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+    DeviceFleet::Kind kind;
+    if (options.perTick.empty() || !DeviceFleet::parseKind(options.kind, kind)) {
+        printUsage();
+        return 1;
+    }
+
+    if (!checkIdLimit()) {
+        return 1;
+    }
+
+    bool failed = false;
+    try {
+        LatencyWindow readLatencies;
+        LatencyWindow tickLatencies;
+        std::atomic<uint64_t> errors(0);
+        std::atomic<bool> stop(false);
+        const std::string url = "opc.tcp://localhost:" + std::to_string(options.port);
+
+        OPCUAServer server;
+        server.setPort(options.port);
+        server.setLogLevel(UA_LOGLEVEL_WARNING);
+        server.setFleetChangesPerTick(static_cast<size_t>(options.perTick.front()));
+        if (!server.initialize() || !server.start()) {
+            std::cerr << "Не удалось запустить сервер" << std::endl;
+            return 1;
+        }
+        server.setTickPeriod(std::chrono::microseconds(static_cast<long long>(options.tickMs * 1000.0)));
+        server.setConsoleOutput(false);
+        server.setTickObserver([&tickLatencies](uint64_t ns) { tickLatencies.record(ns); });
+        const UA_UInt16 ns = server.getNamespaceIndex();
+
+        std::thread serverThread([&server]() { server.run(); });
+        std::vector<std::thread> readers;
+        for (int i = 0; i < options.sessions; ++i) {
+            readers.emplace_back(runReader, std::cref(url), ns, std::cref(stop),
+                                 std::ref(readLatencies), std::ref(errors));
+        }
+
+        std::cout << "Устройств в партии: " << options.devices << " (" << options.kind << "), такт "
+                  << options.tickMs << " мс, читающих сессий " << options.sessions << "\n" << std::endl;
+        std::cout << std::left << std::setw(18) << "phase" << std::right << std::setw(8) << "devices"
+                  << std::setw(9) << "sec" << std::setw(11) << "devices/s" << std::setw(9) << "reads"
+                  << std::setw(10) << "read p50" << std::setw(10) << "read p99" << std::setw(10) << "read max"
+                  << std::setw(10) << "tick p99" << std::setw(10) << "tick max" << std::endl;
+
+        using Clock = std::chrono::steady_clock;
+        const auto phaseDuration = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(options.phaseSec));
+        const auto timeout = std::chrono::seconds(120);
+
+        // Фаза заканчивается снятием окон задержек
+        auto finishPhase = [&](PhaseResult& r, Clock::time_point started) {
+            r.seconds = std::chrono::duration<double>(Clock::now() - started).count();
+            r.reads = readLatencies.take(r.readUs);
+            tickLatencies.take(r.tickUs);
+            printPhase(r);
+        };
+        auto idlePhase = [&](const std::string& name) {
+            PhaseResult r;
+            r.name = name;
+            readLatencies.take(r.readUs);
+            tickLatencies.take(r.tickUs);
+            auto started = Clock::now();
+            std::this_thread::sleep_for(phaseDuration);
+            finishPhase(r, started);
+        };
+
+        // Исключение здесь не должно оставить потоки без join
+        auto runPhases = [&]() -> bool {
+            FleetOperator op(url, ns);
+            std::this_thread::sleep_for(phaseDuration); // подключение читателей
+            idlePhase("baseline");
+
+            for (int perTick : options.perTick) {
+                server.setFleetChangesPerTick(static_cast<size_t>(perTick));
+                std::string suffix = perTick == 0 ? "/all" : "/" + std::to_string(perTick);
+
+                PhaseResult add;
+                add.name = "add" + suffix;
+                add.devices = options.devices;
+                readLatencies.take(add.readUs);
+                tickLatencies.take(add.tickUs);
+                std::vector<UA_NodeId> ids;
+                auto started = Clock::now();
+                uint64_t ticket = 0;
+                for (int left = options.devices; left > 0 && !failed; ) {
+                    UA_UInt32 count = static_cast<UA_UInt32>(
+                        std::min<int>(left, static_cast<int>(EquipmentControl::MAX_DEVICES_PER_CALL)));
+                    ticket = op.add(options.kind, count, ids);
+                    failed = ticket == 0;
+                    left -= static_cast<int>(count);
+                }
+                if (failed || !op.waitApplied(ticket, timeout)) {
+                    std::cerr << "Устройства не добавлены" << std::endl;
+                    failed = true;
+                    break;
+                }
+                finishPhase(add, started);
+
+                idlePhase("steady" + suffix);
+
+                PhaseResult remove;
+                remove.name = "remove" + suffix;
+                remove.devices = static_cast<int>(ids.size());
+                readLatencies.take(remove.readUs);
+                tickLatencies.take(remove.tickUs);
+                started = Clock::now();
+                ticket = op.remove(ids);
+                if (ticket == 0 || !op.waitApplied(ticket, timeout)) {
+                    std::cerr << "Устройства не удалены" << std::endl;
+                    failed = true;
+                    break;
+                }
+                finishPhase(remove, started);
+            }
+            return !failed;
+        };
+        try {
+            failed = !runPhases();
+        } catch (const std::exception& e) {
+            std::cerr << "Исключение: " << e.what() << std::endl;
+            failed = true;
+        }
+
+        stop = true;
+        for (auto& t : readers) t.join();
+        server.requestStop();
+        serverThread.join();
+
+        std::cout << "\nОшибок чтения: " << errors.load() << std::endl;
+        server.printTickReport();
+        server.stop();
+        failed = failed || errors.load() > 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Исключение: " << e.what() << std::endl;
+        return 1;
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,1683 @@
+#include <open62541/client.h>
+#include <open62541/client_config_default.h>
+#include <open62541/client_highlevel.h>
+#include <open62541/client_subscriptions.h>
+#include <open62541/plugin/log_stdout.h>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <random>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#ifdef __linux__
+#include <unistd.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+// ============================== ПАРАМЕТРЫ НАГРУЗКИ ==============================
+// WRITE_EFFECT - не сервис, а время от начала записи уставки до ее применения
+// симуляцией (по счетчикам CommandsEnqueued/CommandsApplied)
+enum ServiceKind { SERVICE_READ = 0, SERVICE_BROWSE, SERVICE_TRANSLATE, SERVICE_WRITE, SERVICE_COUNT,
+                   WRITE_EFFECT = SERVICE_COUNT, STAT_COUNT };
+
+static const char* serviceNames[STAT_COUNT] = {"Read", "Browse", "TranslateBrowsePathsToNodeIds",
+                                               "Write", "WriteToEffect"};
+
+// Сборка сервера для --server: имя в таблице и команда запуска (порт добавляется сам)
+struct ServerBuild {
+    std::string name;
+    std::vector<std::string> command;
+};
+
+struct LoadOptions {
+    std::string url = "opc.tcp://localhost:4840";
+    int sessions = 4;
+    double durationSec = 10.0;
+    double warmupSec = 1.0;
+    size_t readBatch = 100;
+    double weights[SERVICE_COUNT] = {80.0, 10.0, 10.0, 0.0};
+    int effectEvery = 10;        // каждая N-я запись ждет применения уставки
+    bool useHandles = false;     // читать по ручкам из EquipmentControl::RegisterHandles
+    bool compareHandles = false; // два прогона: по NodeId и по ручкам
+    bool waveform = false;       // подписка на осциллограммы вместо запросов
+    double publishIntervalMs = 50.0;
+    std::vector<double> samplingMs; // --monitor: прогон подписки для каждого SamplingInterval
+    int serverPid = 0;              // процессорное время и системные вызовы сервера (Linux)
+    std::vector<int> scaleSessions; // --scale: прогон чтения для каждого числа сессий
+    std::vector<ServerBuild> servers; // --server: --scale для каждой сборки, сервер запускается здесь
+    std::string jsonPath;
+};
+
+// ============================== МОДЕЛЬ ОБОРУДОВАНИЯ НА СЕРВЕРЕ ==============================
+// Обнаруживается одним клиентом перед запуском нагрузки: устройства в ObjectsFolder
+// из пространства имен EquipmentNamespace и их компоненты.
+struct EquipmentVariable {
+    UA_NodeId nodeId;
+    UA_NodeId handle; // ручка для быстрого доступа (или копия nodeId)
+    std::string browseName;
+    double sampleRate = 0.0; // свойство SampleRate у осциллограмм, 0 - скаляр
+    bool setpoint = false;   // уставка: есть свойство EURange, доступна запись
+    double low = 0.0;
+    double high = 0.0;
+    const UA_DataType* type = nullptr;
+};
+
+struct EquipmentDevice {
+    UA_NodeId nodeId;
+    std::string browseName;
+    std::vector<EquipmentVariable> variables;
+};
+
+struct EquipmentModel {
+    UA_UInt16 namespaceIndex = 0;
+    UA_NodeId controlId = UA_NODEID_NULL;         // объект EquipmentControl
+    UA_NodeId registerHandlesId = UA_NODEID_NULL; // его метод RegisterHandles
+    UA_NodeId commandsEnqueuedId = UA_NODEID_NULL;
+    UA_NodeId commandsAppliedId = UA_NODEID_NULL;
+    std::vector<EquipmentDevice> devices;
+
+    size_t setpointCount() const {
+        size_t n = 0;
+        for (const auto& d : devices) {
+            for (const auto& v : d.variables) n += v.setpoint ? 1 : 0;
+        }
+        return n;
+    }
+
+    size_t variableCount() const {
+        size_t n = 0;
+        for (const auto& d : devices) n += d.variables.size();
+        return n;
+    }
+};
+
+static std::string toStdString(const UA_String& s) {
+    return std::string(reinterpret_cast<const char*>(s.data), s.length);
+}
+
+static UA_Client* connectClient(const std::string& url) {
+    UA_ClientConfig config;
+    memset(&config, 0, sizeof(UA_ClientConfig));
+    config.logging = UA_Log_Stdout_new(UA_LOGLEVEL_WARNING);
+    UA_ClientConfig_setDefault(&config);
+    config.timeout = 30000;
+
+    UA_Client* client = UA_Client_newWithConfig(&config);
+    if (!client) {
+        return nullptr;
+    }
+    if (UA_Client_connect(client, url.c_str()) != UA_STATUSCODE_GOOD) {
+        UA_Client_delete(client);
+        return nullptr;
+    }
+    return client;
+}
+
+// Возвращает ссылки HasComponent/Organizes указанного узла в пространстве имен ns
+static std::vector<UA_ReferenceDescription> browseChildren(UA_Client* client, const UA_NodeId& node,
+                                                           UA_UInt16 ns, UA_NodeClass nodeClass) {
+    std::vector<UA_ReferenceDescription> children;
+
+    UA_BrowseRequest request;
+    UA_BrowseRequest_init(&request);
+    UA_BrowseDescription description;
+    UA_BrowseDescription_init(&description);
+    description.nodeId = node;
+    description.browseDirection = UA_BROWSEDIRECTION_FORWARD;
+    description.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_HIERARCHICALREFERENCES);
+    description.includeSubtypes = true;
+    description.nodeClassMask = nodeClass;
+    description.resultMask = UA_BROWSERESULTMASK_ALL;
+    request.nodesToBrowse = &description;
+    request.nodesToBrowseSize = 1;
+
+    UA_BrowseResponse response = UA_Client_Service_browse(client, request);
+    if (response.responseHeader.serviceResult == UA_STATUSCODE_GOOD && response.resultsSize == 1) {
+        const UA_BrowseResult& result = response.results[0];
+        for (size_t i = 0; i < result.referencesSize; ++i) {
+            if (result.references[i].nodeId.nodeId.namespaceIndex != ns) continue;
+            UA_ReferenceDescription copy;
+            UA_ReferenceDescription_copy(&result.references[i], &copy);
+            children.push_back(copy);
+        }
+    }
+    UA_BrowseResponse_clear(&response);
+    return children;
+}
+
+// Свойства переменной: SampleRate у осциллограмм, EURange у уставок
+static void readProperties(UA_Client* client, UA_UInt16 ns, EquipmentVariable& variable) {
+    auto properties = browseChildren(client, variable.nodeId, ns, UA_NODECLASS_VARIABLE);
+    for (auto& p : properties) {
+        std::string name = toStdString(p.browseName.name);
+        UA_Variant value;
+        UA_Variant_init(&value);
+        if ((name == "SampleRate" || name == "EURange") &&
+            UA_Client_readValueAttribute(client, p.nodeId.nodeId, &value) == UA_STATUSCODE_GOOD) {
+            if (name == "SampleRate" && UA_Variant_hasScalarType(&value, &UA_TYPES[UA_TYPES_DOUBLE])) {
+                variable.sampleRate = *static_cast<const UA_Double*>(value.data);
+            } else if (name == "EURange" && UA_Variant_hasScalarType(&value, &UA_TYPES[UA_TYPES_RANGE])) {
+                const UA_Range* range = static_cast<const UA_Range*>(value.data);
+                variable.setpoint = true;
+                variable.low = range->low;
+                variable.high = range->high;
+            }
+        }
+        UA_Variant_clear(&value);
+        UA_ReferenceDescription_clear(&p);
+    }
+
+    // Для записи нужен точный тип значения уставки
+    if (variable.setpoint) {
+        UA_Variant value;
+        UA_Variant_init(&value);
+        if (UA_Client_readValueAttribute(client, variable.nodeId, &value) == UA_STATUSCODE_GOOD &&
+            UA_Variant_isScalar(&value)) {
+            variable.type = value.type;
+        }
+        variable.setpoint = variable.type != nullptr;
+        UA_Variant_clear(&value);
+    }
+}
+
+static bool discoverEquipment(const std::string& url, EquipmentModel& model) {
+    UA_Client* client = connectClient(url);
+    if (!client) {
+        std::cerr << "Не удалось подключиться к " << url << std::endl;
+        return false;
+    }
+
+    UA_String uri = UA_STRING(const_cast<char*>("EquipmentNamespace"));
+    if (UA_Client_NamespaceGetIndex(client, &uri, &model.namespaceIndex) != UA_STATUSCODE_GOOD) {
+        std::cerr << "Пространство имен EquipmentNamespace не найдено" << std::endl;
+        UA_Client_disconnect(client);
+        UA_Client_delete(client);
+        return false;
+    }
+
+    auto devices = browseChildren(client, UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                  model.namespaceIndex, UA_NODECLASS_OBJECT);
+    for (auto& ref : devices) {
+        // Служебный объект с методами - не устройство
+        if (toStdString(ref.browseName.name) == "EquipmentControl") {
+            UA_NodeId_copy(&ref.nodeId.nodeId, &model.controlId);
+            auto methods = browseChildren(client, model.controlId, model.namespaceIndex,
+                                          UA_NODECLASS_METHOD);
+            for (auto& m : methods) {
+                if (toStdString(m.browseName.name) == "RegisterHandles") {
+                    UA_NodeId_copy(&m.nodeId.nodeId, &model.registerHandlesId);
+                }
+                UA_ReferenceDescription_clear(&m);
+            }
+            auto counters = browseChildren(client, model.controlId, model.namespaceIndex,
+                                           UA_NODECLASS_VARIABLE);
+            for (auto& c : counters) {
+                std::string name = toStdString(c.browseName.name);
+                if (name == "CommandsEnqueued") UA_NodeId_copy(&c.nodeId.nodeId, &model.commandsEnqueuedId);
+                if (name == "CommandsApplied") UA_NodeId_copy(&c.nodeId.nodeId, &model.commandsAppliedId);
+                UA_ReferenceDescription_clear(&c);
+            }
+            UA_ReferenceDescription_clear(&ref);
+            continue;
+        }
+
+        EquipmentDevice device;
+        UA_NodeId_copy(&ref.nodeId.nodeId, &device.nodeId);
+        device.browseName = toStdString(ref.browseName.name);
+
+        auto variables = browseChildren(client, device.nodeId, model.namespaceIndex,
+                                        UA_NODECLASS_VARIABLE);
+        for (auto& varRef : variables) {
+            EquipmentVariable variable;
+            UA_NodeId_copy(&varRef.nodeId.nodeId, &variable.nodeId);
+            UA_NodeId_copy(&varRef.nodeId.nodeId, &variable.handle);
+            variable.browseName = toStdString(varRef.browseName.name);
+            readProperties(client, model.namespaceIndex, variable);
+            device.variables.push_back(variable);
+            UA_ReferenceDescription_clear(&varRef);
+        }
+        if (!device.variables.empty()) {
+            model.devices.push_back(device);
+        } else {
+            UA_NodeId_clear(&device.nodeId);
+        }
+        UA_ReferenceDescription_clear(&ref);
+    }
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+    return model.variableCount() > 0;
+}
+
+// Получает ручки для всех переменных вызовом EquipmentControl::RegisterHandles
+static bool registerHandles(const std::string& url, EquipmentModel& model) {
+    if (UA_NodeId_isNull(&model.registerHandlesId)) {
+        std::cerr << "Метод RegisterHandles не найден на сервере" << std::endl;
+        return false;
+    }
+
+    UA_Client* client = connectClient(url);
+    if (!client) {
+        return false;
+    }
+
+    std::vector<UA_NodeId> ids;
+    for (const auto& d : model.devices) {
+        for (const auto& v : d.variables) ids.push_back(v.nodeId);
+    }
+
+    UA_Variant input;
+    UA_Variant_setArray(&input, ids.data(), ids.size(), &UA_TYPES[UA_TYPES_NODEID]);
+    size_t outputSize = 0;
+    UA_Variant* output = nullptr;
+    UA_StatusCode status = UA_Client_call(client, model.controlId, model.registerHandlesId,
+                                          1, &input, &outputSize, &output);
+
+    bool ok = status == UA_STATUSCODE_GOOD && outputSize == 1 &&
+              output[0].type == &UA_TYPES[UA_TYPES_NODEID] && output[0].arrayLength == ids.size();
+    if (ok) {
+        const UA_NodeId* handles = static_cast<const UA_NodeId*>(output[0].data);
+        size_t i = 0;
+        for (auto& d : model.devices) {
+            for (auto& v : d.variables) {
+                UA_NodeId_clear(&v.handle);
+                UA_NodeId_copy(&handles[i++], &v.handle);
+            }
+        }
+    } else {
+        std::cerr << "Ошибка вызова RegisterHandles: " << UA_StatusCode_name(status) << std::endl;
+    }
+
+    UA_Array_delete(output, outputSize, &UA_TYPES[UA_TYPES_VARIANT]);
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+    return ok;
+}
+
+// ============================== ЗАПРОСЫ ==============================
+// Запросы собираются один раз на сессию и переиспользуются в цикле нагрузки
+// Значение уставки в ее собственном типе
+union NumericValue {
+    UA_Boolean b;
+    UA_SByte i8;
+    UA_Byte u8;
+    UA_Int16 i16;
+    UA_UInt16 u16;
+    UA_Int32 i32;
+    UA_UInt32 u32;
+    UA_Int64 i64;
+    UA_UInt64 u64;
+    UA_Float f;
+    UA_Double d;
+};
+
+static bool encodeNumeric(const UA_DataType* type, double value, NumericValue& out) {
+    switch (type->typeKind) {
+    case UA_DATATYPEKIND_BOOLEAN: out.b = value != 0.0; return true;
+    case UA_DATATYPEKIND_SBYTE: out.i8 = static_cast<UA_SByte>(std::llround(value)); return true;
+    case UA_DATATYPEKIND_BYTE: out.u8 = static_cast<UA_Byte>(std::llround(value)); return true;
+    case UA_DATATYPEKIND_INT16: out.i16 = static_cast<UA_Int16>(std::llround(value)); return true;
+    case UA_DATATYPEKIND_UINT16: out.u16 = static_cast<UA_UInt16>(std::llround(value)); return true;
+    case UA_DATATYPEKIND_INT32: out.i32 = static_cast<UA_Int32>(std::llround(value)); return true;
+    case UA_DATATYPEKIND_UINT32: out.u32 = static_cast<UA_UInt32>(std::llround(value)); return true;
+    case UA_DATATYPEKIND_INT64: out.i64 = static_cast<UA_Int64>(std::llround(value)); return true;
+    case UA_DATATYPEKIND_UINT64: out.u64 = static_cast<UA_UInt64>(std::llround(value)); return true;
+    case UA_DATATYPEKIND_FLOAT: out.f = static_cast<UA_Float>(value); return true;
+    case UA_DATATYPEKIND_DOUBLE: out.d = value; return true;
+    default: return false;
+    }
+}
+
+class RequestSet {
+public:
+    std::vector<UA_ReadValueId> readIds;
+    std::vector<const EquipmentVariable*> setpoints;
+    std::mt19937 rng;
+    std::vector<UA_BrowseDescription> browseDescriptions;
+    std::vector<UA_BrowsePath> browsePaths;
+    std::vector<UA_RelativePathElement> pathElements;
+    uint64_t lastBadItems = 0; // элементы последнего ответа с плохим статусом
+
+    RequestSet(const EquipmentModel& model, size_t readBatch, bool useHandles, unsigned seed)
+        : rng(seed) {
+        std::vector<const EquipmentVariable*> all;
+        for (const auto& d : model.devices) {
+            for (const auto& v : d.variables) {
+                all.push_back(&v);
+                if (v.setpoint) setpoints.push_back(&v);
+            }
+        }
+
+        // Пакет чтения: скалярные переменные оборудования по кругу до нужного
+        // размера. Осциллограммы (тысячи отсчетов) в пакет не входят: их
+        // копирование заслонило бы разницу между NodeId и ручками
+        std::vector<const EquipmentVariable*> scalars;
+        for (const EquipmentVariable* v : all) {
+            if (v->sampleRate == 0.0) scalars.push_back(v);
+        }
+        if (scalars.empty()) scalars = all;
+        readIds.resize(readBatch);
+        for (size_t i = 0; i < readBatch; ++i) {
+            UA_ReadValueId_init(&readIds[i]);
+            const EquipmentVariable* v = scalars[i % scalars.size()];
+            readIds[i].nodeId = useHandles ? v->handle : v->nodeId;
+            readIds[i].attributeId = UA_ATTRIBUTEID_VALUE;
+        }
+
+        // Обход всего дерева оборудования: ObjectsFolder и все устройства
+        UA_BrowseDescription root;
+        UA_BrowseDescription_init(&root);
+        root.nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+        browseDescriptions.push_back(root);
+        for (const auto& d : model.devices) {
+            UA_BrowseDescription bd;
+            UA_BrowseDescription_init(&bd);
+            bd.nodeId = d.nodeId;
+            browseDescriptions.push_back(bd);
+        }
+        for (auto& bd : browseDescriptions) {
+            bd.browseDirection = UA_BROWSEDIRECTION_FORWARD;
+            bd.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_HIERARCHICALREFERENCES);
+            bd.includeSubtypes = true;
+            bd.resultMask = UA_BROWSERESULTMASK_ALL;
+        }
+
+        // Пути Objects/<Устройство>/<Переменная> для каждой переменной
+        pathElements.resize(all.size() * 2);
+        browsePaths.resize(all.size());
+        size_t p = 0;
+        for (const auto& d : model.devices) {
+            for (const auto& v : d.variables) {
+                UA_RelativePathElement* elems = &pathElements[p * 2];
+                for (int k = 0; k < 2; ++k) {
+                    UA_RelativePathElement_init(&elems[k]);
+                    elems[k].referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_HIERARCHICALREFERENCES);
+                    elems[k].includeSubtypes = true;
+                }
+                elems[0].targetName.namespaceIndex = model.namespaceIndex;
+                elems[0].targetName.name = UA_STRING(const_cast<char*>(d.browseName.c_str()));
+                elems[1].targetName.namespaceIndex = model.namespaceIndex;
+                elems[1].targetName.name = UA_STRING(const_cast<char*>(v.browseName.c_str()));
+
+                UA_BrowsePath_init(&browsePaths[p]);
+                browsePaths[p].startingNode = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+                browsePaths[p].relativePath.elements = elems;
+                browsePaths[p].relativePath.elementsSize = 2;
+                ++p;
+            }
+        }
+    }
+
+    // Запросы не владеют памятью: массивы принадлежат RequestSet. Запрос
+    // успешен, только если успешны сервис и каждый элемент ответа
+    bool execute(UA_Client* client, ServiceKind kind) {
+        UA_StatusCode result = UA_STATUSCODE_BADINTERNALERROR;
+        lastBadItems = 0;
+        switch (kind) {
+        case SERVICE_READ: {
+            UA_ReadRequest request;
+            UA_ReadRequest_init(&request);
+            request.nodesToRead = readIds.data();
+            request.nodesToReadSize = readIds.size();
+            request.timestampsToReturn = UA_TIMESTAMPSTORETURN_NEITHER;
+            UA_ReadResponse response = UA_Client_Service_read(client, request);
+            result = response.responseHeader.serviceResult;
+            if (result == UA_STATUSCODE_GOOD) {
+                lastBadItems = countBadItems(response.resultsSize, readIds.size(), [&](size_t i) {
+                    return response.results[i].hasStatus ? response.results[i].status : UA_STATUSCODE_GOOD;
+                });
+            }
+            UA_ReadResponse_clear(&response);
+            break;
+        }
+        case SERVICE_BROWSE: {
+            UA_BrowseRequest request;
+            UA_BrowseRequest_init(&request);
+            request.nodesToBrowse = browseDescriptions.data();
+            request.nodesToBrowseSize = browseDescriptions.size();
+            UA_BrowseResponse response = UA_Client_Service_browse(client, request);
+            result = response.responseHeader.serviceResult;
+            if (result == UA_STATUSCODE_GOOD) {
+                lastBadItems = countBadItems(response.resultsSize, browseDescriptions.size(),
+                                             [&](size_t i) { return response.results[i].statusCode; });
+            }
+            UA_BrowseResponse_clear(&response);
+            break;
+        }
+        case SERVICE_TRANSLATE: {
+            UA_TranslateBrowsePathsToNodeIdsRequest request;
+            UA_TranslateBrowsePathsToNodeIdsRequest_init(&request);
+            request.browsePaths = browsePaths.data();
+            request.browsePathsSize = browsePaths.size();
+            UA_TranslateBrowsePathsToNodeIdsResponse response =
+                UA_Client_Service_translateBrowsePathsToNodeIds(client, request);
+            result = response.responseHeader.serviceResult;
+            if (result == UA_STATUSCODE_GOOD) {
+                lastBadItems = countBadItems(response.resultsSize, browsePaths.size(),
+                                             [&](size_t i) { return response.results[i].statusCode; });
+            }
+            UA_TranslateBrowsePathsToNodeIdsResponse_clear(&response);
+            break;
+        }
+        case SERVICE_WRITE: {
+            // Случайная уставка, случайное значение из ее диапазона
+            if (setpoints.empty()) break;
+            const EquipmentVariable* target = setpoints[rng() % setpoints.size()];
+            std::uniform_real_distribution<double> dist(target->low, target->high);
+            NumericValue number;
+            if (!encodeNumeric(target->type, dist(rng), number)) break;
+
+            UA_WriteValue writeValue;
+            UA_WriteValue_init(&writeValue);
+            writeValue.nodeId = target->nodeId;
+            writeValue.attributeId = UA_ATTRIBUTEID_VALUE;
+            writeValue.value.hasValue = true;
+            UA_Variant_setScalar(&writeValue.value.value, &number, target->type);
+
+            UA_WriteRequest request;
+            UA_WriteRequest_init(&request);
+            request.nodesToWrite = &writeValue;
+            request.nodesToWriteSize = 1;
+            UA_WriteResponse response = UA_Client_Service_write(client, request);
+            result = response.responseHeader.serviceResult;
+            if (result == UA_STATUSCODE_GOOD && response.resultsSize == 1) {
+                result = response.results[0];
+            }
+            UA_WriteResponse_clear(&response);
+            break;
+        }
+        default:
+            break;
+        }
+        return result == UA_STATUSCODE_GOOD && lastBadItems == 0;
+    }
+
+private:
+    // Недостающие элементы ответа тоже считаются ошибочными
+    template <typename StatusOf>
+    static uint64_t countBadItems(size_t received, size_t expected, StatusOf statusOf) {
+        uint64_t bad = received < expected ? expected - received : 0;
+        for (size_t i = 0; i < received; ++i) {
+            if (statusOf(i) != UA_STATUSCODE_GOOD) ++bad;
+        }
+        return bad;
+    }
+};
+
+static bool readCounter(UA_Client* client, const UA_NodeId& nodeId, UA_UInt64& out) {
+    UA_Variant value;
+    UA_Variant_init(&value);
+    bool ok = UA_Client_readValueAttribute(client, nodeId, &value) == UA_STATUSCODE_GOOD &&
+              UA_Variant_hasScalarType(&value, &UA_TYPES[UA_TYPES_UINT64]);
+    if (ok) out = *static_cast<const UA_UInt64*>(value.data);
+    UA_Variant_clear(&value);
+    return ok;
+}
+
+// Ждет, пока симуляция применит все команды, принятые к моменту вызова
+static bool waitForEffect(UA_Client* client, const EquipmentModel& model) {
+    UA_UInt64 enqueued = 0;
+    if (!readCounter(client, model.commandsEnqueuedId, enqueued)) return false;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    UA_UInt64 applied = 0;
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (!readCounter(client, model.commandsAppliedId, applied)) return false;
+        if (applied >= enqueued) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return false;
+}
+
+// ============================== СБОР СТАТИСТИКИ ==============================
+struct ServiceStats {
+    std::vector<uint64_t> latenciesNs;
+    uint64_t errors = 0;
+    uint64_t badItems = 0; // элементы с плохим статусом в ответах с Good
+
+    void merge(const ServiceStats& other) {
+        latenciesNs.insert(latenciesNs.end(), other.latenciesNs.begin(), other.latenciesNs.end());
+        errors += other.errors;
+        badItems += other.badItems;
+    }
+
+    // Перцентиль по методу ближайшего ранга; вектор сортируется на месте
+    double percentileUs(double p) {
+        if (latenciesNs.empty()) return 0.0;
+        std::sort(latenciesNs.begin(), latenciesNs.end());
+        size_t rank = static_cast<size_t>(p / 100.0 * (latenciesNs.size() - 1) + 0.5);
+        return latenciesNs[rank] / 1000.0;
+    }
+};
+
+struct SessionResult {
+    bool connected = false;
+    ServiceStats services[STAT_COUNT];
+};
+
+static void runSession(const LoadOptions& options, const EquipmentModel& model, bool useHandles,
+                       unsigned seed,
+                       std::atomic<int>& ready, std::atomic<bool>& measuring,
+                       std::atomic<bool>& stop, SessionResult& out) {
+    UA_Client* client = connectClient(options.url);
+    out.connected = client != nullptr;
+    ready.fetch_add(1);
+    if (!client) {
+        return;
+    }
+
+    RequestSet requests(model, options.readBatch, useHandles, seed);
+    std::mt19937 rng(seed);
+    std::discrete_distribution<int> pick(options.weights, options.weights + SERVICE_COUNT);
+    uint64_t writes = 0;
+
+    auto record = [&out, &measuring](int kind, bool ok, std::chrono::steady_clock::time_point start,
+                                     uint64_t badItems) {
+        if (!measuring.load(std::memory_order_relaxed)) {
+            return; // прогрев
+        }
+        ServiceStats& stats = out.services[kind];
+        stats.badItems += badItems;
+        if (ok) {
+            stats.latenciesNs.push_back(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start).count()));
+        } else {
+            ++stats.errors;
+        }
+    };
+
+    while (!stop.load(std::memory_order_relaxed)) {
+        ServiceKind kind = static_cast<ServiceKind>(pick(rng));
+        auto start = std::chrono::steady_clock::now();
+        bool ok = requests.execute(client, kind);
+        record(kind, ok, start, requests.lastBadItems);
+
+        if (kind == SERVICE_WRITE && ok && options.effectEvery > 0 &&
+            ++writes % static_cast<uint64_t>(options.effectEvery) == 0) {
+            record(WRITE_EFFECT, waitForEffect(client, model), start, 0);
+        }
+    }
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+}
+
+// ============================== ПОДПИСКА НА ОСЦИЛЛОГРАММЫ ==============================
+// Каждая сессия подписывается на все осциллограммы и считает доставленные отсчеты.
+// Пропуски кадров определяются по разрыву SourceTimestamp больше периода кадра.
+struct WaveformResult {
+    bool connected = false;
+    uint64_t frames = 0;
+    uint64_t samples = 0;
+    uint64_t lostFrames = 0;
+};
+
+struct WaveformItem {
+    WaveformResult* result;
+    const std::atomic<bool>* measuring;
+    double sampleRate;
+    UA_DateTime lastStamp = 0;
+};
+
+static void waveformDataChanged(UA_Client*, UA_UInt32, void*, UA_UInt32, void* monContext,
+                                UA_DataValue* value) {
+    WaveformItem* item = static_cast<WaveformItem*>(monContext);
+    if (!value->hasValue || UA_Variant_isScalar(&value->value)) {
+        return;
+    }
+    UA_DateTime stamp = value->hasSourceTimestamp ? value->sourceTimestamp : 0;
+    UA_DateTime previous = item->lastStamp;
+    item->lastStamp = stamp;
+    if (!item->measuring->load(std::memory_order_relaxed)) {
+        return; // прогрев
+    }
+
+    size_t length = value->value.arrayLength;
+    item->result->frames += 1;
+    item->result->samples += length;
+    if (previous != 0 && stamp > previous && item->sampleRate > 0.0) {
+        double framePeriod = length / item->sampleRate * UA_DATETIME_SEC;
+        long long gap = std::llround((stamp - previous) / framePeriod);
+        if (gap > 1) item->result->lostFrames += static_cast<uint64_t>(gap - 1);
+    }
+}
+
+static void runWaveformSession(const LoadOptions& options, const EquipmentModel& model,
+                               std::atomic<int>& ready, std::atomic<bool>& measuring,
+                               std::atomic<bool>& stop, WaveformResult& out) {
+    UA_Client* client = connectClient(options.url);
+    std::vector<WaveformItem> items;
+    for (const auto& d : model.devices) {
+        for (const auto& v : d.variables) {
+            if (v.sampleRate > 0.0) items.push_back(WaveformItem{&out, &measuring, v.sampleRate});
+        }
+    }
+
+    UA_UInt32 subscriptionId = 0;
+    if (client) {
+        UA_CreateSubscriptionRequest request = UA_CreateSubscriptionRequest_default();
+        request.requestedPublishingInterval = options.publishIntervalMs;
+        UA_CreateSubscriptionResponse response =
+            UA_Client_Subscriptions_create(client, request, NULL, NULL, NULL);
+        if (response.responseHeader.serviceResult == UA_STATUSCODE_GOOD) {
+            subscriptionId = response.subscriptionId;
+        }
+        UA_CreateSubscriptionResponse_clear(&response);
+    }
+
+    size_t monitored = 0;
+    size_t i = 0;
+    for (const auto& d : model.devices) {
+        for (const auto& v : d.variables) {
+            if (v.sampleRate <= 0.0 || !subscriptionId) continue;
+            UA_MonitoredItemCreateRequest request = UA_MonitoredItemCreateRequest_default(v.nodeId);
+            request.requestedParameters.samplingInterval = options.publishIntervalMs;
+            request.requestedParameters.queueSize = 4;
+            UA_MonitoredItemCreateResult result = UA_Client_MonitoredItems_createDataChange(
+                client, subscriptionId, UA_TIMESTAMPSTORETURN_SOURCE, request,
+                &items[i++], waveformDataChanged, NULL);
+            if (result.statusCode == UA_STATUSCODE_GOOD) ++monitored;
+        }
+    }
+
+    out.connected = client && monitored == items.size();
+    ready.fetch_add(1);
+    if (client) {
+        while (!stop.load(std::memory_order_relaxed)) {
+            UA_Client_run_iterate(client, 10);
+        }
+        UA_Client_disconnect(client);
+        UA_Client_delete(client);
+    }
+}
+
+static bool runWaveformPhase(const LoadOptions& options, const EquipmentModel& model,
+                             std::ostringstream& json) {
+    double expectedPerSession = 0.0;
+    size_t waveformCount = 0;
+    for (const auto& d : model.devices) {
+        for (const auto& v : d.variables) {
+            if (v.sampleRate > 0.0) {
+                expectedPerSession += v.sampleRate;
+                ++waveformCount;
+            }
+        }
+    }
+    if (waveformCount == 0) {
+        std::cerr << "На сервере нет осциллограмм (переменных со свойством SampleRate)" << std::endl;
+        return false;
+    }
+
+    std::vector<WaveformResult> results(options.sessions);
+    std::vector<std::thread> threads;
+    std::atomic<int> ready(0);
+    std::atomic<bool> measuring(false);
+    std::atomic<bool> stop(false);
+
+    for (int i = 0; i < options.sessions; ++i) {
+        threads.emplace_back(runWaveformSession, std::cref(options), std::cref(model),
+                             std::ref(ready), std::ref(measuring), std::ref(stop), std::ref(results[i]));
+    }
+    while (ready.load() < options.sessions) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    std::this_thread::sleep_for(std::chrono::duration<double>(options.warmupSec));
+    measuring = true;
+    auto start = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(std::chrono::duration<double>(options.durationSec));
+    measuring = false;
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    stop = true;
+    for (auto& t : threads) t.join();
+
+    int connected = 0;
+    WaveformResult total;
+    for (auto& r : results) {
+        if (r.connected) ++connected;
+        total.frames += r.frames;
+        total.samples += r.samples;
+        total.lostFrames += r.lostFrames;
+    }
+
+    double samplesPerSec = total.samples / elapsed;
+    double expected = expectedPerSession * connected;
+    std::cout << "\n[waveform] Сессий: " << connected << "/" << options.sessions
+              << ", осциллограмм: " << waveformCount << ", время: " << elapsed << " с\n" << std::endl;
+    std::cout << std::fixed << std::setprecision(1)
+              << "  Кадров получено:        " << total.frames << "\n"
+              << "  Кадров пропущено:       " << total.lostFrames << "\n"
+              << "  Отсчетов/с доставлено:  " << samplesPerSec << "\n"
+              << "  Отсчетов/с генерируется: " << expected
+              << " (" << (expected > 0.0 ? samplesPerSec / expected * 100.0 : 0.0) << "%)" << std::endl;
+
+    json << "    {\"name\": \"waveform\", \"connected\": " << connected
+         << ", \"duration_s\": " << elapsed << ", \"waveform\": {\"frames\": " << total.frames
+         << ", \"lost_frames\": " << total.lostFrames << ", \"samples\": " << total.samples
+         << ", \"samples_per_s\": " << samplesPerSec
+         << ", \"expected_samples_per_s\": " << expected << "}}";
+
+    return connected == options.sessions;
+}
+
+// ============================== ПОДПИСКА НА ПЕРЕМЕННЫЕ ==============================
+// Каждая сессия подписывается на все скалярные переменные оборудования с заданным
+// SamplingInterval. Задержка - от SourceTimestamp (момент записи значения
+// симуляцией) до получения уведомления клиентом; сервер и клиент на одной машине.
+// SamplingInterval = 0 - выборка по тактам (PushSampler). При выборке по таймеру
+// сервер тоже фиксирует изменившиеся подписанные слоты в конце такта (PushSampler
+// не различает SamplingInterval), это время входит в оба замера.
+struct MonitorResult {
+    bool connected = false;
+    size_t items = 0;
+    uint64_t notifications = 0;
+    uint64_t duplicates = 0; // уведомление с тем же SourceTimestamp, что и предыдущее
+    ServiceStats latency;
+};
+
+struct MonitorItem {
+    MonitorResult* result;
+    const std::atomic<bool>* measuring;
+    UA_DateTime lastStamp = 0;
+};
+
+static void monitorDataChanged(UA_Client*, UA_UInt32, void*, UA_UInt32, void* monContext,
+                               UA_DataValue* value) {
+    UA_DateTime received = UA_DateTime_now();
+    MonitorItem* item = static_cast<MonitorItem*>(monContext);
+    if (!value->hasValue || !value->hasSourceTimestamp) {
+        return;
+    }
+    bool duplicate = value->sourceTimestamp == item->lastStamp;
+    item->lastStamp = value->sourceTimestamp;
+    if (!item->measuring->load(std::memory_order_relaxed)) {
+        return; // прогрев
+    }
+
+    item->result->notifications += 1;
+    item->result->duplicates += duplicate ? 1 : 0;
+    UA_DateTime delay = std::max<UA_DateTime>(0, received - value->sourceTimestamp);
+    item->result->latency.latenciesNs.push_back(static_cast<uint64_t>(delay) * 100);
+}
+
+static void runMonitorSession(const LoadOptions& options, const EquipmentModel& model, double samplingMs,
+                              std::atomic<int>& ready, std::atomic<bool>& measuring,
+                              std::atomic<bool>& stop, MonitorResult& out) {
+    UA_Client* client = connectClient(options.url);
+    std::vector<MonitorItem> items;
+    for (const auto& d : model.devices) {
+        for (const auto& v : d.variables) {
+            if (v.sampleRate <= 0.0) items.push_back(MonitorItem{&out, &measuring});
+        }
+    }
+
+    UA_UInt32 subscriptionId = 0;
+    if (client) {
+        UA_CreateSubscriptionRequest request = UA_CreateSubscriptionRequest_default();
+        request.requestedPublishingInterval = options.publishIntervalMs;
+        UA_CreateSubscriptionResponse response =
+            UA_Client_Subscriptions_create(client, request, NULL, NULL, NULL);
+        if (response.responseHeader.serviceResult == UA_STATUSCODE_GOOD) {
+            subscriptionId = response.subscriptionId;
+        }
+        UA_CreateSubscriptionResponse_clear(&response);
+    }
+
+    size_t i = 0;
+    for (const auto& d : model.devices) {
+        for (const auto& v : d.variables) {
+            if (v.sampleRate > 0.0 || !subscriptionId) continue;
+            UA_MonitoredItemCreateRequest request = UA_MonitoredItemCreateRequest_default(v.nodeId);
+            request.requestedParameters.samplingInterval = samplingMs;
+            request.requestedParameters.queueSize = 4;
+            UA_MonitoredItemCreateResult result = UA_Client_MonitoredItems_createDataChange(
+                client, subscriptionId, UA_TIMESTAMPSTORETURN_SOURCE, request,
+                &items[i++], monitorDataChanged, NULL);
+            if (result.statusCode == UA_STATUSCODE_GOOD) ++out.items;
+        }
+    }
+
+    out.connected = client && out.items == items.size();
+    ready.fetch_add(1);
+    if (client) {
+        while (!stop.load(std::memory_order_relaxed)) {
+            UA_Client_run_iterate(client, 10);
+        }
+        UA_Client_disconnect(client);
+        UA_Client_delete(client);
+    }
+}
+
+// Процессорное время процесса (user + system) в секундах; < 0, если недоступно
+static double processCpuSeconds(int pid) {
+#ifdef __linux__
+    if (pid <= 0) return -1.0;
+    std::ifstream stat("/proc/" + std::to_string(pid) + "/stat");
+    std::string line;
+    if (!std::getline(stat, line)) return -1.0;
+    size_t end = line.rfind(')'); // имя процесса может содержать пробелы
+    if (end == std::string::npos) return -1.0;
+    std::istringstream fields(line.substr(end + 2));
+    std::string field;
+    unsigned long long utime = 0;
+    unsigned long long stime = 0;
+    for (int index = 3; fields >> field; ++index) {
+        if (index == 14) utime = std::strtoull(field.c_str(), nullptr, 10);
+        if (index == 15) {
+            stime = std::strtoull(field.c_str(), nullptr, 10);
+            break;
+        }
+    }
+    return static_cast<double>(utime + stime) / sysconf(_SC_CLK_TCK);
+#else
+    (void)pid;
+    return -1.0;
+#endif
+}
+
+// Число потоков процесса; < 0, если недоступно
+static int processThreads(int pid) {
+#ifdef __linux__
+    if (pid <= 0) return -1;
+    std::ifstream status("/proc/" + std::to_string(pid) + "/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 8, "Threads:") == 0) {
+            return std::atoi(line.c_str() + 8);
+        }
+    }
+    return -1;
+#else
+    (void)pid;
+    return -1;
+#endif
+}
+
+// Системные вызовы всех потоков процесса (счетчик perf по точке трассировки
+// raw_syscalls:sys_enter); нужны права на perf_event_open для чужого процесса
+// (perf_event_paranoid или CAP_PERFMON) и смонтированный tracefs. Потоки,
+// созданные после start(), не учитываются.
+class SyscallCounter {
+public:
+    ~SyscallCounter() {
+        close();
+    }
+
+    bool start(int pid) {
+#ifdef __linux__
+        close();
+        long long eventId = tracepointId();
+        if (pid <= 0 || eventId < 0) return false;
+        std::string taskDir = "/proc/" + std::to_string(pid) + "/task";
+        DIR* dir = opendir(taskDir.c_str());
+        if (!dir) return false;
+        while (dirent* entry = readdir(dir)) {
+            int tid = std::atoi(entry->d_name);
+            if (tid <= 0) continue;
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.type = PERF_TYPE_TRACEPOINT;
+            attr.size = sizeof(attr);
+            attr.config = static_cast<unsigned long long>(eventId);
+            attr.disabled = 1;
+            attr.exclude_hv = 1;
+            int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, tid, -1, -1, 0));
+            if (fd >= 0) fds.push_back(fd);
+        }
+        closedir(dir);
+        for (int fd : fds) {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+        return !fds.empty();
+#else
+        (void)pid;
+        return false;
+#endif
+    }
+
+    // Вызовов с start(); < 0, если счетчик не открыт
+    double stop() {
+#ifdef __linux__
+        if (fds.empty()) return -1.0;
+        unsigned long long total = 0;
+        for (int fd : fds) {
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            unsigned long long count = 0;
+            if (read(fd, &count, sizeof(count)) == sizeof(count)) total += count;
+        }
+        close();
+        return static_cast<double>(total);
+#else
+        return -1.0;
+#endif
+    }
+
+private:
+    std::vector<int> fds;
+
+    void close() {
+#ifdef __linux__
+        for (int fd : fds) ::close(fd);
+#endif
+        fds.clear();
+    }
+
+    static long long tracepointId() {
+        for (const char* path : {"/sys/kernel/tracing/events/raw_syscalls/sys_enter/id",
+                                 "/sys/kernel/debug/tracing/events/raw_syscalls/sys_enter/id"}) {
+            std::ifstream file(path);
+            long long id = -1;
+            if (file >> id) return id;
+        }
+        return -1;
+    }
+};
+
+// Итог прогона подписки для сводной таблицы
+struct MonitorSummary {
+    double samplingMs = 0.0;
+    size_t items = 0;
+    double notificationsPerItemSec = 0.0;
+    double duplicateShare = 0.0;
+    double p50Ms = 0.0;
+    double p99Ms = 0.0;
+    double maxMs = 0.0;
+    double cpuUsPerItemSec = -1.0; // процессорное время сервера на элемент за секунду
+};
+
+static bool runMonitorPhase(const LoadOptions& options, const EquipmentModel& model, double samplingMs,
+                            std::ostringstream& json, MonitorSummary& summary) {
+    std::vector<MonitorResult> results(options.sessions);
+    std::vector<std::thread> threads;
+    std::atomic<int> ready(0);
+    std::atomic<bool> measuring(false);
+    std::atomic<bool> stop(false);
+
+    for (int i = 0; i < options.sessions; ++i) {
+        threads.emplace_back(runMonitorSession, std::cref(options), std::cref(model), samplingMs,
+                             std::ref(ready), std::ref(measuring), std::ref(stop), std::ref(results[i]));
+    }
+    while (ready.load() < options.sessions) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    std::this_thread::sleep_for(std::chrono::duration<double>(options.warmupSec));
+    double cpuBefore = processCpuSeconds(options.serverPid);
+    measuring = true;
+    auto start = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(std::chrono::duration<double>(options.durationSec));
+    measuring = false;
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double cpuAfter = processCpuSeconds(options.serverPid);
+    stop = true;
+    for (auto& t : threads) t.join();
+
+    int connected = 0;
+    MonitorResult total;
+    for (auto& r : results) {
+        if (r.connected) ++connected;
+        total.items += r.items;
+        total.notifications += r.notifications;
+        total.duplicates += r.duplicates;
+        total.latency.merge(r.latency);
+    }
+
+    summary.samplingMs = samplingMs;
+    summary.items = total.items;
+    summary.notificationsPerItemSec = total.items ? total.notifications / elapsed / total.items : 0.0;
+    summary.duplicateShare = total.notifications ? static_cast<double>(total.duplicates) / total.notifications : 0.0;
+    summary.p50Ms = total.latency.percentileUs(50.0) / 1000.0;
+    summary.p99Ms = total.latency.percentileUs(99.0) / 1000.0;
+    summary.maxMs = total.latency.percentileUs(100.0) / 1000.0;
+    if (cpuBefore >= 0.0 && cpuAfter >= 0.0 && total.items > 0) {
+        summary.cpuUsPerItemSec = (cpuAfter - cpuBefore) * 1e6 / elapsed / total.items;
+    }
+
+    std::cout << "\n[monitor/" << samplingMs << "ms] Сессий: " << connected << "/" << options.sessions
+              << ", элементов: " << total.items << ", публикация: " << options.publishIntervalMs
+              << " мс, время: " << elapsed << " с\n" << std::endl;
+    std::cout << std::fixed << std::setprecision(2)
+              << "  Уведомлений:            " << total.notifications
+              << " (" << summary.notificationsPerItemSec << " на элемент в секунду)\n"
+              << "  Повторных значений:     " << total.duplicates << "\n"
+              << "  Задержка p50/p99/max:   " << summary.p50Ms << " / " << summary.p99Ms
+              << " / " << summary.maxMs << " мс" << std::endl;
+    if (summary.cpuUsPerItemSec >= 0.0) {
+        std::cout << "  ЦП сервера:             " << (cpuAfter - cpuBefore) / elapsed * 100.0 << "%, "
+                  << summary.cpuUsPerItemSec << " мкс/с на элемент" << std::endl;
+    }
+
+    json << "    {\"name\": \"monitor/" << samplingMs << "\", \"connected\": " << connected
+         << ", \"duration_s\": " << elapsed << ", \"monitor\": {\"sampling_ms\": " << samplingMs
+         << ", \"items\": " << total.items << ", \"notifications\": " << total.notifications
+         << ", \"duplicates\": " << total.duplicates
+         << ", \"notifications_per_item_s\": " << summary.notificationsPerItemSec
+         << ", \"latency_p50_ms\": " << summary.p50Ms << ", \"latency_p99_ms\": " << summary.p99Ms
+         << ", \"latency_max_ms\": " << summary.maxMs;
+    if (summary.cpuUsPerItemSec >= 0.0) {
+        json << ", \"server_cpu_us_per_item_s\": " << summary.cpuUsPerItemSec;
+    }
+    json << "}}";
+
+    return connected == options.sessions;
+}
+
+// ============================== ТОЧКА ВХОДА ==============================
+static bool parseMix(const std::string& mix, double* weights) {
+    std::fill(weights, weights + SERVICE_COUNT, 0.0);
+    std::stringstream ss(mix);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        size_t eq = item.find('=');
+        if (eq == std::string::npos) return false;
+        std::string key = item.substr(0, eq);
+        double value = std::atof(item.c_str() + eq + 1);
+        if (key == "read") weights[SERVICE_READ] = value;
+        else if (key == "browse") weights[SERVICE_BROWSE] = value;
+        else if (key == "translate") weights[SERVICE_TRANSLATE] = value;
+        else if (key == "write") weights[SERVICE_WRITE] = value;
+        else return false;
+    }
+    return std::any_of(weights, weights + SERVICE_COUNT, [](double w) { return w > 0.0; });
+}
+
+static void printUsage() {
+    std::cout << "Usage: server_loadtest [--url <endpoint>] [--sessions <n>] [--duration <s>]\n"
+                 "                       [--warmup <s>] [--read-batch <1..10000>]\n"
+                 "                       [--mix read=80,browse=10,translate=10,write=0]\n"
+                 "                       [--effect-every <n>]\n"
+                 "                       [--handles | --compare-handles]\n"
+                 "                       [--waveform [--publish-interval <ms>]]\n"
+                 "                       [--monitor <sampling ms,...> [--publish-interval <ms>] [--server-pid <pid>]]\n"
+                 "                       [--scale 1,2,4,8,16 [--server-pid <pid> | --server <name>=<command> ...]]\n"
+                 "                       [--json <file>]\n"
+                 "--server: server_loadtest сам запускает сервер с --port из --url и --quiet,\n"
+                 "повторяется для каждой сборки, например:\n"
+                 "  --server single=build/server --server mt=build-mt/server"
+              << std::endl;
+}
+
+// "1,2,4,8" -> {1, 2, 4, 8}
+static bool parseScale(const std::string& text, std::vector<int>& sessions) {
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        int n = std::atoi(item.c_str());
+        if (n <= 0) return false;
+        sessions.push_back(n);
+    }
+    return !sessions.empty();
+}
+
+// "mt=build-mt/server --tick-ms 100" -> {"mt", {"build-mt/server", "--tick-ms", "100"}}
+static bool parseServer(const std::string& text, std::vector<ServerBuild>& servers) {
+    size_t separator = text.find('=');
+    if (separator == 0 || separator == std::string::npos) return false;
+    ServerBuild build;
+    build.name = text.substr(0, separator);
+    std::istringstream words(text.substr(separator + 1));
+    std::string word;
+    while (words >> word) build.command.push_back(word);
+    if (build.command.empty()) return false;
+    servers.push_back(build);
+    return true;
+}
+
+// "0,100,250" -> {0, 100, 250}; 0 - выборка по тактам сервера
+static bool parseSampling(const std::string& text, std::vector<double>& intervals) {
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        char* end = nullptr;
+        double ms = std::strtod(item.c_str(), &end);
+        if (end == item.c_str() || ms < 0.0) return false;
+        intervals.push_back(ms);
+    }
+    return !intervals.empty();
+}
+
+// Итог прогона по сервису Read для таблицы масштабирования
+struct ReadSummary {
+    int sessions = 0;
+    double requestsPerSec = 0.0;
+    double valuesPerSec = 0.0;
+    double p50Us = 0.0;
+    double p99Us = 0.0;
+    uint64_t errors = 0;
+    double syscallsPerRequest = -1.0; // сервера, на запрос любого сервиса (--server-pid)
+    double cpuUsPerRequest = -1.0;
+    int serverThreads = -1;           // потоков сервера к концу замера
+    double serverCores = -1.0;        // процессорное время сервера / длительность замера
+};
+
+// "-" для недоступных значений сервера
+static std::string serverCost(double value) {
+    if (value < 0.0) return "-";
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(2) << value;
+    return text.str();
+}
+
+static std::string serverThreadsText(int threads) {
+    return threads < 0 ? "-" : std::to_string(threads);
+}
+
+// Один прогон нагрузки; результаты печатаются и дописываются в json как элемент "phases".
+// false, если подключились не все сессии или в ответах были элементы с плохим статусом
+static bool runPhase(const LoadOptions& options, const EquipmentModel& model, bool useHandles,
+                     const std::string& phaseName, std::ostringstream& json,
+                     ReadSummary* readSummary = nullptr) {
+    std::vector<SessionResult> results(options.sessions);
+    std::vector<std::thread> threads;
+    std::atomic<int> ready(0);
+    std::atomic<bool> measuring(false);
+    std::atomic<bool> stop(false);
+
+    for (int i = 0; i < options.sessions; ++i) {
+        threads.emplace_back(runSession, std::cref(options), std::cref(model), useHandles, 1234u + i,
+                             std::ref(ready), std::ref(measuring), std::ref(stop), std::ref(results[i]));
+    }
+    while (ready.load() < options.sessions) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    std::this_thread::sleep_for(std::chrono::duration<double>(options.warmupSec));
+    SyscallCounter syscalls;
+    bool countingSyscalls = options.serverPid > 0 && syscalls.start(options.serverPid);
+    double cpuBefore = processCpuSeconds(options.serverPid);
+    measuring = true;
+    auto start = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(std::chrono::duration<double>(options.durationSec));
+    measuring = false;
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double cpuAfter = processCpuSeconds(options.serverPid);
+    int serverThreads = processThreads(options.serverPid);
+    double syscallCount = countingSyscalls ? syscalls.stop() : -1.0;
+    stop = true;
+    for (auto& t : threads) t.join();
+
+    int connected = 0;
+    ServiceStats total[STAT_COUNT];
+    for (auto& r : results) {
+        if (r.connected) ++connected;
+        for (int k = 0; k < STAT_COUNT; ++k) total[k].merge(r.services[k]);
+    }
+
+    // Стоимость запроса на стороне сервера
+    size_t requests = 0;
+    for (int k = 0; k < STAT_COUNT; ++k) requests += total[k].latenciesNs.size();
+    double syscallsPerRequest = syscallCount >= 0.0 && requests > 0 ? syscallCount / requests : -1.0;
+    double cpuUsPerRequest = cpuBefore >= 0.0 && cpuAfter >= 0.0 && requests > 0
+        ? (cpuAfter - cpuBefore) * 1e6 / requests : -1.0;
+    double serverCores = cpuBefore >= 0.0 && cpuAfter >= 0.0 ? (cpuAfter - cpuBefore) / elapsed : -1.0;
+    if (options.serverPid > 0 && !countingSyscalls) {
+        std::cerr << "Системные вызовы сервера не считаются: нет доступа к perf_event_open или tracefs"
+                  << std::endl;
+    }
+
+    std::cout << "\n[" << phaseName << "] Сессий: " << connected << "/" << options.sessions
+              << ", пакет чтения: " << options.readBatch << ", время: " << elapsed << " с\n" << std::endl;
+    std::cout << std::left << std::setw(32) << "service" << std::right << std::setw(12) << "requests"
+              << std::setw(12) << "req/s" << std::setw(12) << "p50 us" << std::setw(12) << "p99 us"
+              << std::setw(12) << "max us" << std::setw(10) << "errors" << std::endl;
+
+    json << "    {\"name\": \"" << phaseName << "\", \"connected\": " << connected
+         << ", \"duration_s\": " << elapsed << ", \"services\": {";
+
+    bool first = true;
+    for (int k = 0; k < STAT_COUNT; ++k) {
+        ServiceStats& s = total[k];
+        if (s.latenciesNs.empty() && s.errors == 0) continue;
+        double rps = s.latenciesNs.size() / elapsed;
+        double p50 = s.percentileUs(50.0);
+        double p99 = s.percentileUs(99.0);
+        double maxUs = s.percentileUs(100.0);
+
+        std::cout << std::left << std::setw(32) << serviceNames[k] << std::right
+                  << std::setw(12) << s.latenciesNs.size()
+                  << std::setw(12) << std::fixed << std::setprecision(1) << rps
+                  << std::setw(12) << p50 << std::setw(12) << p99 << std::setw(12) << maxUs
+                  << std::setw(10) << s.errors << std::endl;
+
+        json << (first ? "\n" : ",\n") << "      \"" << serviceNames[k] << "\": {\"requests\": "
+             << s.latenciesNs.size() << ", \"errors\": " << s.errors << ", \"bad_items\": " << s.badItems
+             << ", \"rps\": " << rps
+             << ", \"p50_us\": " << p50 << ", \"p99_us\": " << p99 << ", \"max_us\": " << maxUs << "}";
+        first = false;
+
+        if (k == SERVICE_READ && readSummary) {
+            readSummary->requestsPerSec = rps;
+            readSummary->valuesPerSec = rps * options.readBatch;
+            readSummary->p50Us = p50;
+            readSummary->p99Us = p99;
+            readSummary->errors = s.errors;
+        }
+    }
+    json << "\n    }";
+
+    // Ответ Good с плохими элементами - тоже ошибка: прогон не засчитывается
+    uint64_t badItems = 0;
+    for (int k = 0; k < STAT_COUNT; ++k) {
+        if (total[k].badItems == 0) continue;
+        badItems += total[k].badItems;
+        std::cout << serviceNames[k] << ": элементов с плохим статусом " << total[k].badItems << std::endl;
+    }
+    if (badItems > 0) {
+        std::cout << "[" << phaseName << "] ПРОГОН НЕ ЗАСЧИТАН" << std::endl;
+    }
+    if (syscallsPerRequest >= 0.0) json << ", \"server_syscalls_per_request\": " << syscallsPerRequest;
+    if (cpuUsPerRequest >= 0.0) json << ", \"server_cpu_us_per_request\": " << cpuUsPerRequest;
+    if (serverThreads >= 0) json << ", \"server_threads\": " << serverThreads;
+    if (serverCores >= 0.0) json << ", \"server_cores\": " << serverCores;
+    json << "}";
+    if (options.serverPid > 0) {
+        std::cout << "\nСервер на запрос: системных вызовов " << serverCost(syscallsPerRequest)
+                  << ", процессорного времени " << serverCost(cpuUsPerRequest) << " мкс" << std::endl;
+        std::cout << "Сервер: потоков " << serverThreadsText(serverThreads)
+                  << ", занято ядер " << serverCost(serverCores) << std::endl;
+    }
+    if (readSummary) {
+        readSummary->sessions = connected;
+        readSummary->syscallsPerRequest = syscallsPerRequest;
+        readSummary->cpuUsPerRequest = cpuUsPerRequest;
+        readSummary->serverThreads = serverThreads;
+        readSummary->serverCores = serverCores;
+    }
+
+    return connected == options.sessions && badItems == 0;
+}
+
+// Обнаружение модели и ручек перед нагрузкой; false - нагружать нечего
+static bool prepareModel(const LoadOptions& options, EquipmentModel& model) {
+    if (!discoverEquipment(options.url, model)) {
+        return false;
+    }
+    std::cout << "Обнаружено устройств: " << model.devices.size()
+              << ", переменных: " << model.variableCount() << std::endl;
+
+    if ((options.useHandles || options.compareHandles) && !registerHandles(options.url, model)) {
+        return false;
+    }
+    if (options.weights[SERVICE_WRITE] > 0.0 &&
+        (model.setpointCount() == 0 || UA_NodeId_isNull(&model.commandsAppliedId))) {
+        std::cerr << "На сервере нет уставок или счетчиков очереди команд" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static void clearModel(EquipmentModel& model) {
+    for (auto& d : model.devices) {
+        for (auto& v : d.variables) {
+            UA_NodeId_clear(&v.nodeId);
+            UA_NodeId_clear(&v.handle);
+        }
+        UA_NodeId_clear(&d.nodeId);
+    }
+    model.devices.clear();
+    UA_NodeId_clear(&model.controlId);
+    UA_NodeId_clear(&model.registerHandlesId);
+    UA_NodeId_clear(&model.commandsEnqueuedId);
+    UA_NodeId_clear(&model.commandsAppliedId);
+}
+
+// Масштабирование: одна и та же нагрузка при растущем числе сессий. Фазы
+// дописываются в json после уже записанных (firstPhase - еще ни одной)
+static bool runScale(const LoadOptions& options, const EquipmentModel& model, const std::string& prefix,
+                     std::ostringstream& json, bool& firstPhase, std::vector<ReadSummary>& summaries) {
+    bool allPassed = true;
+    for (int sessions : options.scaleSessions) {
+        LoadOptions scaled = options;
+        scaled.sessions = sessions;
+        std::string name = prefix + (options.useHandles ? "handles" : "node-ids") + "/" + std::to_string(sessions);
+        ReadSummary summary;
+        if (!firstPhase) json << ",\n";
+        firstPhase = false;
+        allPassed = runPhase(scaled, model, options.useHandles, name, json, &summary) && allPassed;
+        summaries.push_back(summary);
+    }
+
+    std::cout << "\n[" << prefix << "scale] Read, пакет " << options.readBatch << "\n" << std::endl;
+    std::cout << std::right << std::setw(10) << "sessions" << std::setw(12) << "req/s"
+              << std::setw(14) << "values/s" << std::setw(10) << "speedup" << std::setw(12) << "p50 us"
+              << std::setw(12) << "p99 us" << std::setw(10) << "errors" << std::setw(10) << "sys/req"
+              << std::setw(12) << "cpu us/req" << std::setw(9) << "threads" << std::setw(8) << "cores"
+              << std::endl;
+    for (auto& s : summaries) {
+        double base = summaries.front().requestsPerSec;
+        std::cout << std::setw(10) << s.sessions << std::fixed << std::setprecision(1)
+                  << std::setw(12) << s.requestsPerSec << std::setw(14) << s.valuesPerSec
+                  << std::setw(10) << std::setprecision(2) << (base > 0.0 ? s.requestsPerSec / base : 0.0)
+                  << std::setprecision(1) << std::setw(12) << s.p50Us << std::setw(12) << s.p99Us
+                  << std::setw(10) << s.errors << std::setw(10) << serverCost(s.syscallsPerRequest)
+                  << std::setw(12) << serverCost(s.cpuUsPerRequest)
+                  << std::setw(9) << serverThreadsText(s.serverThreads)
+                  << std::setw(8) << serverCost(s.serverCores) << std::endl;
+    }
+    return allPassed;
+}
+
+// ============================== ЗАПУСК СБОРОК СЕРВЕРА ==============================
+// --server: сервер запускается дочерним процессом на порту из --url, вывод
+// отбрасывается. Готовность - прием TCP-подключений на этом порту; остановка -
+// SIGINT (как Ctrl+C), через 10 с SIGKILL. Только Linux.
+#ifdef __linux__
+class ServerProcess {
+private:
+    pid_t pid = -1;
+
+    static bool portAccepts(UA_UInt16 port) {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) return false;
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bool accepted = connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+        close(fd);
+        return accepted;
+    }
+
+public:
+    ~ServerProcess() { stop(); }
+
+    pid_t getPid() const { return pid; }
+
+    bool start(const ServerBuild& build, UA_UInt16 port) {
+        if (portAccepts(port)) {
+            std::cerr << "Порт " << port << " уже занят другим сервером" << std::endl;
+            return false;
+        }
+        std::vector<std::string> arguments = build.command;
+        arguments.push_back("--port");
+        arguments.push_back(std::to_string(port));
+        arguments.push_back("--quiet");
+        std::vector<char*> argv;
+        for (auto& argument : arguments) argv.push_back(&argument[0]);
+        argv.push_back(nullptr);
+
+        pid = fork();
+        if (pid < 0) {
+            std::cerr << "fork: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        if (pid == 0) {
+            int devNull = open("/dev/null", O_WRONLY);
+            if (devNull >= 0) {
+                dup2(devNull, STDOUT_FILENO);
+                close(devNull);
+            }
+            execvp(argv[0], argv.data());
+            std::cerr << build.command[0] << ": " << std::strerror(errno) << std::endl;
+            _exit(127);
+        }
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(15);
+        while (std::chrono::steady_clock::now() < deadline) {
+            int status = 0;
+            if (waitpid(pid, &status, WNOHANG) == pid) {
+                std::cerr << "Сервер " << build.name << " завершился при запуске" << std::endl;
+                pid = -1;
+                return false;
+            }
+            if (portAccepts(port)) return true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        std::cerr << "Сервер " << build.name << " не открыл порт " << port << " за 15 с" << std::endl;
+        stop();
+        return false;
+    }
+
+    void stop() {
+        if (pid <= 0) return;
+        kill(pid, SIGINT);
+        int status = 0;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (waitpid(pid, &status, WNOHANG) == 0) {
+            if (std::chrono::steady_clock::now() >= deadline) {
+                kill(pid, SIGKILL);
+                waitpid(pid, &status, 0);
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        pid = -1;
+    }
+};
+#endif
+
+// opc.tcp://host:4841/path -> 4841; без порта - 4840
+static UA_UInt16 urlPort(const std::string& url) {
+    size_t host = url.find("://");
+    host = host == std::string::npos ? 0 : host + 3;
+    size_t colon = url.find(':', host);
+    if (colon == std::string::npos) return 4840;
+    int port = std::atoi(url.c_str() + colon + 1);
+    return port > 0 && port <= 65535 ? static_cast<UA_UInt16>(port) : 4840;
+}
+
+// Сравнение сборок: --scale для каждой по очереди на одном порту, затем общая
+// таблица - потоки сервера, занятые им ядра и пропускная способность Read при
+// одинаковом числе сессий
+static bool runBuildComparison(const LoadOptions& options, std::ostringstream& json) {
+#ifdef __linux__
+    struct BuildResult {
+        std::string name;
+        std::vector<ReadSummary> summaries;
+    };
+    std::vector<BuildResult> results;
+    bool allPassed = true;
+    bool firstPhase = true;
+    UA_UInt16 port = urlPort(options.url);
+
+    for (const ServerBuild& build : options.servers) {
+        std::cout << "\n====== Сборка " << build.name << " ======" << std::endl;
+        ServerProcess server;
+        EquipmentModel model;
+        if (!server.start(build, port) || !prepareModel(options, model)) {
+            clearModel(model);
+            allPassed = false;
+            continue;
+        }
+        LoadOptions measured = options;
+        measured.serverPid = server.getPid();
+        BuildResult result;
+        result.name = build.name;
+        allPassed = runScale(measured, model, build.name + "/", json, firstPhase, result.summaries) &&
+                    allPassed;
+        clearModel(model);
+        results.push_back(result);
+    }
+    if (results.empty()) return false;
+
+    const BuildResult& base = results.front();
+    std::cout << "\n[builds] Read, пакет " << options.readBatch
+              << "; cores - процессорное время сервера / длительность замера\n" << std::endl;
+    std::cout << std::left << std::setw(16) << "build" << std::right << std::setw(10) << "sessions"
+              << std::setw(9) << "threads" << std::setw(12) << "req/s" << std::setw(14) << "values/s"
+              << std::setw(8) << "cores" << std::setw(12) << ("vs " + base.name) << std::endl;
+    for (size_t i = 0; i < options.scaleSessions.size(); ++i) {
+        for (auto& result : results) {
+            if (i >= result.summaries.size()) continue;
+            const ReadSummary& s = result.summaries[i];
+            double baseRps = i < base.summaries.size() ? base.summaries[i].requestsPerSec : 0.0;
+            std::cout << std::left << std::setw(16) << result.name << std::right << std::setw(10) << s.sessions
+                      << std::setw(9) << serverThreadsText(s.serverThreads) << std::fixed << std::setprecision(1)
+                      << std::setw(12) << s.requestsPerSec << std::setw(14) << s.valuesPerSec
+                      << std::setw(8) << serverCost(s.serverCores) << std::setw(12) << std::setprecision(2)
+                      << (baseRps > 0.0 ? s.requestsPerSec / baseRps : 0.0) << std::endl;
+        }
+    }
+    return allPassed;
+#else
+    (void)options;
+    (void)json;
+    std::cerr << "--server поддерживается только в Linux" << std::endl;
+    return false;
+#endif
+}
+
+// Нагрузка по выбранному режиму на уже обнаруженной модели
+static bool runLoad(const LoadOptions& options, const EquipmentModel& model, std::ostringstream& json) {
+    std::vector<bool> phases;
+    if (options.compareHandles) {
+        phases = {false, true};
+    } else {
+        phases = {options.useHandles};
+    }
+
+    bool allPassed = true;
+    if (options.waveform) {
+        allPassed = runWaveformPhase(options, model, json);
+    } else if (!options.samplingMs.empty()) {
+        // Подписка: выборка по тактам (0) против выборки по таймеру
+        std::vector<MonitorSummary> summaries;
+        for (size_t i = 0; i < options.samplingMs.size(); ++i) {
+            MonitorSummary summary;
+            if (i > 0) json << ",\n";
+            allPassed = runMonitorPhase(options, model, options.samplingMs[i], json, summary) && allPassed;
+            summaries.push_back(summary);
+        }
+
+        std::cout << "\n[monitor] SamplingInterval 0 - выборка по тактам\n" << std::endl;
+        std::cout << std::right << std::setw(12) << "sampling ms" << std::setw(8) << "items"
+                  << std::setw(14) << "notif/item/s" << std::setw(8) << "dup %" << std::setw(10) << "p50 ms"
+                  << std::setw(10) << "p99 ms" << std::setw(10) << "max ms" << std::setw(16) << "cpu us/item/s"
+                  << std::endl;
+        for (auto& m : summaries) {
+            std::cout << std::setw(12) << std::fixed << std::setprecision(1) << m.samplingMs
+                      << std::setw(8) << m.items << std::setprecision(2) << std::setw(14) << m.notificationsPerItemSec
+                      << std::setprecision(1) << std::setw(8) << m.duplicateShare * 100.0
+                      << std::setw(10) << m.p50Ms << std::setw(10) << m.p99Ms << std::setw(10) << m.maxMs;
+            if (m.cpuUsPerItemSec >= 0.0) {
+                std::cout << std::setw(16) << std::setprecision(2) << m.cpuUsPerItemSec;
+            } else {
+                std::cout << std::setw(16) << "-";
+            }
+            std::cout << std::endl;
+        }
+    } else if (!options.scaleSessions.empty()) {
+        std::vector<ReadSummary> summaries;
+        bool firstPhase = true;
+        allPassed = runScale(options, model, "", json, firstPhase, summaries);
+    } else {
+        for (size_t i = 0; i < phases.size(); ++i) {
+            if (i > 0) json << ",\n";
+            allPassed = runPhase(options, model, phases[i], phases[i] ? "handles" : "node-ids", json) &&
+                           allPassed;
+        }
+    }
+    return allPassed;
+}
+
+int main(int argc, char** argv) {
+#ifdef _WIN32
+    SetConsoleOutputCP(CP_UTF8);
+#endif
+
+    LoadOptions options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--url" && hasValue) options.url = argv[++i];
+        else if (arg == "--sessions" && hasValue) options.sessions = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--duration" && hasValue) options.durationSec = std::atof(argv[++i]);
+        else if (arg == "--warmup" && hasValue) options.warmupSec = std::atof(argv[++i]);
+        else if (arg == "--read-batch" && hasValue)
+            options.readBatch = std::min<size_t>(10000, std::max(1, std::atoi(argv[++i])));
+        else if (arg == "--mix" && hasValue) {
+            if (!parseMix(argv[++i], options.weights)) {
+                std::cerr << "Неверный формат --mix" << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--handles") options.useHandles = true;
+        else if (arg == "--compare-handles") options.compareHandles = true;
+        else if (arg == "--effect-every" && hasValue) options.effectEvery = std::atoi(argv[++i]);
+        else if (arg == "--waveform") options.waveform = true;
+        else if (arg == "--publish-interval" && hasValue) options.publishIntervalMs = std::atof(argv[++i]);
+        else if (arg == "--scale" && hasValue) {
+            if (!parseScale(argv[++i], options.scaleSessions)) {
+                std::cerr << "Неверный формат --scale" << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--monitor" && hasValue) {
+            if (!parseSampling(argv[++i], options.samplingMs)) {
+                std::cerr << "Неверный формат --monitor" << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--server-pid" && hasValue) options.serverPid = std::atoi(argv[++i]);
+        else if (arg == "--server" && hasValue) {
+            if (!parseServer(argv[++i], options.servers)) {
+                std::cerr << "Неверный формат --server, ожидается <имя>=<команда>" << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--json" && hasValue) options.jsonPath = argv[++i];
+        else {
+            printUsage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    if (!options.servers.empty() && options.scaleSessions.empty()) {
+        std::cerr << "--server задает сборки для --scale" << std::endl;
+        return 1;
+    }
+
+    std::ostringstream json;
+    json << "{\n  \"url\": \"" << options.url << "\",\n  \"sessions\": " << options.sessions
+         << ",\n  \"read_batch\": " << options.readBatch << ",\n  \"phases\": [\n";
+
+    bool allPassed = true;
+    if (!options.servers.empty()) {
+        allPassed = runBuildComparison(options, json);
+    } else {
+        EquipmentModel model;
+        if (!prepareModel(options, model)) {
+            clearModel(model);
+            return 1;
+        }
+        allPassed = runLoad(options, model, json);
+        clearModel(model);
+    }
+    if (!options.scaleSessions.empty()) {
+        std::cout << "\nВнимание: open62541 1.4 выполняет все сервисы под одной блокировкой сервера, в том\n"
+                     "числе при SERVER_MULTITHREADED. Независимые Read не выполняются параллельно и не\n"
+                     "используют больше одного ядра; рост с числом сессий - это меньше простоев сети,\n"
+                     "а не параллельная обработка запросов. Лишний поток SERVER_MULTITHREADED - поток\n"
+                     "симуляции; cores сверх 1 приходится на такты, а не на Read." << std::endl;
+    }
+    json << "\n  ]\n}\n";
+
+    if (!options.jsonPath.empty()) {
+        std::ofstream(options.jsonPath) << json.str();
+    }
+    return allPassed ? 0 : 1;
+}
@@ -0,0 +1,684 @@
+#pragma once
+
+#include <open62541/server.h>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "opcua_wrappers.h"
+#include "derived_tags.h"
+#include "value_store.h"
+#include "ua_type_traits.h"
+#include "triple_buffer.h"
+
+// ============================== БАЗОВЫЙ КЛАСС УЗЛА ==============================
+class OPCUANode {
+protected:
+    UA_Server* server;
+    UA_NodeId nodeId;
+    
+public:
+    OPCUANode(UA_Server* srv, const UA_NodeId& id) 
+        : server(srv), nodeId(id) {}
+    
+    virtual ~OPCUANode() = default;
+    
+    // Запрещаем копирование
+    OPCUANode(const OPCUANode&) = delete;
+    OPCUANode& operator=(const OPCUANode&) = delete;
+    
+    UA_NodeId getNodeId() const { return nodeId; }
+    UA_Server* getServer() const { return server; }
+    
+    virtual void initialize() = 0;
+    
+    // NodeId свойства (HasProperty) узла: у компонента не больше одного свойства.
+    // Номер задается явно, а не выдается nodestore: случайный номер мог бы попасть
+    // в диапазон ручек ValueStore::HANDLE_BASE и перехватываться как ручка.
+    static constexpr UA_UInt32 PROPERTY_ID_BASE = 0x40000000u;
+    static_assert(PROPERTY_ID_BASE < ValueStore::HANDLE_BASE, "Свойства - ниже диапазона ручек");
+    
+protected:
+    UA_NodeId propertyNodeId() const {
+        return UA_NODEID_NUMERIC(nodeId.namespaceIndex, PROPERTY_ID_BASE + nodeId.identifier.numeric);
+    }
+};
+
+// ============================== БАЗОВЫЙ КЛАСС ПЕРЕМЕННОЙ ==============================
+// Значение переменной хранится в ValueStore сервера, узел подключен к нему как DataSource.
+// Тип значения задает наследник OPCUAVariable<T>; здесь - общее для всех типов.
+class OPCUAVariableBase : public OPCUANode {
+protected:
+    std::string displayName;
+    std::string description;
+    std::string browseName;
+    ValueStore* store;
+    ValueStore::Slot slot;
+    bool slotHeld = true;
+    UA_Byte accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
+    
+    OPCUAVariableBase(UA_Server* srv, UA_UInt16 nsIndex, UA_UInt32 id,
+                      const std::string& browseName, const std::string& displayName,
+                      const std::string& description, const UA_DataType* type,
+                      const void* initialValue, size_t arrayLength)
+        : OPCUANode(srv, UA_NODEID_NUMERIC(nsIndex, id)),
+          displayName(displayName), 
+          description(description),
+          browseName(browseName),
+          store(&EquipmentNodestore::storeFor(srv)),
+          slot(store->allocate(nodeId, type, initialValue, arrayLength)) {}
+    
+public:
+    // Слот, не возвращенный через releaseSlot(), возвращается здесь: так не
+    // теряются слоты компонентов устройства, конструктор которого бросил
+    // исключение. Хранилище сервера должно быть еще живо (до UA_Server_delete)
+    ~OPCUAVariableBase() override {
+        releaseSlot();
+    }
+    
+
+    virtual void initialize() override {
+        // Добавляем как переменную в ObjectsFolder
+        addVariableNode(UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                        UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES));
+    }
+    
+    ValueStore::Slot getSlot() const { return slot; }
+    const ValueStore* getStore() const { return store; }
+    const std::string& getBrowseName() const { return browseName; }
+    
+    // Ручка для быстрого доступа клиентов (см. EquipmentControl::RegisterHandles)
+    UA_NodeId getHandleNodeId() const { return store->handleNodeId(slot); }
+    
+    // Возвращает слот хранилищу; после этого переменная не используется.
+    // Повторный вызов ничего не делает
+    void releaseSlot() {
+        if (slotHeld) {
+            store->release(slot);
+            slotHeld = false;
+        }
+    }
+    
+    // На время записи, которой PushSampler запускает выборку MonitoredItems:
+    // значение уже лежит в слоте, поэтому writeDataSource его не трогает
+    class SamplingWrite {
+    public:
+        SamplingWrite() { active() = true; }
+        ~SamplingWrite() { active() = false; }
+        SamplingWrite(const SamplingWrite&) = delete;
+        SamplingWrite& operator=(const SamplingWrite&) = delete;
+        
+        static bool& active() {
+            static thread_local bool flag = false;
+            return flag;
+        }
+    };
+    
+protected:
+    UA_StatusCode addVariableNode(const UA_NodeId& parentNodeId, const UA_NodeId& referenceTypeId) {
+        UA_VariableAttributes attr = UA_VariableAttributes_default;
+        
+        // Создаем локализованные строки
+        UALocalizedText displayNameText("en-US", displayName.c_str());
+        UALocalizedText descriptionText("en-US", description.c_str());
+        UAQualifiedName qualifiedName(nodeId.namespaceIndex, browseName.c_str());
+        
+        attr.displayName = *displayNameText.get();
+        attr.description = *descriptionText.get();
+        attr.dataType = store->getType(slot)->typeId;
+        attr.accessLevel = accessLevel;
+        attr.userAccessLevel = accessLevel;
+        
+        UA_UInt32 arrayDimension = static_cast<UA_UInt32>(store->getArrayLength(slot));
+        if (arrayDimension > 0) {
+            attr.valueRank = UA_VALUERANK_ONE_DIMENSION;
+            attr.arrayDimensionsSize = 1;
+            attr.arrayDimensions = &arrayDimension;
+        } else {
+            attr.valueRank = UA_VALUERANK_SCALAR;
+        }
+        
+        UA_DataSource dataSource;
+        dataSource.read = &OPCUAVariableBase::readDataSource;
+        dataSource.write = &OPCUAVariableBase::writeDataSource;
+        
+        return UA_Server_addDataSourceVariableNode(server, nodeId,
+            parentNodeId,
+            referenceTypeId,
+            *qualifiedName.get(),
+            UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+            attr, dataSource, this, NULL);
+    }
+    
+    // Запись клиентом (сервис Write); по умолчанию значение сразу попадает в слот
+    virtual UA_StatusCode writeFromClient(const UA_DataValue* value) {
+        return store->writeFromClient(slot, value);
+    }
+    
+private:
+    static UA_StatusCode readDataSource(UA_Server*, const UA_NodeId*, void*, const UA_NodeId*,
+                                        void* nodeContext, UA_Boolean includeSourceTimestamp,
+                                        const UA_NumericRange* range, UA_DataValue* value) {
+        OPCUAVariableBase* self = static_cast<OPCUAVariableBase*>(nodeContext);
+        if (!self) {
+            return UA_STATUSCODE_BADINTERNALERROR;
+        }
+        return self->store->read(self->slot, includeSourceTimestamp, range, value);
+    }
+    
+    static UA_StatusCode writeDataSource(UA_Server*, const UA_NodeId*, void*, const UA_NodeId*,
+                                         void* nodeContext, const UA_NumericRange* range,
+                                         const UA_DataValue* value) {
+        OPCUAVariableBase* self = static_cast<OPCUAVariableBase*>(nodeContext);
+        if (!self) {
+            return UA_STATUSCODE_BADINTERNALERROR;
+        }
+        if (range) {
+            return UA_STATUSCODE_BADINDEXRANGEINVALID;
+        }
+        if (SamplingWrite::active()) {
+            return UA_STATUSCODE_GOOD;
+        }
+        return self->writeFromClient(value);
+    }
+};
+
+// ============================== КЛАСС ПЕРЕМЕННОЙ ==============================
+// T - тип значения: bool, целые 8..64 бит, float, double или std::array<T, N>.
+// Описатель UA_TYPES выбирается при компиляции (UATypeTraits), запись - memcpy
+// фиксированного размера без разбора типа во время выполнения.
+template<typename T = double>
+class OPCUAVariable : public OPCUAVariableBase {
+public:
+    using Traits = UATypeTraits<T>;
+    static_assert(sizeof(T) == sizeof(typename Traits::Element) * (Traits::ARRAY_LENGTH ? Traits::ARRAY_LENGTH : 1),
+                  "Значение должно храниться без заполнения");
+    
+    OPCUAVariable(UA_Server* srv, UA_UInt16 nsIndex, UA_UInt32 id, 
+                  const std::string& browseName, const std::string& displayName,
+                  const std::string& description, const T& initialValue)
+        : OPCUAVariableBase(srv, nsIndex, id, browseName, displayName, description,
+                            Traits::type(), &initialValue, Traits::ARRAY_LENGTH) {}
+    
+    void writeValue(const T& value) {
+        store->writeAs(slot, value);
+    }
+};
+
+// ============================== КЛАСС ПЕРЕМЕННОЙ В КАЧЕСТВЕ КОМПОНЕНТА ==============================
+template<typename T = double>
+class OPCUAComponentVariable : public OPCUAVariable<T> {
+private:
+    UA_NodeId parentNodeId;
+    
+public:
+    OPCUAComponentVariable(UA_Server* srv, UA_UInt16 nsIndex, UA_UInt32 id,
+                          const std::string& browseName, const std::string& displayName,
+                          const std::string& description, const T& initialValue,
+                          const UA_NodeId& parentId)
+        : OPCUAVariable<T>(srv, nsIndex, id, browseName, displayName, description, initialValue),
+          parentNodeId(parentId) {
+        // Значения компонентов задает симулятор, запись клиента была бы сразу
+        // перезаписана; изменяемые клиентом параметры - OPCUASetpointVariable
+        this->accessLevel = UA_ACCESSLEVELMASK_READ;
+    }
+    
+    void initialize() override {
+        // Добавляем как компонент родительского узла
+        this->addVariableNode(parentNodeId, UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT));
+    }
+};
+
+// ============================== КЛАСС УСТАВКИ ==============================
+// Компонент, который клиент может записать. Запись не меняет значение сразу:
+// она проверяется (тип, диапазон EURange) и ставится в очередь команд сервера.
+// Цикл симуляции на границе такта применяет команды пакетом - значение уставки
+// обновляется, а устройство получает onSetpoint() и меняет свое поведение.
+class OPCUADevice;
+
+template<typename T>
+class OPCUASetpointVariable : public OPCUAComponentVariable<T>, public SetpointTarget {
+    static_assert(UATypeTraits<T>::ARRAY_LENGTH == 0, "Уставка - скаляр");
+    
+private:
+    OPCUADevice* owner;
+    UA_Range range;
+    SetpointQueue* commands;
+    
+public:
+    OPCUASetpointVariable(OPCUADevice* device, UA_UInt16 nsIndex, UA_UInt32 id,
+                          const std::string& browseName, const std::string& displayName,
+                          const std::string& description, const T& initialValue,
+                          double low, double high);
+    
+    void initialize() override {
+        OPCUAComponentVariable<T>::initialize();
+        addRangeProperty();
+    }
+    
+    // Вызывается потоком симуляции при разборе очереди
+    void applySetpoint(double value) override;
+    
+protected:
+    UA_StatusCode writeFromClient(const UA_DataValue* value) override {
+        if (!value->hasValue || !UA_Variant_hasScalarType(&value->value, UATypeTraits<T>::type())) {
+            return UA_STATUSCODE_BADTYPEMISMATCH;
+        }
+        double requested = static_cast<double>(*static_cast<const T*>(value->value.data));
+        // NaN не проходит ни одно сравнение, поэтому проверяется отдельно
+        if (!std::isfinite(requested) || requested < range.low || requested > range.high) {
+            return UA_STATUSCODE_BADOUTOFRANGE;
+        }
+        if (!commands->push(SetpointCommand{this, requested})) {
+            return UA_STATUSCODE_BADRESOURCEUNAVAILABLE;
+        }
+        return UA_STATUSCODE_GOOD;
+    }
+    
+private:
+    void addRangeProperty() {
+        UA_VariableAttributes attr = UA_VariableAttributes_default;
+        UALocalizedText displayNameText("en-US", "EURange");
+        UAQualifiedName qualifiedName(this->nodeId.namespaceIndex, "EURange");
+        attr.displayName = *displayNameText.get();
+        attr.dataType = UA_TYPES[UA_TYPES_RANGE].typeId;
+        attr.valueRank = UA_VALUERANK_SCALAR;
+        UA_Variant_setScalar(&attr.value, &range, &UA_TYPES[UA_TYPES_RANGE]);
+        
+        UA_Server_addVariableNode(this->server, this->propertyNodeId(),
+            this->nodeId,
+            UA_NODEID_NUMERIC(0, UA_NS0ID_HASPROPERTY),
+            *qualifiedName.get(),
+            UA_NODEID_NUMERIC(0, UA_NS0ID_PROPERTYTYPE),
+            attr, NULL, NULL);
+    }
+};
+
+// ============================== КЛАСС ОСЦИЛЛОГРАММЫ ==============================
+// Массив из length отсчетов с частотой sampleRate (Гц) - компонент устройства.
+// Симулятор дописывает отсчеты через append(); каждые length отсчетов образуют
+// кадр, который публикуется через тройной буфер. Сетевой поток перед итерацией
+// сервера вызывает acquire() и до следующего вызова отдает передний кадр
+// клиентам без копирования и без блокировок.
+//
+// Свойство SampleRate (HasProperty) сообщает клиентам частоту дискретизации.
+class OPCUAWaveformBase : public OPCUANode {
+public:
+    using OPCUANode::OPCUANode;
+    
+    // Делает последний опубликованный кадр видимым клиентам (только сетевой поток)
+    virtual bool acquire() = 0;
+};
+
+template<typename T>
+class OPCUAWaveformVariable : public OPCUAWaveformBase {
+    static_assert(UATypeTraits<T>::ARRAY_LENGTH == 0, "Элемент осциллограммы - скаляр");
+    
+private:
+    std::string displayName;
+    std::string description;
+    std::string browseName;
+    UA_NodeId parentNodeId;
+    double sampleRate;
+    UA_DateTime samplePeriod; // в единицах UA_DateTime (100 нс)
+    TripleBuffer<T> frames;
+    size_t filled;            // отсчетов в заднем буфере
+    
+public:
+    OPCUAWaveformVariable(UA_Server* srv, UA_UInt16 nsIndex, UA_UInt32 id,
+                          const std::string& browseName, const std::string& displayName,
+                          const std::string& description, const UA_NodeId& parentId,
+                          size_t length, double sampleRateHz)
+        : OPCUAWaveformBase(srv, UA_NODEID_NUMERIC(nsIndex, id)),
+          displayName(displayName),
+          description(description),
+          browseName(browseName),
+          parentNodeId(parentId),
+          sampleRate(sampleRateHz),
+          samplePeriod(static_cast<UA_DateTime>(UA_DATETIME_SEC / sampleRateHz)),
+          frames(length),
+          filled(0) {}
+    
+    void initialize() override {
+        UA_VariableAttributes attr = UA_VariableAttributes_default;
+        
+        UALocalizedText displayNameText("en-US", displayName.c_str());
+        UALocalizedText descriptionText("en-US", description.c_str());
+        UAQualifiedName qualifiedName(nodeId.namespaceIndex, browseName.c_str());
+        
+        UA_UInt32 arrayDimension = static_cast<UA_UInt32>(frames.frameLength());
+        attr.displayName = *displayNameText.get();
+        attr.description = *descriptionText.get();
+        attr.dataType = UATypeTraits<T>::type()->typeId;
+        attr.valueRank = UA_VALUERANK_ONE_DIMENSION;
+        attr.arrayDimensionsSize = 1;
+        attr.arrayDimensions = &arrayDimension;
+        attr.accessLevel = UA_ACCESSLEVELMASK_READ;
+        attr.userAccessLevel = UA_ACCESSLEVELMASK_READ;
+        
+        UA_DataSource dataSource;
+        dataSource.read = &OPCUAWaveformVariable::readDataSource;
+        dataSource.write = NULL;
+        
+        UA_Server_addDataSourceVariableNode(server, nodeId,
+            parentNodeId,
+            UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+            *qualifiedName.get(),
+            UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+            attr, dataSource, this, NULL);
+        
+        addSampleRateProperty();
+    }
+    
+    size_t getLength() const { return frames.frameLength(); }
+    double getSampleRate() const { return sampleRate; }
+    
+    // Дописывает отсчеты; lastSampleTime - время последнего из них.
+    // Вызывается только потоком симулятора.
+    void append(const T* samples, size_t count, UA_DateTime lastSampleTime) {
+        size_t length = frames.frameLength();
+        while (count > 0) {
+            size_t chunk = std::min(count, length - filled);
+            std::copy(samples, samples + chunk, frames.backBuffer() + filled);
+            samples += chunk;
+            count -= chunk;
+            filled += chunk;
+            if (filled == length) {
+                // Метка кадра - время его последнего отсчета
+                frames.publish(lastSampleTime - static_cast<UA_DateTime>(count) * samplePeriod);
+                filled = 0;
+            }
+        }
+    }
+    
+    bool acquire() override {
+        return frames.acquire();
+    }
+    
+private:
+    void addSampleRateProperty() {
+        UA_VariableAttributes attr = UA_VariableAttributes_default;
+        UALocalizedText displayNameText("en-US", "SampleRate");
+        UAQualifiedName qualifiedName(nodeId.namespaceIndex, "SampleRate");
+        attr.displayName = *displayNameText.get();
+        attr.dataType = UA_TYPES[UA_TYPES_DOUBLE].typeId;
+        attr.valueRank = UA_VALUERANK_SCALAR;
+        UA_Variant_setScalar(&attr.value, &sampleRate, &UA_TYPES[UA_TYPES_DOUBLE]);
+        
+        UA_Server_addVariableNode(server, propertyNodeId(),
+            nodeId,
+            UA_NODEID_NUMERIC(0, UA_NS0ID_HASPROPERTY),
+            *qualifiedName.get(),
+            UA_NODEID_NUMERIC(0, UA_NS0ID_PROPERTYTYPE),
+            attr, NULL, NULL);
+    }
+    
+    // Передний кадр отдается без копии (UA_VARIANT_DATA_NODELETE): он не меняется до
+    // следующего acquire(), а освободившийся буфер симулятор заполняет с начала
+    // только после очередной публикации.
+    static UA_StatusCode readDataSource(UA_Server*, const UA_NodeId*, void*, const UA_NodeId*,
+                                        void* nodeContext, UA_Boolean includeSourceTimestamp,
+                                        const UA_NumericRange* range, UA_DataValue* value) {
+        OPCUAWaveformVariable* self = static_cast<OPCUAWaveformVariable*>(nodeContext);
+        if (!self) {
+            return UA_STATUSCODE_BADINTERNALERROR;
+        }
+        
+        UA_Variant frame;
+        UA_Variant_setArray(&frame, const_cast<T*>(self->frames.frontBuffer()),
+                            self->frames.frameLength(), UATypeTraits<T>::type());
+        frame.storageType = UA_VARIANT_DATA_NODELETE;
+        
+        if (range) {
+            UA_StatusCode status = UA_Variant_copyRange(&frame, &value->value, *range);
+            if (status != UA_STATUSCODE_GOOD) {
+                return status;
+            }
+        } else {
+            value->value = frame;
+        }
+        value->hasValue = true;
+        
+        UA_DateTime stamp = self->frames.frontStamp();
+        if (includeSourceTimestamp && stamp != 0) {
+            value->sourceTimestamp = stamp;
+            value->hasSourceTimestamp = true;
+        }
+        return UA_STATUSCODE_GOOD;
+    }
+};
+
+// ============================== КЛАСС УСТРОЙСТВА ==============================
+class OPCUADevice : public OPCUANode {
+protected:
+    std::string displayName;
+    std::string description;
+    std::string browseName;
+    std::vector<std::unique_ptr<OPCUANode>> components;
+    std::vector<OPCUAWaveformBase*> waveforms;
+    
+public:
+    OPCUADevice(UA_Server* srv, UA_UInt16 nsIndex, UA_UInt32 id,
+                const std::string& browseName, const std::string& displayName,
+                const std::string& description)
+        : OPCUANode(srv, UA_NODEID_NUMERIC(nsIndex, id)),
+          displayName(displayName),
+          description(description),
+          browseName(browseName) {}
+    
+    void initialize() override {
+        UA_ObjectAttributes attr = UA_ObjectAttributes_default;
+        
+        UALocalizedText displayNameText("en-US", displayName.c_str());
+        UALocalizedText descriptionText("en-US", description.c_str());
+        UAQualifiedName qualifiedName(nodeId.namespaceIndex, browseName.c_str());
+        
+        attr.displayName = *displayNameText.get();
+        attr.description = *descriptionText.get();
+        
+        UA_StatusCode status = UA_Server_addObjectNode(
+            server, nodeId,
+            UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+            UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+            *qualifiedName.get(),
+            UA_NODEID_NUMERIC(0, UA_NS0ID_FOLDERTYPE),
+            attr, NULL, NULL);
+        
+        // Инициализируем все компоненты
+        for (auto& component : components) {
+            if (component) {
+                component->initialize();
+            }
+        }
+    }
+    
+    void addComponent(std::unique_ptr<OPCUANode> component) {
+        components.push_back(std::move(component));
+    }
+    
+    // Удаляет узел устройства из адресного пространства; компоненты и их
+    // свойства open62541 удаляет вместе с ним (ссылки HasComponent/HasProperty)
+    UA_StatusCode removeNodes() {
+        return UA_Server_deleteNode(server, nodeId, true);
+    }
+    
+    // Освобождает слоты переменных в ValueStore. Вызывать после removeNodes(),
+    // когда обращений к переменным уже не может быть
+    void releaseSlots() {
+        for (auto& component : components) {
+            if (auto* variable = dynamic_cast<OPCUAVariableBase*>(component.get())) {
+                variable->releaseSlot();
+            }
+        }
+    }
+    
+    const std::string& getBrowseName() const { return browseName; }
+    
+    // Обход переменных-компонентов (осциллограммы сюда не входят)
+    template<typename Fn>
+    void forEachVariable(Fn fn) const {
+        for (const auto& component : components) {
+            if (auto* variable = dynamic_cast<const OPCUAVariableBase*>(component.get())) {
+                fn(*variable);
+            }
+        }
+    }
+    
+    // Объявляет компонент входом для вычисляемых тегов (имя в выражениях - browseName).
+    // Значения графа - double, в узел пишутся с приведением к типу переменной.
+    template<typename T>
+    DerivedTagEngine::Slot bindInput(OPCUAVariable<T>* component, const std::string& name,
+                                     double initialValue) {
+        DerivedTagEngine::Slot slot = derived.addInput(name, initialValue);
+        bindSlot(slot, component);
+        return slot;
+    }
+    
+    // Создает компонент, значение которого вычисляется по выражению над другими тегами.
+    // Должен вызываться до initialize(). Бросает std::invalid_argument при ошибке в выражении.
+    template<typename T = double>
+    OPCUAComponentVariable<T>* addDerivedComponent(UA_UInt32 id, const std::string& browseName,
+                                                   const std::string& displayName,
+                                                   const std::string& description,
+                                                   const std::string& expression) {
+        DerivedTagEngine::Slot slot = derived.addTag(browseName, expression);
+        auto variable = std::make_unique<OPCUAComponentVariable<T>>(
+            server, nodeId.namespaceIndex, id, browseName, displayName, description,
+            UATypeTraits<T>::fromDouble(derived.get(slot)), nodeId);
+        
+        OPCUAComponentVariable<T>* raw = variable.get();
+        bindSlot(slot, raw);
+        addComponent(std::move(variable));
+        return raw;
+    }
+    
+    // Создает уставку, изменяемую клиентами в пределах [low, high]; должен
+    // вызываться до initialize(). Примененные значения приходят в onSetpoint().
+    template<typename T>
+    OPCUASetpointVariable<T>* addSetpointComponent(UA_UInt32 id, const std::string& browseName,
+                                                   const std::string& displayName,
+                                                   const std::string& description,
+                                                   const T& initialValue, double low, double high) {
+        auto setpoint = std::make_unique<OPCUASetpointVariable<T>>(
+            this, nodeId.namespaceIndex, id, browseName, displayName, description,
+            initialValue, low, high);
+        
+        OPCUASetpointVariable<T>* raw = setpoint.get();
+        addComponent(std::move(setpoint));
+        return raw;
+    }
+    
+    // Создает компонент-осциллограмму; должен вызываться до initialize()
+    template<typename T>
+    OPCUAWaveformVariable<T>* addWaveformComponent(UA_UInt32 id, const std::string& browseName,
+                                                   const std::string& displayName,
+                                                   const std::string& description,
+                                                   size_t length, double sampleRateHz) {
+        auto waveform = std::make_unique<OPCUAWaveformVariable<T>>(
+            server, nodeId.namespaceIndex, id, browseName, displayName, description,
+            nodeId, length, sampleRateHz);
+        
+        OPCUAWaveformVariable<T>* raw = waveform.get();
+        waveforms.push_back(raw);
+        addComponent(std::move(waveform));
+        return raw;
+    }
+    
+    // Публикует клиентам новые кадры осциллограмм (вызывается сетевым потоком
+    // перед UA_Server_run_iterate)
+    void acquireWaveforms() {
+        for (OPCUAWaveformBase* waveform : waveforms) {
+            waveform->acquire();
+        }
+    }
+    
+    const DerivedTagEngine& getDerivedTags() const { return derived; }
+    
+    // Вывод значений в консоль при каждом обновлении (отключается в бенчмарках)
+    void setVerbose(bool enabled) { verbose = enabled; }
+    
+    virtual void updateValues() = 0;
+    
+    // Применение уставки на границе такта (поток симуляции)
+    virtual void onSetpoint(OPCUAVariableBase* setpoint, double value) {
+        (void)setpoint;
+        (void)value;
+    }
+    
+protected:
+    bool verbose = true;
+    DerivedTagEngine derived;
+    
+    // Записывает входное значение в узел и в граф зависимостей
+    void setInput(DerivedTagEngine::Slot slot, double value) {
+        writeBound(slot, value);
+        derived.set(slot, value);
+    }
+    
+    // Пересчитывает затронутые вычисляемые теги и записывает изменившиеся в узлы
+    void commitDerived() {
+        derived.evaluate([this](DerivedTagEngine::Slot slot, double value) {
+            writeBound(slot, value);
+        });
+    }
+    
+private:
+    // Слот графа -> переменная и функция записи, инстанцированная для ее типа
+    struct SlotBinding {
+        OPCUAVariableBase* variable = nullptr;
+        void (*write)(OPCUAVariableBase*, double) = nullptr;
+    };
+    std::vector<SlotBinding> slotBindings;
+    
+    template<typename T>
+    static void writeConverted(OPCUAVariableBase* variable, double value) {
+        static_cast<OPCUAVariable<T>*>(variable)->writeValue(UATypeTraits<T>::fromDouble(value));
+    }
+    
+    void writeBound(DerivedTagEngine::Slot slot, double value) {
+        if (slot < slotBindings.size() && slotBindings[slot].variable) {
+            slotBindings[slot].write(slotBindings[slot].variable, value);
+        }
+    }
+    
+    template<typename T>
+    void bindSlot(DerivedTagEngine::Slot slot, OPCUAVariable<T>* component) {
+        static_assert(UATypeTraits<T>::ARRAY_LENGTH == 0, "Теги графа - только скаляры");
+        if (slotBindings.size() <= slot) {
+            slotBindings.resize(slot + 1);
+        }
+        slotBindings[slot].variable = component;
+        slotBindings[slot].write = &OPCUADevice::writeConverted<T>;
+    }
+};
+
+// ============================== РЕАЛИЗАЦИЯ УСТАВКИ ==============================
+template<typename T>
+OPCUASetpointVariable<T>::OPCUASetpointVariable(OPCUADevice* device, UA_UInt16 nsIndex, UA_UInt32 id,
+                                                const std::string& browseName,
+                                                const std::string& displayName,
+                                                const std::string& description,
+                                                const T& initialValue, double low, double high)
+    : OPCUAComponentVariable<T>(device->getServer(), nsIndex, id, browseName, displayName,
+                                description, initialValue, device->getNodeId()),
+      owner(device),
+      commands(&EquipmentNodestore::commandsFor(device->getServer())) {
+    range.low = low;
+    range.high = high;
+    this->accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
+}
+
+template<typename T>
+void OPCUASetpointVariable<T>::applySetpoint(double value) {
+    this->writeValue(UATypeTraits<T>::fromDouble(value));
+    owner->onSetpoint(this, value);
+}
+
+// Разбирает очередь уставок сервера; вызывается циклом симуляции в начале такта
+inline size_t applySetpointCommands(UA_Server* server) {
+    return EquipmentNodestore::commandsFor(server).drain([](const SetpointCommand& command) {
+        command.target->applySetpoint(command.value);
+    });
+}
@@ -0,0 +1,495 @@
+#pragma once
+
+#include <open62541/server.h>
+#include <open62541/server_config_default.h>
+#include <open62541/plugin/log_stdout.h>
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <functional>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+#include "devices.h"
+#include "device_fleet.h"
+#include "equipment_control.h"
+#include "trace.h"
+#include "realtime.h"
+#include "dashboard_stream.h"
+#include "push_sampling.h"
+#ifdef SERVER_IO_URING
+#include "uring_event_loop.h"
+#endif
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// Раздельные потоки симуляции и сети требуют open62541, собранного с
+// UA_MULTITHREADING >= 100: вызовы API сервера из разных потоков защищены его
+// блокировкой
+#if defined(SERVER_MULTITHREADED) && (!defined(UA_MULTITHREADING) || UA_MULTITHREADING < 100)
+#error "SERVER_MULTITHREADED requires open62541 built with UA_MULTITHREADING >= 100"
+#endif
+
+// ============================== КЛАСС СЕРВЕРА OPC UA ==============================
+class OPCUAServer {
+private:
+    UA_Server* server;
+    UA_UInt16 namespaceIndex;
+    UA_UInt16 port;
+    UA_LogLevel logLevel;
+    std::atomic<bool> running;
+    std::unique_ptr<DeviceFleet> fleet;
+    size_t fleetChangesPerTick;
+    std::unique_ptr<EquipmentControl> control;
+    std::unique_ptr<DashboardStream> dashboard;
+    uint16_t dashboardPort;
+    std::unique_ptr<PushSampler> sampler;
+#ifdef SERVER_POOLED_ALLOCATOR
+    PoolSnapshot poolAtLastTick;
+#endif
+#ifdef SERVER_IO_URING
+    std::unique_ptr<UringEventLoop> uring; // живет дольше сервера
+#endif
+    
+    // Расписание тактов
+    std::chrono::steady_clock::duration tickPeriod;
+    RealtimeOptions realtime;
+    bool consoleOutput;
+    JitterHistogram tickStartError; // начало такта относительно срока
+    JitterHistogram tickDuration;
+    uint64_t tickOverruns;
+    std::function<void(uint64_t)> tickObserver; // длительность такта в нс
+    
+public:
+    OPCUAServer() : server(nullptr), namespaceIndex(0), port(4840), logLevel(UA_LOGLEVEL_INFO), running(true),
+                    fleetChangesPerTick(64), dashboardPort(0), tickPeriod(std::chrono::milliseconds(330)), consoleOutput(true),
+                    tickOverruns(0) {
+        initConsole();
+    }
+    
+    ~OPCUAServer() {
+        stop();
+    }
+    
+    // Запрещаем копирование
+    OPCUAServer(const OPCUAServer&) = delete;
+    OPCUAServer& operator=(const OPCUAServer&) = delete;
+    
+    bool initialize() {
+        std::cout << "OPC UA Server initializing..." << std::endl;
+        
+        // Настраиваем конфигурацию
+        UA_ServerConfig config;
+        std::memset(&config, 0, sizeof(config));
+        config.logging = UA_Log_Stdout_new(logLevel);
+#ifdef SERVER_IO_URING
+        // Сеть на io_uring: цикл событий создается до сервера и передается в
+        // конфигурацию как внешний
+        uring = std::make_unique<UringEventLoop>();
+        if (!uring->initialize()) {
+            uring.reset();
+            return false;
+        }
+        config.eventLoop = uring->getEventLoop();
+        config.externalEventLoop = true;
+#endif
+        UA_ServerConfig_setMinimal(&config, port, NULL);
+        
+        // Создаем сервер
+        server = UA_Server_newWithConfig(&config);
+        if (!server) {
+            std::cerr << "Failed to create server" << std::endl;
+            return false;
+        }
+        
+        // Добавляем пространство имен
+        namespaceIndex = UA_Server_addNamespace(server, "EquipmentNamespace");
+        
+        // Создаем устройства; остальные добавляются методом AddDevices
+        fleet = std::make_unique<DeviceFleet>(server, namespaceIndex, fleetChangesPerTick);
+        fleet->addNow(DeviceFleet::Kind::Multimeter, 100, "Multimeter");
+        fleet->addNow(DeviceFleet::Kind::Machine, 200, "Machine");
+        fleet->addNow(DeviceFleet::Kind::Computer, 300, "Computer");
+        
+        // Служебные методы (ручки для быстрого чтения/записи, состав устройств)
+        control = std::make_unique<EquipmentControl>(server, namespaceIndex, fleet.get());
+        control->initialize();
+        
+        // MonitoredItems с SamplingInterval = 0 выбираются в конце такта: значения
+        // узлов - DataSource, и без выборки такие MonitoredItems не получали бы
+        // ничего, кроме начального значения
+        sampler = std::make_unique<PushSampler>(server);
+        
+        // Поток значений для веб-панелей (см. DashboardStream)
+        if (dashboardPort != 0) {
+            dashboard = std::make_unique<DashboardStream>(dashboardPort);
+            trackFleet();
+        }
+        
+        return true;
+    }
+    
+    bool start() {
+        std::cout << "\n===========================================" << std::endl;
+        std::cout << "OPC UA Server запущен на opc.tcp://localhost:" << port << std::endl;
+        std::cout << "===========================================" << std::endl;
+        std::cout << "\nСтруктура устройств и переменных:" << std::endl;
+        std::cout << "\n1. Мультиметр (ID: ns=" << namespaceIndex << ";i=100)" << std::endl;
+        std::cout << "   ├── Напряжение (ID: ns=" << namespaceIndex << ";i=101)" << std::endl;
+        std::cout << "   ├── Сила тока (ID: ns=" << namespaceIndex << ";i=102)" << std::endl;
+        std::cout << "   ├── Сопротивление (ID: ns=" << namespaceIndex << ";i=103)" << std::endl;
+        std::cout << "   ├── Мощность (ID: ns=" << namespaceIndex << ";i=104)" << std::endl;
+        std::cout << "   ├── Осциллограмма напряжения (ID: ns=" << namespaceIndex << ";i=105)" << std::endl;
+        std::cout << "   └── Осциллограмма тока (ID: ns=" << namespaceIndex << ";i=106)" << std::endl;
+        
+        std::cout << "\n2. Станок (ID: ns=" << namespaceIndex << ";i=200)" << std::endl;
+        std::cout << "   ├── Обороты маховика (ID: ns=" << namespaceIndex << ";i=201)" << std::endl;
+        std::cout << "   ├── Мощность (ID: ns=" << namespaceIndex << ";i=202)" << std::endl;
+        std::cout << "   ├── Напряжение (ID: ns=" << namespaceIndex << ";i=203)" << std::endl;
+        std::cout << "   ├── Потребление энергии (ID: ns=" << namespaceIndex << ";i=204)" << std::endl;
+        std::cout << "   ├── В работе (ID: ns=" << namespaceIndex << ";i=205)" << std::endl;
+        std::cout << "   └── Заданные обороты, запись (ID: ns=" << namespaceIndex << ";i=206)" << std::endl;
+        
+        std::cout << "\n3. Компьютер (ID: ns=" << namespaceIndex << ";i=300)" << std::endl;
+        std::cout << "   ├── Вентилятор 1 (ID: ns=" << namespaceIndex << ";i=301)" << std::endl;
+        std::cout << "   ├── Вентилятор 2 (ID: ns=" << namespaceIndex << ";i=302)" << std::endl;
+        std::cout << "   ├── Вентилятор 3 (ID: ns=" << namespaceIndex << ";i=303)" << std::endl;
+        std::cout << "   ├── Загрузка ЦП (ID: ns=" << namespaceIndex << ";i=304)" << std::endl;
+        std::cout << "   ├── Загрузка ГП (ID: ns=" << namespaceIndex << ";i=305)" << std::endl;
+        std::cout << "   └── Использование ОЗУ (ID: ns=" << namespaceIndex << ";i=306)" << std::endl;
+        
+        std::cout << "\n4. Управление оборудованием (ID: ns=" << namespaceIndex << ";i=10)" << std::endl;
+        std::cout << "   ├── RegisterHandles (ID: ns=" << namespaceIndex << ";i=11)" << std::endl;
+        std::cout << "   ├── CommandsEnqueued (ID: ns=" << namespaceIndex << ";i=12)" << std::endl;
+        std::cout << "   ├── CommandsApplied (ID: ns=" << namespaceIndex << ";i=13)" << std::endl;
+#ifdef SERVER_POOLED_ALLOCATOR
+        std::cout << "   ├── PooledAllocations (ID: ns=" << namespaceIndex << ";i=14)" << std::endl;
+        std::cout << "   ├── SystemAllocations (ID: ns=" << namespaceIndex << ";i=15)" << std::endl;
+#endif
+        std::cout << "   ├── AddDevices (ID: ns=" << namespaceIndex << ";i=16)" << std::endl;
+        std::cout << "   ├── RemoveDevices (ID: ns=" << namespaceIndex << ";i=17)" << std::endl;
+        std::cout << "   ├── FleetChangesEnqueued (ID: ns=" << namespaceIndex << ";i=18)" << std::endl;
+        std::cout << "   └── FleetChangesApplied (ID: ns=" << namespaceIndex << ";i=19)" << std::endl;
+        if (dashboard) {
+            if (dashboard->start()) {
+                std::cout << "\nПанель значений: http://localhost:" << dashboard->getPort()
+                          << "/ (WebSocket /stream, значений: " << dashboard->getNames().size() << ")" << std::endl;
+            } else {
+                dashboard.reset();
+            }
+        }
+#ifdef SERVER_IO_URING
+        std::cout << "\nСетевой цикл: io_uring" << std::endl;
+#endif
+        std::cout << "\n===========================================" << std::endl;
+        std::cout << "Для остановки сервера нажмите Ctrl+C" << std::endl;
+        std::cout << "===========================================\n" << std::endl;
+        
+        // Запускаем сервер
+        UA_StatusCode status = UA_Server_run_startup(server);
+        if (status != UA_STATUSCODE_GOOD) {
+            std::cerr << "Failed to start server: " << UA_StatusCode_name(status) << std::endl;
+            return false;
+        }
+        
+        return true;
+    }
+    
+    // Порт OPC UA и уровень журнала open62541; вызывать до initialize()
+    void setPort(UA_UInt16 portNumber) {
+        port = portNumber;
+    }
+    
+    void setLogLevel(UA_LogLevel level) {
+        logLevel = level;
+    }
+    
+    UA_UInt16 getNamespaceIndex() const { return namespaceIndex; }
+    
+    // Порт HTTP/WebSocket для веб-панелей, 0 - выключено; вызывать до initialize()
+    void setDashboardPort(uint16_t port) {
+        dashboardPort = port;
+    }
+    
+    // Сколько устройств AddDevices/RemoveDevices создается или удаляется за
+    // такт (0 - без ограничения); можно менять и во время run()
+    void setFleetChangesPerTick(size_t changes) {
+        fleetChangesPerTick = changes;
+        if (fleet) {
+            fleet->setMaxChangesPerTick(changes);
+        }
+    }
+    
+    // Вызывать до run()
+    void setTickPeriod(std::chrono::microseconds period) {
+        tickPeriod = period;
+    }
+    
+    // Режим реального времени для потока симуляции (см. realtime.h). Вывод в
+    // консоль на каждом такте (и system("clear")) в этом режиме отключается:
+    // он дает задержки в миллисекунды.
+    void setRealtime(const RealtimeOptions& options) {
+        realtime = options;
+        consoleOutput = !options.enabled;
+    }
+    
+    // Вывод в консоль на каждом такте; вызывать до run()
+    void setConsoleOutput(bool enabled) {
+        consoleOutput = enabled;
+    }
+    
+    // Вызывается в потоке симуляции после каждого такта с его длительностью в
+    // нс (длительный прогон собирает по ним перцентили); вызывать до run()
+    void setTickObserver(std::function<void(uint64_t)> observer) {
+        tickObserver = std::move(observer);
+    }
+    
+    // Основной цикл; возвращает управление после requestStop().
+    //
+    // Однопоточная сборка: между тактами симуляции поток не спит, а обслуживает
+    // сеть до начала следующего такта, поэтому запросы клиентов не ждут паузу.
+    // SERVER_MULTITHREADED: симуляция работает в отдельном потоке, а этот поток
+    // только обслуживает сеть. Сервисы читают хранилище значений, пока симуляция
+    // в него пишет (см. ValueStore); записи клиентов доходят до устройств через
+    // очередь уставок. Сами сервисы параллельно не выполняются: open62541 1.4
+    // обрабатывает их под одной блокировкой сервера, и независимые Read
+    // используют не больше одного ядра.
+    //
+    // Такты начинаются по абсолютным срокам (см. DeadlineTimer). В режиме
+    // реального времени однопоточный цикл прекращает обслуживать сеть за
+    // REALTIME_GUARD до срока и досыпает через clock_nanosleep; запрос, начатый
+    // до этого, все же может задержать такт - точнее сроки держит сборка
+    // SERVER_MULTITHREADED, где поток симуляции занят только тактами.
+    void run() {
+        attachAllocator();
+        fleet->setVerbose(consoleOutput);
+#ifdef SERVER_MULTITHREADED
+        std::thread simulation([this]() {
+            attachAllocator();
+            if (realtime.enabled) {
+                applyRealtime(realtime, "simulation");
+            }
+            DeadlineTimer timer(tickPeriod);
+            uint64_t counter = 0;
+            while (running) {
+                timedTick(timer, ++counter);
+                timer.advance();
+                timer.sleepUntilDeadline();
+            }
+            tickOverruns = timer.overruns();
+        });
+        
+        while (running) {
+            serveNetwork(NETWORK_WAIT_MS);
+            
+            // Выгрузка трассы по SIGUSR1
+            TRACE_DUMP_IF_REQUESTED();
+        }
+        simulation.join();
+#else
+        if (realtime.enabled) {
+            applyRealtime(realtime, "server");
+        }
+        DeadlineTimer timer(tickPeriod);
+        uint64_t counter = 0;
+        while (running) {
+            timedTick(timer, ++counter);
+            
+            // Выгрузка трассы по SIGUSR1
+            TRACE_DUMP_IF_REQUESTED();
+            
+            // До следующего такта обслуживаем сетевые события
+            timer.advance();
+            auto serveUntil = timer.deadline() - (realtime.enabled ? REALTIME_GUARD : std::chrono::milliseconds(0));
+            for (auto now = std::chrono::steady_clock::now(); running && now < serveUntil;
+                 now = std::chrono::steady_clock::now()) {
+                auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(serveUntil - now).count();
+                serveNetwork(static_cast<UA_UInt32>(std::min<long long>(std::max<long long>(remaining, 1),
+                                                                        NETWORK_WAIT_MS)));
+            }
+            if (realtime.enabled && running) {
+                timer.sleepUntilDeadline();
+            }
+        }
+        tickOverruns = timer.overruns();
+#endif
+    }
+    
+    // Гистограммы джиттера; вызывать после выхода из run()
+    void printTickReport() const {
+        std::cout << "\n========== ТАКТЫ (период "
+                  << std::chrono::duration_cast<std::chrono::microseconds>(tickPeriod).count() / 1000.0
+                  << " мс, пропущено сроков: " << tickOverruns << ") ==========" << std::endl;
+        tickStartError.print(std::cout, "Отклонение начала такта");
+        tickDuration.print(std::cout, "Длительность такта");
+        if (sampler) {
+            sampler->print(std::cout);
+        }
+        if (fleet) {
+            fleet->print(std::cout);
+        }
+#ifdef SERVER_IO_URING
+        if (uring) {
+            uring->print(std::cout);
+        }
+#endif
+    }
+    
+    // Сигнал циклу run() завершиться; безопасно вызывать из обработчика сигнала
+    void requestStop() {
+        running = false;
+    }
+    
+    // Освобождение сервера; вызывать после выхода из run()
+    void stop() {
+        running = false;
+        
+        if (server) {
+            std::cout << "\nОстановка сервера..." << std::endl;
+            
+            // ВАЖНО: Сначала очищаем все узлы, которые ссылаются на сервер
+            dashboard.reset();
+            sampler.reset();
+            control.reset();
+            fleet.reset();
+            
+            // Затем останавливаем и удаляем сервер
+            UA_Server_run_shutdown(server);
+#ifdef SERVER_IO_URING
+            // Внешний цикл сервер не останавливает: соединения закрываются здесь
+            if (uring) {
+                uring->shutdown();
+            }
+#endif
+            UA_Server_delete(server);
+            server = nullptr;
+#ifdef SERVER_IO_URING
+            uring.reset();
+#endif
+            
+            std::cout << "Сервер остановлен." << std::endl;
+        }
+    }
+    
+private:
+    static constexpr UA_UInt32 NETWORK_WAIT_MS = 50; // реакция на requestStop()
+    static constexpr std::chrono::milliseconds REALTIME_GUARD{2};
+    
+    // Все числовые значения текущих устройств - веб-панелям
+    void trackFleet() {
+        dashboard->untrackAll();
+        fleet->forEach([this](const OPCUADevice& device) {
+            dashboard->trackDevice(device);
+        });
+    }
+    
+    // Такт с замером отклонения от срока и длительности
+    void timedTick(const DeadlineTimer& timer, uint64_t counter) {
+        auto started = std::chrono::steady_clock::now();
+        tickStartError.record(std::chrono::duration_cast<std::chrono::nanoseconds>(started - timer.deadline()).count());
+        tick(counter);
+        int64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - started).count();
+        tickDuration.record(elapsed);
+        if (tickObserver) {
+            tickObserver(static_cast<uint64_t>(elapsed));
+        }
+    }
+    
+    // Один такт симуляции: команды клиентов, состав устройств, обновление
+    // устройств, вывод
+    void tick(uint64_t counter) {
+        TRACE_SPAN("tick");
+        
+        if (consoleOutput) {
+            TRACE_SPAN("console");
+            // Очищаем экран для красивого вывода (только для Windows)
+            clearConsole();
+            
+            std::cout << "===========================================" << std::endl;
+            std::cout << "ЦИКЛ ОБНОВЛЕНИЯ: " << counter << std::endl;
+            std::cout << "===========================================" << std::endl;
+        }
+        
+        // Записи клиентов в уставки применяются пакетом до обновления устройств
+        {
+            TRACE_SPAN("commands");
+            applySetpointCommands(server);
+        }
+        
+        // Добавление и удаление устройств - после команд, чтобы уставки
+        // удаляемого устройства успели примениться
+        if (fleet->apply(counter) > 0 && dashboard) {
+            trackFleet();
+        }
+        
+        // Обновляем значения всех устройств
+        fleet->updateValues();
+        
+        // Изменения за такт - подпискам клиентов
+        if (sampler) {
+            sampler->commit();
+        }
+        
+        // Изменения за такт - веб-панелям
+        if (dashboard) {
+            dashboard->publish(counter);
+        }
+        
+        if (!consoleOutput) {
+            return;
+        }
+        
+#ifdef SERVER_POOLED_ALLOCATOR
+        // Выделения памяти с прошлого такта (включая обслуживание сети)
+        PoolSnapshot pool = PoolAllocator::snapshot();
+        PoolSnapshot delta = pool - poolAtLastTick;
+        poolAtLastTick = pool;
+        std::cout << "Память за цикл: пул " << delta.pooledAllocations
+                  << ", система " << delta.systemAllocations
+                  << " (страниц пула: " << pool.pagesInUse << ")" << std::endl;
+#endif
+        
+        std::cout << "===========================================" << std::endl;
+    }
+    
+    // Выделения open62541 из потока сервера идут через пул (см. PoolAllocator)
+    static void attachAllocator() {
+#ifdef SERVER_POOLED_ALLOCATOR
+        PoolAllocator::attachThread();
+#endif
+    }
+    
+    // Публикация новых кадров осциллограмм и обработка сетевых событий не дольше
+    // maxWaitMs (UA_Server_run_iterate ограничивает ожидание 200 мс и не дает
+    // задать его точнее, поэтому цикл событий вызывается напрямую)
+    void serveNetwork(UA_UInt32 maxWaitMs) {
+        // Кадр осциллограммы читается сервисами без копии, поэтому он меняется
+        // только в этом потоке - между обработками запросов
+        fleet->acquireWaveforms();
+        
+        TRACE_SPAN("network");
+        UA_EventLoop* eventLoop = UA_Server_getConfig(server)->eventLoop;
+        eventLoop->run(eventLoop, maxWaitMs);
+    }
+    
+    void initConsole() {
+#ifdef _WIN32
+        SetConsoleOutputCP(CP_UTF8);
+        SetConsoleCP(CP_UTF8);
+#endif
+    }
+    
+    void clearConsole() {
+#ifdef _WIN32
+        system("cls");
+#else
+        system("clear");
+#endif
+    }
+};
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <open62541/types.h>
+#include <cstring>
+
+// ============================== RAII ОБЕРТКИ ДЛЯ open62541 ==============================
+class UAString {
+private:
+    UA_String str;
+    bool ownsMemory;
+    
+public:
+    UAString(const char* cstr) : ownsMemory(true) {
+        str.length = strlen(cstr);
+        str.data = (UA_Byte*)UA_malloc(str.length);
+        if (str.data) {
+            memcpy(str.data, cstr, str.length);
+        } else {
+            str.length = 0;
+            ownsMemory = false;
+        }
+    }
+    
+    // Запрещаем копирование
+    UAString(const UAString&) = delete;
+    UAString& operator=(const UAString&) = delete;
+    
+    // Разрешаем перемещение
+    UAString(UAString&& other) noexcept : str(other.str), ownsMemory(other.ownsMemory) {
+        other.ownsMemory = false;
+        other.str.data = nullptr;
+        other.str.length = 0;
+    }
+    
+    ~UAString() {
+        if (ownsMemory) {
+            UA_String_clear(&str);
+        }
+    }
+    
+    UA_String* get() { return &str; }
+    const UA_String* get() const { return &str; }
+};
+
+class UALocalizedText {
+private:
+    UA_LocalizedText text;
+    
+public:
+    UALocalizedText(const char* locale, const char* txt) {
+        text.locale = UA_STRING_ALLOC(locale);
+        text.text = UA_STRING_ALLOC(txt);
+    }
+    
+    ~UALocalizedText() {
+        UA_LocalizedText_clear(&text);
+    }
+    
+    // Запрещаем копирование
+    UALocalizedText(const UALocalizedText&) = delete;
+    UALocalizedText& operator=(const UALocalizedText&) = delete;
+    
+    // Разрешаем перемещение
+    UALocalizedText(UALocalizedText&& other) noexcept : text(other.text) {
+        // Обнуляем у перемещенного объекта, чтобы деструктор не освободил память
+        other.text.locale.data = nullptr;
+        other.text.locale.length = 0;
+        other.text.text.data = nullptr;
+        other.text.text.length = 0;
+    }
+    
+    UA_LocalizedText* get() { return &text; }
+    const UA_LocalizedText* get() const { return &text; }
+};
+
+class UAQualifiedName {
+private:
+    UA_QualifiedName name;
+    
+public:
+    UAQualifiedName(UA_UInt16 nsIndex, const char* nameStr) {
+        name.namespaceIndex = nsIndex;
+        name.name = UA_STRING_ALLOC(nameStr);
+    }
+    
+    ~UAQualifiedName() {
+        UA_QualifiedName_clear(&name);
+    }
+    
+    // Запрещаем копирование
+    UAQualifiedName(const UAQualifiedName&) = delete;
+    UAQualifiedName& operator=(const UAQualifiedName&) = delete;
+    
+    // Разрешаем перемещение
+    UAQualifiedName(UAQualifiedName&& other) noexcept : name(other.name) {
+        // Обнуляем у перемещенного объекта
+        other.name.name.data = nullptr;
+        other.name.name.length = 0;
+    }
+    
+    UA_QualifiedName* get() { return &name; }
+    const UA_QualifiedName* get() const { return &name; }
+};
@@ -0,0 +1,324 @@
+#include <open62541/types.h>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+#include "pool_allocator.h"
+
+std::atomic<uint64_t> PoolAllocator::pooledAllocations(0);
+std::atomic<uint64_t> PoolAllocator::systemAllocations(0);
+
+// ============================== СИСТЕМНЫЙ malloc ==============================
+// При --wrap=malloc вызов malloc отсюда попал бы обратно в пул, поэтому
+// используются __real_*; при UA_ENABLE_MALLOC_SINGLETON - прежние указатели
+// open62541 (см. install()).
+// При UA_MULTITHREADING >= 100 указатели UA_freeSingleton свои у каждого потока,
+// и поток без attachThread() освобождал бы блок пула через libc free. Поэтому
+// free и realloc процесса подменяются (см. ниже) и сами определяют по адресу,
+// чей это блок; системными остаются __libc_* glibc.
+#if defined(UA_ENABLE_MALLOC_SINGLETON) && UA_MULTITHREADING >= 100 && defined(__GLIBC__)
+#define POOL_ALLOCATOR_INTERPOSE_FREE
+#endif
+
+#if defined(POOL_ALLOCATOR_WRAP_MALLOC)
+extern "C" {
+void* __real_malloc(size_t size);
+void __real_free(void* ptr);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+}
+static void* (*systemMalloc)(size_t) = __real_malloc;
+static void (*systemFree)(void*) = __real_free;
+static void* (*systemCalloc)(size_t, size_t) = __real_calloc;
+static void* (*systemRealloc)(void*, size_t) = __real_realloc;
+#elif defined(POOL_ALLOCATOR_INTERPOSE_FREE)
+extern "C" {
+void* __libc_malloc(size_t size);
+void __libc_free(void* ptr);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+}
+static void* (*systemMalloc)(size_t) = __libc_malloc;
+static void (*systemFree)(void*) = __libc_free;
+static void* (*systemCalloc)(size_t, size_t) = __libc_calloc;
+static void* (*systemRealloc)(void*, size_t) = __libc_realloc;
+#else
+static void* (*systemMalloc)(size_t) = std::malloc;
+static void (*systemFree)(void*) = std::free;
+static void* (*systemCalloc)(size_t, size_t) = std::calloc;
+static void* (*systemRealloc)(void*, size_t) = std::realloc;
+#endif
+
+// ============================== КЛАССЫ РАЗМЕРОВ И ОБЛАСТЬ ==============================
+static constexpr size_t CLASS_COUNT = 8; // 16, 32, ..., 2048
+static constexpr size_t PAGE_COUNT = PoolAllocator::ARENA_SIZE / PoolAllocator::PAGE_SIZE;
+
+static_assert(size_t(16) << (CLASS_COUNT - 1) == PoolAllocator::MAX_POOLED_SIZE,
+              "Классы размеров должны покрывать MAX_POOLED_SIZE");
+
+static size_t classSize(size_t cls) {
+    return size_t(16) << cls;
+}
+
+static size_t classIndex(size_t size) {
+    size_t cls = 0;
+    while (classSize(cls) < size) {
+        ++cls;
+    }
+    return cls;
+}
+
+static unsigned char* arenaBase = nullptr;
+static std::atomic<size_t> pagesCarved(0);
+static uint8_t pageClass[PAGE_COUNT]; // класс, на который нарезана страница
+
+static bool inArena(const void* ptr) {
+    const unsigned char* p = static_cast<const unsigned char*>(ptr);
+    return arenaBase && p >= arenaBase && p < arenaBase + PoolAllocator::ARENA_SIZE;
+}
+
+// ============================== СПИСКИ СВОБОДНЫХ БЛОКОВ ==============================
+// Свой список у каждого потока (без блокировок); излишки и запасы переходят
+// через общий список класса под мьютексом.
+struct FreeBlock {
+    FreeBlock* next;
+};
+
+struct ThreadCache {
+    FreeBlock* head[CLASS_COUNT];
+    size_t count[CLASS_COUNT];
+};
+
+struct SharedList {
+    std::mutex lock;
+    FreeBlock* head = nullptr;
+};
+
+static thread_local ThreadCache cache; // тривиальный тип: без деструктора потока
+static SharedList shared[CLASS_COUNT];
+
+// Переносит в список потока половину лимита из общего списка или новую страницу
+static bool refill(size_t cls) {
+    ThreadCache& c = cache;
+    {
+        std::lock_guard<std::mutex> guard(shared[cls].lock);
+        while (shared[cls].head && c.count[cls] < PoolAllocator::CACHE_LIMIT / 2) {
+            FreeBlock* block = shared[cls].head;
+            shared[cls].head = block->next;
+            block->next = c.head[cls];
+            c.head[cls] = block;
+            ++c.count[cls];
+        }
+    }
+    if (c.head[cls]) {
+        return true;
+    }
+
+    size_t page = pagesCarved.fetch_add(1, std::memory_order_relaxed);
+    if (page >= PAGE_COUNT) {
+        return false; // область исчерпана
+    }
+    pageClass[page] = static_cast<uint8_t>(cls);
+
+    unsigned char* begin = arenaBase + page * PoolAllocator::PAGE_SIZE;
+    size_t blocks = PoolAllocator::PAGE_SIZE / classSize(cls);
+    for (size_t i = blocks; i-- > 0;) {
+        FreeBlock* block = reinterpret_cast<FreeBlock*>(begin + i * classSize(cls));
+        block->next = c.head[cls];
+        c.head[cls] = block;
+    }
+    c.count[cls] += blocks;
+    return true;
+}
+
+// Отдает половину списка потока в общий список
+static void spill(size_t cls) {
+    ThreadCache& c = cache;
+    FreeBlock* first = c.head[cls];
+    FreeBlock* last = first;
+    for (size_t i = 1; i < PoolAllocator::CACHE_LIMIT / 2; ++i) {
+        last = last->next;
+    }
+    c.head[cls] = last->next;
+    c.count[cls] -= PoolAllocator::CACHE_LIMIT / 2;
+
+    std::lock_guard<std::mutex> guard(shared[cls].lock);
+    last->next = shared[cls].head;
+    shared[cls].head = first;
+}
+
+// ============================== ВЫДЕЛЕНИЕ И ОСВОБОЖДЕНИЕ ==============================
+void* PoolAllocator::allocate(size_t size) {
+    if (size == 0) {
+        size = 1;
+    }
+    if (!arenaBase || size > MAX_POOLED_SIZE) {
+        systemAllocations.fetch_add(1, std::memory_order_relaxed);
+        return systemMalloc(size);
+    }
+
+    size_t cls = classIndex(size);
+    ThreadCache& c = cache;
+    if (!c.head[cls] && !refill(cls)) {
+        systemAllocations.fetch_add(1, std::memory_order_relaxed);
+        return systemMalloc(size);
+    }
+    FreeBlock* block = c.head[cls];
+    c.head[cls] = block->next;
+    --c.count[cls];
+    pooledAllocations.fetch_add(1, std::memory_order_relaxed);
+    return block;
+}
+
+void* PoolAllocator::allocateZeroed(size_t count, size_t size) {
+    if (size != 0 && count > SIZE_MAX / size) {
+        return nullptr;
+    }
+    size_t total = count * size;
+    if (!arenaBase || total > MAX_POOLED_SIZE) {
+        systemAllocations.fetch_add(1, std::memory_order_relaxed);
+        return systemCalloc(count, size);
+    }
+    void* ptr = allocate(total);
+    if (ptr) {
+        std::memset(ptr, 0, total ? total : 1);
+    }
+    return ptr;
+}
+
+void* PoolAllocator::reallocate(void* ptr, size_t size) {
+    if (!ptr) {
+        return allocate(size);
+    }
+    if (!inArena(ptr)) {
+        systemAllocations.fetch_add(1, std::memory_order_relaxed);
+        return systemRealloc(ptr, size);
+    }
+
+    size_t page = (static_cast<unsigned char*>(ptr) - arenaBase) / PAGE_SIZE;
+    size_t capacity = classSize(pageClass[page]);
+    if (size <= capacity) {
+        return ptr;
+    }
+    void* grown = allocate(size);
+    if (!grown) {
+        return nullptr;
+    }
+    std::memcpy(grown, ptr, capacity);
+    deallocate(ptr);
+    return grown;
+}
+
+void PoolAllocator::deallocate(void* ptr) {
+    if (!ptr) {
+        return;
+    }
+    if (!inArena(ptr)) {
+        systemFree(ptr);
+        return;
+    }
+
+    size_t cls = pageClass[(static_cast<unsigned char*>(ptr) - arenaBase) / PAGE_SIZE];
+    ThreadCache& c = cache;
+    FreeBlock* block = static_cast<FreeBlock*>(ptr);
+    block->next = c.head[cls];
+    c.head[cls] = block;
+    if (++c.count[cls] > CACHE_LIMIT) {
+        spill(cls);
+    }
+}
+
+PoolSnapshot PoolAllocator::snapshot() {
+    PoolSnapshot s;
+    s.pooledAllocations = pooledAllocations.load(std::memory_order_relaxed);
+    s.systemAllocations = systemAllocations.load(std::memory_order_relaxed);
+    size_t pages = pagesCarved.load(std::memory_order_relaxed);
+    s.pagesInUse = pages < PAGE_COUNT ? pages : PAGE_COUNT;
+    return s;
+}
+
+static bool reserveArena() {
+    if (!arenaBase) {
+        // Страницы области получают физическую память при первой нарезке
+        arenaBase = static_cast<unsigned char*>(systemMalloc(PoolAllocator::ARENA_SIZE));
+    }
+    return arenaBase != nullptr;
+}
+
+// ============================== ПОДКЛЮЧЕНИЕ К open62541 ==============================
+#if defined(UA_ENABLE_MALLOC_SINGLETON)
+
+static void* pooledMalloc(size_t size) { return PoolAllocator::allocate(size); }
+static void pooledFree(void* ptr) { PoolAllocator::deallocate(ptr); }
+static void* pooledCalloc(size_t count, size_t size) { return PoolAllocator::allocateZeroed(count, size); }
+static void* pooledRealloc(void* ptr, size_t size) { return PoolAllocator::reallocate(ptr, size); }
+
+bool PoolAllocator::routesLibraryAllocations() { return true; }
+
+#if defined(POOL_ALLOCATOR_INTERPOSE_FREE)
+// Освобождение из любого потока, в том числе не вызывавшего attachThread():
+// UA_freeSingleton такого потока указывает на free, и блок пула распознается
+// здесь по адресу. Остальные указатели уходят в glibc без изменений
+extern "C" void free(void* ptr) {
+    if (inArena(ptr)) {
+        PoolAllocator::deallocate(ptr);
+    } else {
+        __libc_free(ptr);
+    }
+}
+
+extern "C" void* realloc(void* ptr, size_t size) {
+    if (inArena(ptr)) {
+        return PoolAllocator::reallocate(ptr, size);
+    }
+    return __libc_realloc(ptr, size);
+}
+#elif UA_MULTITHREADING >= 100
+#error "Пул с UA_ENABLE_MALLOC_SINGLETON и UA_MULTITHREADING >= 100 требует glibc: free других потоков не перехватить"
+#endif
+
+bool PoolAllocator::install() {
+#if !defined(POOL_ALLOCATOR_INTERPOSE_FREE)
+    // Без подмены free системными остаются прежние указатели open62541
+    if (!arenaBase) {
+        systemMalloc = UA_mallocSingleton;
+        systemFree = UA_freeSingleton;
+        systemCalloc = UA_callocSingleton;
+        systemRealloc = UA_reallocSingleton;
+    }
+#endif
+    if (!reserveArena()) {
+        return false;
+    }
+    attachThread();
+    return true;
+}
+
+void PoolAllocator::attachThread() {
+    if (!arenaBase) return;
+    UA_mallocSingleton = pooledMalloc;
+    UA_freeSingleton = pooledFree;
+    UA_callocSingleton = pooledCalloc;
+    UA_reallocSingleton = pooledRealloc;
+}
+
+#elif defined(POOL_ALLOCATOR_WRAP_MALLOC)
+
+extern "C" {
+void* __wrap_malloc(size_t size) { return PoolAllocator::allocate(size); }
+void __wrap_free(void* ptr) { PoolAllocator::deallocate(ptr); }
+void* __wrap_calloc(size_t count, size_t size) { return PoolAllocator::allocateZeroed(count, size); }
+void* __wrap_realloc(void* ptr, size_t size) { return PoolAllocator::reallocate(ptr, size); }
+}
+
+bool PoolAllocator::routesLibraryAllocations() { return true; }
+bool PoolAllocator::install() { return reserveArena(); }
+void PoolAllocator::attachThread() {}
+
+#else
+
+bool PoolAllocator::routesLibraryAllocations() { return false; }
+bool PoolAllocator::install() { return reserveArena(); }
+void PoolAllocator::attachThread() {}
+
+#endif
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+// ============================== ПУЛ НЕБОЛЬШИХ БЛОКОВ ==============================
+// Реализация в pool_allocator.cpp. Блоки до MAX_POOLED_SIZE байт выдаются из
+// классов размеров 16..2048 байт; освобожденный блок попадает в список
+// свободных блоков своего потока и переиспользуется без обращения к системе.
+// Память для классов нарезается страницами из одной заранее выделенной области,
+// поэтому принадлежность блока пулу и его класс определяются по адресу - без
+// заголовка перед блоком. Блоки крупнее и блоки, не поместившиеся в область,
+// выделяются системным malloc.
+//
+// Подключение к open62541 - тем же способом, что и счетчики AllocStats:
+//  - UA_ENABLE_MALLOC_SINGLETON: через UA_mallocSingleton и т.п.;
+//  - POOL_ALLOCATOR_WRAP_MALLOC (Linux): через -Wl,--wrap=malloc,... при
+//    статической линковке open62541.
+//
+// При UA_MULTITHREADING >= 100 указатели UA_mallocSingleton свои у каждого
+// потока, поэтому поток, чьи выделения должны идти из пула, вызывает
+// attachThread(). Освобождение от attachThread() не зависит: free и realloc
+// процесса подменены и определяют блок пула по адресу области (только glibc;
+// на других платформах такая сборка не компилируется).
+//
+// Списки свободных блоков потока не возвращаются при его завершении (не больше
+// CACHE_LIMIT блоков на класс), поэтому пул рассчитан на долгоживущие потоки.
+struct PoolSnapshot {
+    uint64_t pooledAllocations = 0; // выдано из пула
+    uint64_t systemAllocations = 0; // ушло в системный malloc
+    uint64_t pagesInUse = 0;        // нарезано страниц области
+
+    PoolSnapshot operator-(const PoolSnapshot& other) const {
+        PoolSnapshot d;
+        d.pooledAllocations = pooledAllocations - other.pooledAllocations;
+        d.systemAllocations = systemAllocations - other.systemAllocations;
+        d.pagesInUse = pagesInUse - other.pagesInUse;
+        return d;
+    }
+};
+
+class PoolAllocator {
+public:
+    static constexpr size_t MAX_POOLED_SIZE = 2048;
+    static constexpr size_t PAGE_SIZE = 64 * 1024;
+    static constexpr size_t CACHE_LIMIT = 1024;   // блоков класса в списке потока
+    static constexpr size_t ARENA_SIZE = 64 * 1024 * 1024;
+
+    static std::atomic<uint64_t> pooledAllocations;
+    static std::atomic<uint64_t> systemAllocations;
+
+    // Резервирует область и подключает пул к open62541. Вызывать до создания
+    // сервера и запуска потоков; выделения до вызова идут в систему.
+    // false, если область не выделена (пул не используется)
+    static bool install();
+
+    // Направляет в пул выделения open62541 из текущего потока (кроме вызвавшего install())
+    static void attachThread();
+
+    // Проходят ли выделения open62541 через пул
+    static bool routesLibraryAllocations();
+
+    static void* allocate(size_t size);
+    static void* allocateZeroed(size_t count, size_t size);
+    static void* reallocate(void* ptr, size_t size);
+    static void deallocate(void* ptr);
+
+    static PoolSnapshot snapshot();
+};
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <open62541/server.h>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdint>
+
+#include "opcua_nodes.h"
+#include "trace.h"
+
+// ============================== ВЫБОРКА ПО ТАКТАМ ==============================
+// MonitoredItem с SamplingInterval = 0 open62541 выбирает не по таймеру, а при
+// каждой записи значения узла. PushSampler в конце такта вызывает
+// UA_Server_writeValue только для переменных оборудования, которые изменились
+// за такт и на которые есть подписка; до слота эта запись не доходит (см.
+// OPCUAVariableBase::SamplingWrite), а выборку делает сама библиотека. Новое
+// значение попадает в очередь MonitoredItem в момент фиксации такта и уходит
+// клиенту с ближайшей публикацией подписки; неизменившиеся переменные не
+// выбираются вовсе.
+//
+// MonitoredItems с ненулевым SamplingInterval по-прежнему выбираются таймером.
+// Подписчики считаются через monitoredItemRegisterCallback конфигурации
+// (ValueStore::addWatcher/removeWatcher), поэтому PushSampler создается до
+// UA_Server_run_startup. Обратный вызов не сообщает SamplingInterval, поэтому
+// в список обхода попадает слот с любым MonitoredItem на значении; слоты без
+// подписчиков такт не затрагивают.
+class PushSampler {
+private:
+    UA_Server* server;
+    ValueStore* store;
+    uint64_t commits = 0;
+    uint64_t pushes = 0;
+    uint64_t failures = 0;
+    uint64_t pushNs = 0;
+
+    static void itemRegistered(UA_Server* server, const UA_NodeId*, void*, const UA_NodeId* nodeId,
+                               void*, UA_UInt32 attributeId, UA_Boolean removed) {
+        if (attributeId != UA_ATTRIBUTEID_VALUE) {
+            return;
+        }
+        ValueStore& store = EquipmentNodestore::storeFor(server);
+        ValueStore::Slot slot;
+        if (!store.findSlot(*nodeId, slot)) {
+            return; // не переменная оборудования
+        }
+        if (removed) {
+            store.removeWatcher(slot);
+        } else {
+            store.addWatcher(slot);
+        }
+    }
+
+    // Значение передается только для проверки типа; выборка читает слот сама
+    bool push(ValueStore::Slot slot) {
+        UA_DataValue value;
+        UA_DataValue_init(&value);
+        UA_StatusCode status = store->read(slot, false, nullptr, &value);
+        if (status == UA_STATUSCODE_GOOD && value.hasValue) {
+            OPCUAVariableBase::SamplingWrite sampling;
+            status = UA_Server_writeValue(server, store->getNodeId(slot), value.value);
+        }
+        UA_DataValue_clear(&value);
+        return status == UA_STATUSCODE_GOOD;
+    }
+
+public:
+    explicit PushSampler(UA_Server* srv)
+        : server(srv), store(&EquipmentNodestore::storeFor(srv)) {
+        UA_Server_getConfig(server)->monitoredItemRegisterCallback = &PushSampler::itemRegistered;
+    }
+
+    // До UA_Server_run_shutdown: при закрытии сессий счетчики уже не нужны
+    ~PushSampler() {
+        UA_Server_getConfig(server)->monitoredItemRegisterCallback = NULL;
+    }
+
+    PushSampler(const PushSampler&) = delete;
+    PushSampler& operator=(const PushSampler&) = delete;
+
+    // Вызывать из потока симуляции после обновления всех устройств;
+    // возвращает число выбранных переменных
+    size_t commit() {
+        TRACE_SPAN("push");
+        auto started = std::chrono::steady_clock::now();
+        size_t changed = store->forEachChanged([this](ValueStore::Slot slot) {
+            if (!push(slot)) ++failures;
+        });
+        ++commits;
+        pushes += changed;
+        pushNs += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - started).count());
+        return changed;
+    }
+
+    void print(std::ostream& out) const {
+        out << "Выборка по тактам: " << pushes << " значений за " << commits << " тактов";
+        if (commits > 0) {
+            out << std::fixed << std::setprecision(1) << ", " << pushNs / 1000.0 / commits << " мкс/такт";
+        }
+        if (pushes > 0) {
+            out << std::setprecision(2) << ", " << pushNs / 1000.0 / pushes << " мкс/значение";
+        }
+        if (failures > 0) {
+            out << ", ошибок: " << failures;
+        }
+        out << std::endl;
+    }
+};
@@ -0,0 +1,258 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+#ifdef __linux__
+#include <cerrno>
+#include <alloca.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+#include <fstream>
+#endif
+
+// ============================== ПАРАМЕТРЫ РЕЖИМА РЕАЛЬНОГО ВРЕМЕНИ ==============================
+// Каждая настройка применяется по возможности: если прав не хватает (SCHED_FIFO
+// без CAP_SYS_NICE, mlockall сверх ulimit -l) или платформа не Linux, выводится
+// предупреждение и цикл работает с обычным планированием.
+//
+// mlockall закрепляет все адресное пространство процесса, включая еще не
+// тронутые страницы (область пула SERVER_POOLED_ALLOCATOR - 64 МБ, стеки
+// потоков). Без CAP_IPC_LOCK лимит ulimit -l должен быть не меньше этого
+// объема, иначе mlockall отказывает; нужный объем выводится при отказе. Где
+// есть MCL_ONFAULT, страницы закрепляются при первом обращении, поэтому
+// физическая память тратится только на используемые страницы.
+struct RealtimeOptions {
+    bool enabled = false;
+    int priority = 0;                          // SCHED_FIFO 1..99, 0 - обычное планирование
+    int cpu = -1;                              // привязка потока к ядру, -1 - без привязки
+    bool lockMemory = true;                    // mlockall и предварительное касание памяти
+    size_t prefaultHeapBytes = 8 * 1024 * 1024;
+    size_t prefaultStackBytes = 256 * 1024;
+};
+
+// ============================== ГИСТОГРАММА ДЖИТТЕРА ==============================
+// Корзины по степеням двойки микросекунд: [0, 1), [1, 2), [2, 4), ...; последняя
+// собирает все значения от ~1 с. Отрицательные значения (такт начался раньше
+// срока) попадают в первую корзину, но учитываются в минимуме.
+class JitterHistogram {
+private:
+    static constexpr int BUCKETS = 22;
+
+    uint64_t counts[BUCKETS] = {};
+    uint64_t samples = 0;
+    int64_t minNs = 0;
+    int64_t maxNs = 0;
+    double sumNs = 0.0;
+
+    static int bucketOf(int64_t ns) {
+        int64_t us = ns / 1000;
+        int bucket = 0;
+        while (us > 0 && bucket < BUCKETS - 1) {
+            us >>= 1;
+            ++bucket;
+        }
+        return bucket;
+    }
+
+    // Верхняя граница корзины в мкс
+    static int64_t bucketLimitUs(int bucket) {
+        return int64_t(1) << bucket;
+    }
+
+    int64_t percentileUs(double p) const {
+        uint64_t rank = static_cast<uint64_t>(p / 100.0 * samples + 0.5);
+        uint64_t seen = 0;
+        for (int b = 0; b < BUCKETS; ++b) {
+            seen += counts[b];
+            if (seen >= rank && counts[b] > 0) {
+                return bucketLimitUs(b);
+            }
+        }
+        return bucketLimitUs(BUCKETS - 1);
+    }
+
+public:
+    void record(int64_t ns) {
+        if (samples == 0 || ns < minNs) minNs = ns;
+        if (samples == 0 || ns > maxNs) maxNs = ns;
+        sumNs += static_cast<double>(ns);
+        ++samples;
+        ++counts[bucketOf(ns)];
+    }
+
+    uint64_t count() const { return samples; }
+
+    void print(std::ostream& out, const char* title) const {
+        out << title << ": " << samples << " тактов";
+        if (samples == 0) {
+            out << std::endl;
+            return;
+        }
+        out << std::fixed << std::setprecision(1)
+            << ", min " << minNs / 1000.0 << " мкс, mean " << sumNs / samples / 1000.0
+            << " мкс, max " << maxNs / 1000.0 << " мкс; p50 < " << percentileUs(50.0)
+            << " мкс, p99 < " << percentileUs(99.0) << " мкс, p99.9 < " << percentileUs(99.9) << " мкс"
+            << std::endl;
+
+        uint64_t peak = *std::max_element(counts, counts + BUCKETS);
+        for (int b = 0; b < BUCKETS; ++b) {
+            if (counts[b] == 0) continue;
+            int64_t low = b == 0 ? 0 : bucketLimitUs(b - 1);
+            out << "  " << std::setw(8) << low << " .. " << std::setw(8);
+            if (b == BUCKETS - 1) {
+                out << "inf";
+            } else {
+                out << bucketLimitUs(b);
+            }
+            out << " мкс " << std::setw(10) << counts[b] << " "
+                << std::string(static_cast<size_t>(40.0 * counts[b] / peak + 0.5), '#') << std::endl;
+        }
+    }
+};
+
+// ============================== ТАЙМЕР С АБСОЛЮТНЫМИ СРОКАМИ ==============================
+// Сроки тактов отсчитываются от создания таймера: t0 + k * period, поэтому длительность
+// такта не сдвигает следующие. Если такт не уложился в период, пропущенные сроки
+// пропускаются (считаются в overruns), и фаза сохраняется.
+class DeadlineTimer {
+private:
+    using Clock = std::chrono::steady_clock;
+
+    Clock::duration period;
+    Clock::time_point next;
+    uint64_t missed = 0;
+
+public:
+    // Первый срок - момент создания: таймер создается непосредственно перед циклом
+    explicit DeadlineTimer(Clock::duration tickPeriod)
+        : period(tickPeriod), next(Clock::now()) {}
+
+    Clock::time_point deadline() const { return next; }
+    uint64_t overruns() const { return missed; }
+
+    void advance() {
+        next += period;
+        auto now = Clock::now();
+        while (next + period <= now) {
+            next += period;
+            ++missed;
+        }
+    }
+
+    // В Linux steady_clock - это CLOCK_MONOTONIC, поэтому срок передается
+    // clock_nanosleep как есть
+    void sleepUntilDeadline() const {
+#ifdef __linux__
+        auto sinceEpoch = std::chrono::duration_cast<std::chrono::nanoseconds>(next.time_since_epoch()).count();
+        timespec ts;
+        ts.tv_sec = static_cast<time_t>(sinceEpoch / 1000000000);
+        ts.tv_nsec = static_cast<long>(sinceEpoch % 1000000000);
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+        }
+#else
+        std::this_thread::sleep_until(next);
+#endif
+    }
+};
+
+// ============================== НАСТРОЙКА ПОТОКА ==============================
+// Применяет параметры к вызывающему потоку (mlockall - ко всему процессу).
+// Возвращает true, если применено все запрошенное.
+inline bool applyRealtime(const RealtimeOptions& options, const char* threadName) {
+#ifdef __linux__
+    bool complete = true;
+
+    if (options.cpu >= 0) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(options.cpu, &cpus);
+        int error = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+        if (error != 0) {
+            std::cerr << "[RT] " << threadName << ": не удалось привязать к ядру " << options.cpu
+                      << ": " << std::strerror(error) << std::endl;
+            complete = false;
+        }
+    }
+
+    if (options.priority > 0) {
+        sched_param param;
+        std::memset(&param, 0, sizeof(param));
+        param.sched_priority = std::min(options.priority, sched_get_priority_max(SCHED_FIFO));
+        int error = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (error != 0) {
+            std::cerr << "[RT] " << threadName << ": SCHED_FIFO недоступен (" << std::strerror(error)
+                      << "; нужны CAP_SYS_NICE или ulimit -r), обычное планирование" << std::endl;
+            complete = false;
+        }
+    }
+
+    bool locked = false;
+    if (options.lockMemory) {
+        int flags = MCL_CURRENT | MCL_FUTURE;
+#ifdef MCL_ONFAULT
+        flags |= MCL_ONFAULT;
+#endif
+        if (mlockall(flags) != 0) {
+            int error = errno;
+            // Адресное пространство процесса сейчас - столько требует mlockall
+            long pages = 0;
+            std::ifstream statm("/proc/self/statm");
+            statm >> pages;
+            rlimit limit;
+            std::memset(&limit, 0, sizeof(limit));
+            getrlimit(RLIMIT_MEMLOCK, &limit);
+            std::cerr << "[RT] mlockall: " << std::strerror(error) << "; нужно ulimit -l не меньше "
+                      << pages * sysconf(_SC_PAGESIZE) / (1024 * 1024) << " МБ (сейчас ";
+            if (limit.rlim_cur == RLIM_INFINITY) {
+                std::cerr << "unlimited";
+            } else {
+                std::cerr << limit.rlim_cur / 1024 << " КБ";
+            }
+            std::cerr << ") или CAP_IPC_LOCK, память не закреплена" << std::endl;
+            complete = false;
+        } else {
+            locked = true;
+#ifdef __GLIBC__
+            // Освобожденная память остается в куче процесса и не отдается системе
+            mallopt(M_TRIM_THRESHOLD, -1);
+            mallopt(M_MMAP_MAX, 0);
+#endif
+            // Касание страниц заранее: в цикле не будет первых обращений к ним
+            if (void* heap = std::malloc(options.prefaultHeapBytes)) {
+                std::memset(heap, 0, options.prefaultHeapBytes);
+                std::free(heap);
+            }
+            if (options.prefaultStackBytes > 0) {
+                volatile unsigned char* stack =
+                    static_cast<volatile unsigned char*>(alloca(options.prefaultStackBytes));
+                for (size_t i = 0; i < options.prefaultStackBytes; i += 4096) {
+                    stack[i] = 0;
+                }
+            }
+        }
+    }
+
+    // Итог выводится всегда, чтобы отказ был виден в выводе запуска
+    std::cout << "[RT] " << threadName << ": приоритет " << options.priority << ", ядро " << options.cpu
+              << (locked ? ", память закреплена" : options.lockMemory ? ", память НЕ закреплена" : "")
+              << (complete ? "" : " (применено не все, см. выше)") << std::endl;
+    return complete;
+#else
+    (void)options;
+    std::cerr << "[RT] " << threadName << ": режим реального времени поддерживается только в Linux, "
+                 "используется обычное планирование" << std::endl;
+    return false;
+#endif
+}
@@ -0,0 +1,548 @@
+#include <open62541/server.h>
+#include <open62541/server_config_default.h>
+#include <open62541/plugin/log_stdout.h>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "alloc_stats.h"
+#include "devices.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// ============================== ИНФРАСТРУКТУРА БЕНЧМАРКОВ ==============================
+// Каждый бенчмарк получает число итераций и сам отмечает измеряемый участок
+// через resume()/pause(); подготовка и очистка в замер не попадают.
+class BenchTimer {
+private:
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point started;
+    AllocSnapshot allocsAtStart;
+    bool running = false;
+
+public:
+    uint64_t elapsedNs = 0;
+    AllocSnapshot allocs;
+
+    void resume() {
+        if (running) return;
+        running = true;
+        allocsAtStart = AllocStats::snapshot();
+        started = Clock::now();
+    }
+
+    void pause() {
+        if (!running) return;
+        auto now = Clock::now();
+        AllocSnapshot delta = AllocStats::snapshot() - allocsAtStart;
+        running = false;
+        elapsedNs += static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(now - started).count());
+        allocs.allocations += delta.allocations;
+        allocs.deallocations += delta.deallocations;
+        allocs.bytes += delta.bytes;
+    }
+};
+
+struct BenchResult {
+    std::string name;
+    uint64_t iterations;
+    double nsPerOp;
+    double allocsPerOp;
+    double bytesPerOp;
+};
+
+using BenchFn = std::function<void(BenchTimer&, uint64_t)>;
+
+struct BenchOptions {
+    double minTimeMs = 300.0;
+    std::string filter;
+    std::string csvPath;
+    UA_UInt16 port = 4841;
+};
+
+static BenchResult runBench(const std::string& name, const BenchFn& fn, const BenchOptions& options) {
+    uint64_t iterations = 1;
+    for (;;) {
+        BenchTimer timer;
+        fn(timer, iterations);
+        timer.pause();
+
+        double elapsedMs = timer.elapsedNs / 1e6;
+        if (elapsedMs >= options.minTimeMs || iterations >= (1ull << 30)) {
+            BenchResult r;
+            r.name = name;
+            r.iterations = iterations;
+            r.nsPerOp = static_cast<double>(timer.elapsedNs) / iterations;
+            r.allocsPerOp = static_cast<double>(timer.allocs.allocations) / iterations;
+            r.bytesPerOp = static_cast<double>(timer.allocs.bytes) / iterations;
+            return r;
+        }
+
+        // Оцениваем, сколько итераций нужно для минимального времени замера
+        double scale = elapsedMs > 0.01 ? options.minTimeMs / elapsedMs * 1.2 : 100.0;
+        uint64_t next = static_cast<uint64_t>(iterations * std::min(scale, 100.0));
+        iterations = std::max(next, iterations + 1);
+    }
+}
+
+// ============================== ОКРУЖЕНИЕ: СЕРВЕР С УСТРОЙСТВАМИ ==============================
+class BenchServer {
+public:
+    UA_Server* server;
+    UA_UInt16 namespaceIndex;
+    std::unique_ptr<Multimeter> multimeter;
+    std::unique_ptr<Machine> machine;
+    std::unique_ptr<Computer> computer;
+    std::unique_ptr<OPCUAVariable<>> probe; // отдельная переменная для замеров записи
+
+    explicit BenchServer(UA_UInt16 port) : server(nullptr), namespaceIndex(0) {
+        UA_ServerConfig config;
+        memset(&config, 0, sizeof(UA_ServerConfig));
+        config.logging = UA_Log_Stdout_new(UA_LOGLEVEL_WARNING);
+        UA_ServerConfig_setMinimal(&config, port, NULL);
+        server = UA_Server_newWithConfig(&config);
+        if (!server) {
+            throw std::runtime_error("Failed to create server");
+        }
+
+        namespaceIndex = UA_Server_addNamespace(server, "EquipmentNamespace");
+
+        multimeter = std::make_unique<Multimeter>(server, namespaceIndex);
+        machine = std::make_unique<Machine>(server, namespaceIndex);
+        computer = std::make_unique<Computer>(server, namespaceIndex);
+        for (OPCUADevice* device : devices()) {
+            device->setVerbose(false);
+            device->initialize();
+        }
+        probe = std::make_unique<OPCUAVariable<>>(server, namespaceIndex, 900000, "BenchProbe",
+                                                  "Тестовая переменная", "Переменная для бенчмарка", 0.0);
+        probe->initialize();
+
+        UA_StatusCode status = UA_Server_run_startup(server);
+        if (status != UA_STATUSCODE_GOOD) {
+            UA_Server_delete(server);
+            throw std::runtime_error(std::string("Failed to start server: ") + UA_StatusCode_name(status));
+        }
+    }
+
+    ~BenchServer() {
+        probe.reset();
+        computer.reset();
+        machine.reset();
+        multimeter.reset();
+        UA_Server_run_shutdown(server);
+        UA_Server_delete(server);
+    }
+
+    BenchServer(const BenchServer&) = delete;
+    BenchServer& operator=(const BenchServer&) = delete;
+
+    std::vector<OPCUADevice*> devices() {
+        return {multimeter.get(), machine.get(), computer.get()};
+    }
+
+    void updateAll() {
+        applySetpointCommands(server);
+        for (OPCUADevice* device : devices()) {
+            device->updateValues();
+        }
+    }
+};
+
+// Локальные (без сети) подписки на все переменные устройств - имитация нагрузки
+static void dataChangeSink(UA_Server*, UA_UInt32, void*, const UA_NodeId*, void*,
+                           UA_UInt32, const UA_DataValue*) {}
+
+static const UA_UInt32 equipmentVariableIds[] = {101, 102, 103, 104, 201, 202, 203, 204, 205,
+                                                 301, 302, 303, 304, 305, 306};
+
+static std::vector<UA_UInt32> monitorAllVariables(BenchServer& env, double samplingIntervalMs) {
+    std::vector<UA_UInt32> monitoredItems;
+    for (UA_UInt32 id : equipmentVariableIds) {
+        UA_MonitoredItemCreateRequest request;
+        UA_MonitoredItemCreateRequest_init(&request);
+        request.itemToMonitor.nodeId = UA_NODEID_NUMERIC(env.namespaceIndex, id);
+        request.itemToMonitor.attributeId = UA_ATTRIBUTEID_VALUE;
+        request.monitoringMode = UA_MONITORINGMODE_REPORTING;
+        request.requestedParameters.samplingInterval = samplingIntervalMs;
+        request.requestedParameters.queueSize = 1;
+        request.requestedParameters.discardOldest = true;
+
+        UA_MonitoredItemCreateResult result = UA_Server_createDataChangeMonitoredItem(
+            env.server, UA_TIMESTAMPSTORETURN_SOURCE, request, NULL, dataChangeSink);
+        if (result.statusCode == UA_STATUSCODE_GOOD) {
+            monitoredItems.push_back(result.monitoredItemId);
+        }
+    }
+    return monitoredItems;
+}
+
+// ============================== БЕНЧМАРКИ ==============================
+static void registerBenchmarks(std::vector<std::pair<std::string, BenchFn>>& benches,
+                               BenchServer& env) {
+    // Создание узла переменной; узлы удаляются вне замера
+    benches.emplace_back("node_create/OPCUAVariable::initialize", [&env](BenchTimer& t, uint64_t n) {
+        static UA_UInt32 nextId = 1000000;
+        const uint64_t batch = 1000;
+        for (uint64_t done = 0; done < n; done += batch) {
+            uint64_t count = std::min(batch, n - done);
+            std::vector<std::unique_ptr<OPCUAVariable<>>> vars;
+            vars.reserve(count);
+            for (uint64_t i = 0; i < count; ++i) {
+                vars.push_back(std::make_unique<OPCUAVariable<>>(
+                    env.server, env.namespaceIndex, nextId++, "BenchVar", "Тестовая переменная",
+                    "Переменная для бенчмарка", 1.0));
+            }
+
+            t.resume();
+            for (auto& var : vars) {
+                var->initialize();
+            }
+            t.pause();
+
+            for (auto& var : vars) {
+                UA_Server_deleteNode(env.server, var->getNodeId(), true);
+            }
+        }
+    });
+
+    // Запись симулятором: OPCUAVariable::writeValue пишет прямо в слот ValueStore
+    benches.emplace_back("write/store", [&env](BenchTimer& t, uint64_t n) {
+        double value = 0.0;
+        t.resume();
+        for (uint64_t i = 0; i < n; ++i) {
+            env.probe->writeValue(value);
+            value += 1.0;
+        }
+        t.pause();
+    });
+
+    // Запись через UA_Server_writeValue с промежуточной копией (UA_Variant_setScalarCopy)
+    benches.emplace_back("write/server-copy", [&env](BenchTimer& t, uint64_t n) {
+        UA_NodeId nodeId = env.probe->getNodeId();
+        double value = 0.0;
+        t.resume();
+        for (uint64_t i = 0; i < n; ++i) {
+            UA_Variant var;
+            UA_Variant_init(&var);
+            UA_Variant_setScalarCopy(&var, &value, &UA_TYPES[UA_TYPES_DOUBLE]);
+            UA_Server_writeValue(env.server, nodeId, var);
+            UA_Variant_clear(&var);
+            value += 1.0;
+        }
+        t.pause();
+    });
+
+    // Та же запись без промежуточной копии: сервер копирует значение сам
+    benches.emplace_back("write/server-no-copy", [&env](BenchTimer& t, uint64_t n) {
+        UA_NodeId nodeId = env.probe->getNodeId();
+        double value = 0.0;
+        t.resume();
+        for (uint64_t i = 0; i < n; ++i) {
+            UA_Variant var;
+            UA_Variant_setScalar(&var, &value, &UA_TYPES[UA_TYPES_DOUBLE]);
+            UA_Server_writeValue(env.server, nodeId, var);
+            value += 1.0;
+        }
+        t.pause();
+    });
+
+    // Запись уставки через сервис Write: проверка и постановка в очередь команд.
+    // Очередь разбирается вне замера, как на границе такта.
+    benches.emplace_back("write/setpoint-enqueue", [&env](BenchTimer& t, uint64_t n) {
+        UA_NodeId nodeId = UA_NODEID_NUMERIC(env.namespaceIndex, 206);
+        const uint64_t batch = 1000;
+        double value = 1000.0;
+        for (uint64_t done = 0; done < n; done += batch) {
+            uint64_t count = std::min(batch, n - done);
+            t.resume();
+            for (uint64_t i = 0; i < count; ++i) {
+                UA_Variant var;
+                UA_Variant_setScalar(&var, &value, &UA_TYPES[UA_TYPES_DOUBLE]);
+                UA_Server_writeValue(env.server, nodeId, var);
+            }
+            t.pause();
+            applySetpointCommands(env.server);
+        }
+    });
+
+    // Разбор пакета из 1000 команд уставок симуляцией
+    benches.emplace_back("commands/apply-1000", [&env](BenchTimer& t, uint64_t n) {
+        UA_NodeId nodeId = UA_NODEID_NUMERIC(env.namespaceIndex, 206);
+        double value = 1500.0;
+        for (uint64_t i = 0; i < n; ++i) {
+            for (int k = 0; k < 1000; ++k) {
+                UA_Variant var;
+                UA_Variant_setScalar(&var, &value, &UA_TYPES[UA_TYPES_DOUBLE]);
+                UA_Server_writeValue(env.server, nodeId, var);
+            }
+            t.resume();
+            applySetpointCommands(env.server);
+            t.pause();
+        }
+    });
+
+    // Чтение атрибута Value по обычным NodeId и по ручкам из ValueStore
+    auto readBench = [&env](bool useHandles) {
+        return [&env, useHandles](BenchTimer& t, uint64_t n) {
+            ValueStore& store = EquipmentNodestore::storeFor(env.server);
+            std::vector<UA_NodeId> ids;
+            for (UA_UInt32 id : equipmentVariableIds) {
+                UA_NodeId nodeId = UA_NODEID_NUMERIC(env.namespaceIndex, id);
+                ValueStore::Slot slot;
+                if (useHandles && store.findSlot(nodeId, slot)) {
+                    nodeId = store.handleNodeId(slot);
+                }
+                ids.push_back(nodeId);
+            }
+
+            UA_ReadValueId rvi;
+            UA_ReadValueId_init(&rvi);
+            rvi.attributeId = UA_ATTRIBUTEID_VALUE;
+            t.resume();
+            for (uint64_t i = 0; i < n; ++i) {
+                rvi.nodeId = ids[i % ids.size()];
+                UA_DataValue dv = UA_Server_read(env.server, &rvi, UA_TIMESTAMPSTORETURN_NEITHER);
+                UA_DataValue_clear(&dv);
+            }
+            t.pause();
+        };
+    };
+    benches.emplace_back("read/node-id", readBench(false));
+    benches.emplace_back("read/handle", readBench(true));
+
+    // Только поиск узла в nodestore, без остального сервиса Read: по NodeId -
+    // хеш-таблица стандартного nodestore, по ручке - копия узла по номеру слота
+    auto lookupBench = [&env](bool useHandles) {
+        return [&env, useHandles](BenchTimer& t, uint64_t n) {
+            ValueStore& store = EquipmentNodestore::storeFor(env.server);
+            UA_Nodestore& nodestore = UA_Server_getConfig(env.server)->nodestore;
+            std::vector<UA_NodeId> ids;
+            for (UA_UInt32 id : equipmentVariableIds) {
+                UA_NodeId nodeId = UA_NODEID_NUMERIC(env.namespaceIndex, id);
+                ValueStore::Slot slot;
+                if (useHandles && store.findSlot(nodeId, slot)) {
+                    nodeId = store.handleNodeId(slot);
+                }
+                ids.push_back(nodeId);
+            }
+
+            t.resume();
+            for (uint64_t i = 0; i < n; ++i) {
+                const UA_Node* node = nodestore.getNode(nodestore.context, &ids[i % ids.size()],
+                                                        UA_NODEATTRIBUTESMASK_VALUE, UA_REFERENCETYPESET_NONE,
+                                                        UA_BROWSEDIRECTION_INVALID);
+                if (node) nodestore.releaseNode(nodestore.context, node);
+            }
+            t.pause();
+        };
+    };
+    benches.emplace_back("nodestore/node-id", lookupBench(false));
+    benches.emplace_back("nodestore/handle", lookupBench(true));
+
+    benches.emplace_back("update/Multimeter", [&env](BenchTimer& t, uint64_t n) {
+        t.resume();
+        for (uint64_t i = 0; i < n; ++i) env.multimeter->updateValues();
+        t.pause();
+    });
+
+    benches.emplace_back("update/Machine", [&env](BenchTimer& t, uint64_t n) {
+        t.resume();
+        for (uint64_t i = 0; i < n; ++i) env.machine->updateValues();
+        t.pause();
+    });
+
+    benches.emplace_back("update/Computer", [&env](BenchTimer& t, uint64_t n) {
+        t.resume();
+        for (uint64_t i = 0; i < n; ++i) env.computer->updateValues();
+        t.pause();
+    });
+
+    // Запись 1000 отсчетов в осциллограмму и публикация кадра через тройной буфер
+    benches.emplace_back("waveform/append-1000", [&env](BenchTimer& t, uint64_t n) {
+        OPCUAWaveformVariable<float> waveform(env.server, env.namespaceIndex, 900001, "BenchWave",
+                                              "Тестовая осциллограмма", "", UA_NODEID_NULL, 1000, 1000.0);
+        std::vector<float> samples(1000, 1.0f);
+        UA_DateTime now = UA_DateTime_now();
+        t.resume();
+        for (uint64_t i = 0; i < n; ++i) {
+            waveform.append(samples.data(), samples.size(), now);
+            waveform.acquire();
+        }
+        t.pause();
+    });
+
+    // Стоимость одного пустого интервала; без SERVER_ENABLE_TRACING - пустой цикл
+    benches.emplace_back("trace/span", [](BenchTimer& t, uint64_t n) {
+        t.resume();
+        for (uint64_t i = 0; i < n; ++i) {
+            TRACE_SPAN("bench");
+        }
+        t.pause();
+    });
+
+    benches.emplace_back("iterate/idle",[&env](BenchTimer& t, uint64_t n) {
+        t.resume();
+        for (uint64_t i = 0; i < n; ++i) UA_Server_run_iterate(env.server, false);
+        t.pause();
+    });
+
+    // Подписки на все переменные с минимальным интервалом выборки; обновление
+    // устройств между итерациями в замер не входит
+    benches.emplace_back("iterate/loaded", [&env](BenchTimer& t, uint64_t n) {
+        std::vector<UA_UInt32> items = monitorAllVariables(env, 0.0);
+        for (uint64_t i = 0; i < n; ++i) {
+            env.updateAll();
+            t.resume();
+            UA_Server_run_iterate(env.server, false);
+            t.pause();
+        }
+        for (UA_UInt32 id : items) {
+            UA_Server_deleteMonitoredItem(env.server, id);
+        }
+    });
+}
+
+// ============================== ПРОВЕРКА ПРИВЕДЕНИЯ ТИПОВ ==============================
+// Вычисляемые теги (вентиляторы uint16 и т.п.) приводятся к типу переменной через
+// UATypeTraits::fromDouble. Значения вне диапазона должны ограничиваться, NaN -
+// давать 0. Проверка идет до замеров; при ошибке бенчмарк завершается с кодом 1.
+template<typename T>
+static void expectConversion(double input, T expected, int& failures) {
+    T actual = UATypeTraits<T>::fromDouble(input);
+    if (actual != expected) {
+        std::cerr << "fromDouble<" << UATypeTraits<T>::type()->typeName << ">(" << input << ") = "
+                  << +actual << ", ожидалось " << +expected << std::endl;
+        ++failures;
+    }
+}
+
+static bool checkConversions() {
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    int failures = 0;
+
+    expectConversion<uint8_t>(300.0, 255, failures);
+    expectConversion<uint8_t>(-1.0, 0, failures);
+    expectConversion<uint8_t>(nan, 0, failures);
+    expectConversion<uint8_t>(254.6, 255, failures);
+
+    expectConversion<int16_t>(40000.0, 32767, failures);
+    expectConversion<int16_t>(-40000.0, -32768, failures);
+    expectConversion<int16_t>(nan, 0, failures);
+    expectConversion<int16_t>(-12.4, -12, failures);
+
+    expectConversion<uint16_t>(70000.0, 65535, failures);
+    expectConversion<uint16_t>(-5.0, 0, failures);
+    expectConversion<uint16_t>(nan, 0, failures);
+    expectConversion<uint16_t>(1300.5, 1301, failures);
+
+    expectConversion<int64_t>(1e30, std::numeric_limits<int64_t>::max(), failures);
+    expectConversion<uint64_t>(-1e30, 0, failures);
+    expectConversion<bool>(nan, false, failures);
+
+    if (failures > 0) {
+        std::cerr << "Приведение типов: ошибок " << failures << std::endl;
+    }
+    return failures == 0;
+}
+
+// ============================== ТОЧКА ВХОДА ==============================
+static void printUsage() {
+    std::cout << "Usage: server_bench [--filter <substring>] [--min-time <ms>] [--csv <file>] [--port <n>]"
+              << std::endl;
+}
+
+int main(int argc, char** argv) {
+#ifdef _WIN32
+    SetConsoleOutputCP(CP_UTF8);
+#endif
+
+    BenchOptions options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--filter" && hasValue) options.filter = argv[++i];
+        else if (arg == "--min-time" && hasValue) options.minTimeMs = std::atof(argv[++i]);
+        else if (arg == "--csv" && hasValue) options.csvPath = argv[++i];
+        else if (arg == "--port" && hasValue) options.port = static_cast<UA_UInt16>(std::atoi(argv[++i]));
+        else {
+            printUsage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    if (!checkConversions()) {
+        return 1;
+    }
+
+    AllocStats::install();
+    if (!AllocStats::tracksLibraryAllocations()) {
+        std::cout << "Внимание: выделения внутри open62541 не учитываются (только operator new)" << std::endl;
+    }
+
+    std::vector<BenchResult> results;
+    try {
+        BenchServer env(options.port);
+
+        std::vector<std::pair<std::string, BenchFn>> benches;
+        registerBenchmarks(benches, env);
+
+        std::cout << std::left << std::setw(42) << "benchmark" << std::right
+                  << std::setw(12) << "iterations" << std::setw(14) << "ns/op"
+                  << std::setw(14) << "allocs/op" << std::setw(14) << "bytes/op" << std::endl;
+
+        for (auto& bench : benches) {
+            if (!options.filter.empty() && bench.first.find(options.filter) == std::string::npos) {
+                continue;
+            }
+            BenchResult r = runBench(bench.first, bench.second, options);
+            results.push_back(r);
+            std::cout << std::left << std::setw(42) << r.name << std::right
+                      << std::setw(12) << r.iterations
+                      << std::setw(14) << std::fixed << std::setprecision(1) << r.nsPerOp
+                      << std::setw(14) << std::setprecision(2) << r.allocsPerOp
+                      << std::setw(14) << std::setprecision(1) << r.bytesPerOp << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Исключение: " << e.what() << std::endl;
+        return 1;
+    }
+
+    // Ручки против обычных NodeId; отношение печатается как есть, в том числе
+    // если ручки не быстрее
+    for (const char* group : {"read", "nodestore"}) {
+        const BenchResult* byNodeId = nullptr;
+        const BenchResult* byHandle = nullptr;
+        for (const BenchResult& r : results) {
+            if (r.name == std::string(group) + "/node-id") byNodeId = &r;
+            if (r.name == std::string(group) + "/handle") byHandle = &r;
+        }
+        if (byNodeId && byHandle && byHandle->nsPerOp > 0.0) {
+            std::cout << group << ": ручка " << std::fixed << std::setprecision(1) << byHandle->nsPerOp
+                      << " нс, NodeId " << byNodeId->nsPerOp << " нс, отношение "
+                      << std::setprecision(2) << byNodeId->nsPerOp / byHandle->nsPerOp << "x" << std::endl;
+        }
+    }
+
+    if (!options.csvPath.empty()) {
+        std::ofstream csv(options.csvPath);
+        csv << "benchmark,iterations,ns_per_op,allocs_per_op,bytes_per_op\n";
+        for (const BenchResult& r : results) {
+            csv << r.name << ',' << r.iterations << ',' << r.nsPerOp << ','
+                << r.allocsPerOp << ',' << r.bytesPerOp << '\n';
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,546 @@
+#include <open62541/client.h>
+#include <open62541/client_config_default.h>
+#include <open62541/client_highlevel.h>
+#include <open62541/client_subscriptions.h>
+#include <open62541/plugin/log_stdout.h>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+
+#include "alloc_stats.h"
+#include "opcua_server.h"
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// ============================== ПАРАМЕТРЫ ПРОГОНА ==============================
+// Рабочий OPCUAServer (тот же цикл run(), парк устройств, выборка по тактам) и
+// клиенты работают в одном процессе на loopback, поэтому прогон не требует
+// внешних сервисов. Такт ускорен (по умолчанию 10 мс вместо 330 мс), клиенты
+// непрерывно подключаются, читают, пишут уставку, подписываются и отключаются;
+// половина клиентов подписывается с SamplingInterval = 0 (выборка по тактам).
+// Оператор по кругу добавляет и удаляет устройства методами AddDevices и
+// RemoveDevices. Раз в интервал снимаются RSS, число живых выделений и задержка
+// такта; после прогрева первая выборка становится базовой, и прогон завершается
+// с ошибкой, как только рост выходит за заданные пределы.
+struct SoakOptions {
+    double durationSec = 3600.0;
+    double warmupSec = 30.0;
+    double sampleIntervalSec = 10.0;
+    double tickMs = 10.0;
+    int clients = 4;
+    int requestsPerSession = 50;
+    double fleetCycleSec = 1.0;      // добавление и удаление партии устройств, 0 - выключено
+    int fleetBatch = 4;
+    UA_UInt16 port = 4842;
+    double maxRssGrowthMb = 16.0;
+    double maxLiveAllocationGrowth = 5000.0;
+    double maxLatencyRatio = 3.0;    // p99 такта относительно базовой выборки
+    double latencySlackUs = 500.0;   // и абсолютный допуск, чтобы не ловить шум
+    std::string csvPath;
+};
+
+static const UA_UInt32 readVariableIds[] = {101, 102, 103, 104, 105, 106, 201, 202, 203, 204, 205, 206,
+                                            301, 302, 303, 304, 305, 306};
+static const UA_UInt32 monitoredVariableIds[] = {101, 201, 304};
+static const UA_UInt32 SETPOINT_ID = 206;
+
+// ============================== ЗАДЕРЖКА ТАКТА ==============================
+class TickStats {
+private:
+    std::mutex lock;
+    std::vector<uint64_t> durationsNs;
+    uint64_t ticks = 0;
+
+public:
+    void record(uint64_t ns) {
+        std::lock_guard<std::mutex> guard(lock);
+        durationsNs.push_back(ns);
+        ++ticks;
+    }
+
+    // Забирает накопленное за интервал; percentiles - p50, p99, max в мкс
+    uint64_t take(double percentiles[3]) {
+        std::vector<uint64_t> window;
+        uint64_t total;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            window.swap(durationsNs);
+            total = ticks;
+        }
+        std::sort(window.begin(), window.end());
+        const double ranks[3] = {50.0, 99.0, 100.0};
+        for (int i = 0; i < 3; ++i) {
+            if (window.empty()) {
+                percentiles[i] = 0.0;
+                continue;
+            }
+            size_t index = static_cast<size_t>(ranks[i] / 100.0 * (window.size() - 1) + 0.5);
+            percentiles[i] = window[index] / 1000.0;
+        }
+        return total;
+    }
+};
+
+// ============================== КЛИЕНТЫ ==============================
+struct ClientCounters {
+    std::atomic<uint64_t> sessions{0};
+    std::atomic<uint64_t> requests{0};
+    std::atomic<uint64_t> errors{0};
+    std::atomic<uint64_t> pushSessions{0};   // сессий с SamplingInterval = 0
+    std::atomic<uint64_t> pushedSessions{0}; // из них получили изменения после начального значения
+    std::atomic<uint64_t> fleetCycles{0};
+    std::atomic<uint64_t> fleetErrors{0};
+    std::atomic<uint64_t> nonFiniteAccepted{0}; // запись NaN в уставку не отклонена
+    std::atomic<uint64_t> badReadItems{0};      // элементы Read с плохим статусом
+};
+
+// Контекст MonitoredItem - счетчик его уведомлений
+static void dataChangeSink(UA_Client*, UA_UInt32, void*, UA_UInt32, void* monContext, UA_DataValue*) {
+    ++*static_cast<uint64_t*>(monContext);
+}
+
+static UA_Client* connectClient(const std::string& url) {
+    UA_ClientConfig config;
+    memset(&config, 0, sizeof(UA_ClientConfig));
+    config.logging = UA_Log_Stdout_new(UA_LOGLEVEL_ERROR);
+    UA_ClientConfig_setDefault(&config);
+    UA_Client* client = UA_Client_newWithConfig(&config);
+    if (client && UA_Client_connect(client, url.c_str()) != UA_STATUSCODE_GOOD) {
+        UA_Client_delete(client);
+        client = nullptr;
+    }
+    return client;
+}
+
+// Сессия за сессией: подключение, подписка, чтения и запись уставки, отключение.
+// pushSampling - MonitoredItems с SamplingInterval = 0 вместо интервала такта
+static void runClient(const SoakOptions& options, UA_UInt16 ns, unsigned seed, bool pushSampling,
+                      const std::atomic<bool>& stop, ClientCounters& counters) {
+    const std::string url = "opc.tcp://localhost:" + std::to_string(options.port);
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> setpoint(0.0, 3000.0);
+
+    std::vector<UA_ReadValueId> readIds;
+    for (UA_UInt32 id : readVariableIds) {
+        UA_ReadValueId item;
+        UA_ReadValueId_init(&item);
+        item.nodeId = UA_NODEID_NUMERIC(ns, id);
+        item.attributeId = UA_ATTRIBUTEID_VALUE;
+        readIds.push_back(item);
+    }
+
+    while (!stop) {
+        UA_Client* client = connectClient(url);
+        if (!client) {
+            counters.errors++;
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            continue;
+        }
+        counters.sessions++;
+        uint64_t notifications[sizeof(monitoredVariableIds) / sizeof(monitoredVariableIds[0])] = {};
+
+        UA_CreateSubscriptionRequest subscriptionRequest = UA_CreateSubscriptionRequest_default();
+        subscriptionRequest.requestedPublishingInterval = options.tickMs;
+        UA_CreateSubscriptionResponse subscription =
+            UA_Client_Subscriptions_create(client, subscriptionRequest, NULL, NULL, NULL);
+        if (subscription.responseHeader.serviceResult == UA_STATUSCODE_GOOD) {
+            for (size_t m = 0; m < sizeof(monitoredVariableIds) / sizeof(monitoredVariableIds[0]); ++m) {
+                UA_MonitoredItemCreateRequest item =
+                    UA_MonitoredItemCreateRequest_default(UA_NODEID_NUMERIC(ns, monitoredVariableIds[m]));
+                item.requestedParameters.samplingInterval = pushSampling ? 0.0 : options.tickMs;
+                UA_MonitoredItemCreateResult result = UA_Client_MonitoredItems_createDataChange(
+                    client, subscription.subscriptionId, UA_TIMESTAMPSTORETURN_SOURCE, item,
+                    &notifications[m], dataChangeSink, NULL);
+                UA_MonitoredItemCreateResult_clear(&result);
+            }
+        } else {
+            counters.errors++;
+        }
+
+        for (int i = 0; i < options.requestsPerSession && !stop; ++i) {
+            if (i % 20 == 19) {
+                // Уставка вне диапазона: NaN обязан отклоняться как BadOutOfRange
+                double value = std::numeric_limits<double>::quiet_NaN();
+                UA_Variant variant;
+                UA_Variant_setScalar(&variant, &value, &UA_TYPES[UA_TYPES_DOUBLE]);
+                if (UA_Client_writeValueAttribute(client, UA_NODEID_NUMERIC(ns, SETPOINT_ID), &variant) !=
+                    UA_STATUSCODE_BADOUTOFRANGE) {
+                    counters.nonFiniteAccepted++;
+                }
+            } else if (i % 10 == 9) {
+                double value = setpoint(rng);
+                UA_Variant variant;
+                UA_Variant_setScalar(&variant, &value, &UA_TYPES[UA_TYPES_DOUBLE]);
+                if (UA_Client_writeValueAttribute(client, UA_NODEID_NUMERIC(ns, SETPOINT_ID), &variant) !=
+                    UA_STATUSCODE_GOOD) {
+                    counters.errors++;
+                }
+            } else {
+                UA_ReadRequest request;
+                UA_ReadRequest_init(&request);
+                request.nodesToRead = readIds.data();
+                request.nodesToReadSize = readIds.size();
+                request.timestampsToReturn = UA_TIMESTAMPSTORETURN_SOURCE;
+                UA_ReadResponse response = UA_Client_Service_read(client, request);
+                if (response.responseHeader.serviceResult != UA_STATUSCODE_GOOD) {
+                    counters.errors++;
+                } else {
+                    // Сервис может ответить Good при плохом статусе каждого элемента
+                    uint64_t bad = response.resultsSize == readIds.size() ? 0 : readIds.size();
+                    for (size_t r = 0; r < response.resultsSize; ++r) {
+                        if (response.results[r].hasStatus && response.results[r].status != UA_STATUSCODE_GOOD) {
+                            ++bad;
+                        }
+                    }
+                    if (bad > 0) {
+                        counters.errors++;
+                        counters.badReadItems += bad;
+                    }
+                }
+                UA_ReadResponse_clear(&response);
+            }
+            counters.requests++;
+            UA_Client_run_iterate(client, 0); // уведомления подписки
+        }
+
+        if (subscription.responseHeader.serviceResult == UA_STATUSCODE_GOOD) {
+            UA_Client_Subscriptions_deleteSingle(client, subscription.subscriptionId);
+            if (pushSampling) {
+                // Первое уведомление - начальное значение; следующие дает только выборка по тактам
+                counters.pushSessions++;
+                if (*std::max_element(std::begin(notifications), std::end(notifications)) > 1) {
+                    counters.pushedSessions++;
+                }
+            }
+        }
+        UA_CreateSubscriptionResponse_clear(&subscription);
+        UA_Client_disconnect(client);
+        UA_Client_delete(client);
+    }
+}
+
+// ============================== ОПЕРАТОР ПАРКА ==============================
+// Вызов метода EquipmentControl; false при ошибке. ticket - номер из второго
+// выходного аргумента, ids (если передан) - NodeId из первого
+static bool callFleetMethod(UA_Client* client, UA_UInt16 ns, UA_UInt32 methodId, size_t inputSize,
+                            const UA_Variant* input, uint64_t& ticket, std::vector<UA_NodeId>* ids) {
+    size_t outputSize = 0;
+    UA_Variant* output = nullptr;
+    UA_StatusCode status = UA_Client_call(client, UA_NODEID_NUMERIC(ns, EquipmentControl::OBJECT_ID),
+                                          UA_NODEID_NUMERIC(ns, methodId), inputSize, input, &outputSize, &output);
+    bool ok = status == UA_STATUSCODE_GOOD && outputSize == 2 &&
+              UA_Variant_hasScalarType(&output[1], &UA_TYPES[UA_TYPES_UINT64]);
+    if (ok) {
+        ticket = *static_cast<const UA_UInt64*>(output[1].data);
+        if (ids && output[0].type == &UA_TYPES[UA_TYPES_NODEID]) {
+            const UA_NodeId* nodes = static_cast<const UA_NodeId*>(output[0].data);
+            ids->assign(nodes, nodes + output[0].arrayLength);
+        }
+    }
+    UA_Array_delete(output, outputSize, &UA_TYPES[UA_TYPES_VARIANT]);
+    return ok;
+}
+
+// Ждет FleetChangesApplied >= ticket
+static bool waitFleetApplied(UA_Client* client, UA_UInt16 ns, uint64_t ticket, const std::atomic<bool>& stop) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (!stop && std::chrono::steady_clock::now() < deadline) {
+        UA_Variant value;
+        UA_Variant_init(&value);
+        UA_StatusCode status = UA_Client_readValueAttribute(
+            client, UA_NODEID_NUMERIC(ns, EquipmentControl::FLEET_APPLIED_ID), &value);
+        bool done = status == UA_STATUSCODE_GOOD && UA_Variant_hasScalarType(&value, &UA_TYPES[UA_TYPES_UINT64]) &&
+                    *static_cast<const UA_UInt64*>(value.data) >= ticket;
+        UA_Variant_clear(&value);
+        if (done) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return stop.load();
+}
+
+// По кругу: партия устройств очередного типа добавляется, живет полцикла и
+// удаляется - слоты ValueStore, узлы и MonitoredItems переиспользуются
+static void runFleetOperator(const SoakOptions& options, UA_UInt16 ns, const std::atomic<bool>& stop,
+                             ClientCounters& counters) {
+    static const char* const kinds[] = {"Multimeter", "Machine", "Computer"};
+    const std::string url = "opc.tcp://localhost:" + std::to_string(options.port);
+    const auto halfCycle = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::duration<double>(options.fleetCycleSec / 2.0));
+    UA_Client* client = nullptr;
+    for (size_t cycle = 0; !stop; ++cycle) {
+        if (!client && !(client = connectClient(url))) {
+            counters.fleetErrors++;
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            continue;
+        }
+
+        UA_Variant input[2];
+        UA_String kind = UA_STRING(const_cast<char*>(kinds[cycle % 3]));
+        UA_UInt32 count = static_cast<UA_UInt32>(options.fleetBatch);
+        UA_Variant_setScalar(&input[0], &kind, &UA_TYPES[UA_TYPES_STRING]);
+        UA_Variant_setScalar(&input[1], &count, &UA_TYPES[UA_TYPES_UINT32]);
+        std::vector<UA_NodeId> ids;
+        uint64_t ticket = 0;
+        if (!callFleetMethod(client, ns, EquipmentControl::ADD_DEVICES_ID, 2, input, ticket, &ids) ||
+            !waitFleetApplied(client, ns, ticket, stop)) {
+            counters.fleetErrors++;
+            UA_Client_disconnect(client);
+            UA_Client_delete(client);
+            client = nullptr;
+            continue;
+        }
+        std::this_thread::sleep_for(halfCycle);
+
+        UA_Variant removeInput;
+        UA_Variant_setArray(&removeInput, ids.data(), ids.size(), &UA_TYPES[UA_TYPES_NODEID]);
+        if (!callFleetMethod(client, ns, EquipmentControl::REMOVE_DEVICES_ID, 1, &removeInput, ticket, nullptr) ||
+            !waitFleetApplied(client, ns, ticket, stop)) {
+            counters.fleetErrors++;
+        } else {
+            counters.fleetCycles++;
+        }
+        std::this_thread::sleep_for(halfCycle);
+    }
+    if (client) {
+        UA_Client_disconnect(client);
+        UA_Client_delete(client);
+    }
+}
+
+// ============================== ВЫБОРКИ ==============================
+struct SoakSample {
+    double elapsedSec = 0.0;
+    double rssMb = 0.0;
+    int64_t liveAllocations = 0;
+    uint64_t allocations = 0;
+    double tickP50Us = 0.0;
+    double tickP99Us = 0.0;
+    double tickMaxUs = 0.0;
+    uint64_t ticks = 0;
+    uint64_t sessions = 0;
+    uint64_t requests = 0;
+    uint64_t errors = 0;
+    uint64_t fleetCycles = 0;
+};
+
+// Резидентная память процесса; 0, если недоступна
+static double residentSetMb() {
+#ifdef __linux__
+    std::ifstream statm("/proc/self/statm");
+    long pages = 0, resident = 0;
+    if (statm >> pages >> resident) {
+        return static_cast<double>(resident) * sysconf(_SC_PAGESIZE) / (1024.0 * 1024.0);
+    }
+#endif
+    return 0.0;
+}
+
+// Причина выхода за пределы относительно базовой выборки; пустая строка - в норме
+static std::string checkBounds(const SoakOptions& options, const SoakSample& base, const SoakSample& s) {
+    std::ostringstream reason;
+    if (base.rssMb > 0.0 && s.rssMb - base.rssMb > options.maxRssGrowthMb) {
+        reason << "RSS вырос на " << (s.rssMb - base.rssMb) << " МБ (предел " << options.maxRssGrowthMb << ")";
+    } else if (static_cast<double>(s.liveAllocations - base.liveAllocations) > options.maxLiveAllocationGrowth) {
+        reason << "живых выделений больше на " << (s.liveAllocations - base.liveAllocations)
+               << " (предел " << options.maxLiveAllocationGrowth << ")";
+    } else if (s.tickP99Us > base.tickP99Us * options.maxLatencyRatio + options.latencySlackUs) {
+        reason << "p99 такта " << s.tickP99Us << " мкс при базовом " << base.tickP99Us << " мкс";
+    }
+    return reason.str();
+}
+
+static void printUsage() {
+    std::cout << "Usage: server_soak [--duration <s>] [--warmup <s>] [--sample-interval <s>]\n"
+                 "                   [--tick-ms <ms>] [--clients <n>] [--requests-per-session <n>]\n"
+                 "                   [--fleet-cycle-s <s>] [--fleet-batch <n>]\n"
+                 "                   [--port <n>] [--max-rss-growth-mb <mb>] [--max-live-growth <n>]\n"
+                 "                   [--max-latency-ratio <x>] [--latency-slack-us <us>] [--csv <file>]"
+              << std::endl;
+}
+
+// ============================== ТОЧКА ВХОДА ==============================
+int main(int argc, char** argv) {
+#ifdef _WIN32
+    SetConsoleOutputCP(CP_UTF8);
+#endif
+
+    SoakOptions options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--duration" && hasValue) options.durationSec = std::atof(argv[++i]);
+        else if (arg == "--warmup" && hasValue) options.warmupSec = std::atof(argv[++i]);
+        else if (arg == "--sample-interval" && hasValue) options.sampleIntervalSec = std::max(0.1, std::atof(argv[++i]));
+        else if (arg == "--tick-ms" && hasValue) options.tickMs = std::max(1.0, std::atof(argv[++i]));
+        else if (arg == "--clients" && hasValue) options.clients = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--requests-per-session" && hasValue) options.requestsPerSession = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--fleet-cycle-s" && hasValue) options.fleetCycleSec = std::max(0.0, std::atof(argv[++i]));
+        else if (arg == "--fleet-batch" && hasValue) options.fleetBatch = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--port" && hasValue) options.port = static_cast<UA_UInt16>(std::atoi(argv[++i]));
+        else if (arg == "--max-rss-growth-mb" && hasValue) options.maxRssGrowthMb = std::atof(argv[++i]);
+        else if (arg == "--max-live-growth" && hasValue) options.maxLiveAllocationGrowth = std::atof(argv[++i]);
+        else if (arg == "--max-latency-ratio" && hasValue) options.maxLatencyRatio = std::atof(argv[++i]);
+        else if (arg == "--latency-slack-us" && hasValue) options.latencySlackUs = std::atof(argv[++i]);
+        else if (arg == "--csv" && hasValue) options.csvPath = argv[++i];
+        else {
+            printUsage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    AllocStats::install();
+    if (!AllocStats::tracksLibraryAllocations()) {
+        std::cout << "Внимание: выделения внутри open62541 не учитываются (только operator new)" << std::endl;
+    }
+    if (residentSetMb() == 0.0) {
+        std::cout << "Внимание: RSS недоступен на этой платформе, проверка памяти только по выделениям" << std::endl;
+    }
+
+    std::ofstream csv;
+    if (!options.csvPath.empty()) {
+        csv.open(options.csvPath);
+        csv << "elapsed_s,rss_mb,live_allocations,allocations,tick_p50_us,tick_p99_us,tick_max_us,"
+               "ticks,sessions,requests,errors,fleet_cycles\n";
+    }
+
+    std::string failure;
+    try {
+        TickStats tickStats;
+        ClientCounters counters;
+        std::atomic<bool> stop(false);
+
+        // Рабочий сервер в ускоренном режиме: такт tickMs, без вывода на каждом такте
+        OPCUAServer server;
+        server.setPort(options.port);
+        server.setLogLevel(UA_LOGLEVEL_WARNING);
+        server.setFleetChangesPerTick(0);
+        if (!server.initialize() || !server.start()) {
+            std::cerr << "Не удалось запустить сервер" << std::endl;
+            return 1;
+        }
+        server.setTickPeriod(std::chrono::microseconds(static_cast<long long>(options.tickMs * 1000.0)));
+        server.setConsoleOutput(false);
+        server.setTickObserver([&tickStats](uint64_t ns) { tickStats.record(ns); });
+        const UA_UInt16 ns = server.getNamespaceIndex();
+
+        std::thread serverThread([&server]() { server.run(); });
+        std::vector<std::thread> clients;
+        for (int i = 0; i < options.clients; ++i) {
+            clients.emplace_back(runClient, std::cref(options), ns, 4321u + i, i % 2 == 1,
+                                 std::cref(stop), std::ref(counters));
+        }
+        if (options.fleetCycleSec > 0.0) {
+            clients.emplace_back(runFleetOperator, std::cref(options), ns, std::cref(stop), std::ref(counters));
+        }
+
+        std::cout << "Прогон: " << options.durationSec << " с, такт " << options.tickMs << " мс, клиентов "
+                  << options.clients << ", прогрев " << options.warmupSec << " с\n" << std::endl;
+        std::cout << std::right << std::setw(10) << "elapsed s" << std::setw(10) << "RSS MB"
+                  << std::setw(12) << "live alloc" << std::setw(12) << "p50 us" << std::setw(12) << "p99 us"
+                  << std::setw(12) << "max us" << std::setw(10) << "sessions" << std::setw(10) << "errors"
+                  << std::setw(8) << "fleet" << std::endl;
+
+        using Clock = std::chrono::steady_clock;
+        const auto started = Clock::now();
+        const auto interval = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(options.sampleIntervalSec));
+        auto nextSample = started + interval;
+        bool haveBase = false;
+        SoakSample base;
+
+        for (;;) {
+            std::this_thread::sleep_until(nextSample);
+            nextSample += interval;
+
+            SoakSample s;
+            s.elapsedSec = std::chrono::duration<double>(Clock::now() - started).count();
+            s.rssMb = residentSetMb();
+            AllocSnapshot allocs = AllocStats::snapshot();
+            s.allocations = allocs.allocations;
+            s.liveAllocations = static_cast<int64_t>(allocs.allocations - allocs.deallocations);
+            double percentiles[3];
+            s.ticks = tickStats.take(percentiles);
+            s.tickP50Us = percentiles[0];
+            s.tickP99Us = percentiles[1];
+            s.tickMaxUs = percentiles[2];
+            s.sessions = counters.sessions.load();
+            s.requests = counters.requests.load();
+            s.errors = counters.errors.load();
+            s.fleetCycles = counters.fleetCycles.load();
+
+            std::cout << std::setw(10) << std::fixed << std::setprecision(0) << s.elapsedSec
+                      << std::setw(10) << std::setprecision(1) << s.rssMb << std::setw(12) << s.liveAllocations
+                      << std::setw(12) << s.tickP50Us << std::setw(12) << s.tickP99Us << std::setw(12) << s.tickMaxUs
+                      << std::setw(10) << s.sessions << std::setw(10) << s.errors << std::setw(8) << s.fleetCycles
+                      << std::endl;
+            if (csv) {
+                csv << s.elapsedSec << ',' << s.rssMb << ',' << s.liveAllocations << ',' << s.allocations << ','
+                    << s.tickP50Us << ',' << s.tickP99Us << ',' << s.tickMaxUs << ',' << s.ticks << ','
+                    << s.sessions << ',' << s.requests << ',' << s.errors << ',' << s.fleetCycles << std::endl;
+            }
+
+            if (!haveBase && s.elapsedSec >= options.warmupSec) {
+                base = s;
+                haveBase = true;
+            } else if (haveBase) {
+                failure = checkBounds(options, base, s);
+                if (!failure.empty()) break;
+            }
+            if (s.elapsedSec >= options.durationSec) break;
+        }
+
+        stop = true;
+        for (auto& t : clients) t.join();
+        server.requestStop();
+        serverThread.join();
+        server.printTickReport();
+        server.stop();
+
+        if (options.clients > 0 && counters.sessions.load() == 0 && failure.empty()) {
+            failure = "ни один клиент не подключился";
+        }
+        if (counters.pushSessions.load() > 0 && counters.pushedSessions.load() == 0 && failure.empty()) {
+            failure = "MonitoredItems с SamplingInterval = 0 не получили ни одного изменения";
+        }
+        if (options.fleetCycleSec > 0.0 && counters.fleetErrors.load() > 0 && failure.empty()) {
+            failure = "ошибок добавления/удаления устройств: " + std::to_string(counters.fleetErrors.load());
+        }
+        if (counters.badReadItems.load() > 0 && failure.empty()) {
+            failure = "элементов Read с плохим статусом: " + std::to_string(counters.badReadItems.load());
+        }
+        if (counters.nonFiniteAccepted.load() > 0 && failure.empty()) {
+            failure = "запись NaN в уставку не отклонена " + std::to_string(counters.nonFiniteAccepted.load()) + " раз";
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Исключение: " << e.what() << std::endl;
+        return 1;
+    }
+
+    if (!failure.empty()) {
+        std::cout << "\nSOAK FAILED: " << failure << std::endl;
+        return 1;
+    }
+    std::cout << "\nSOAK PASSED" << std::endl;
+    return 0;
+}
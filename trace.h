@@ -0,0 +1,176 @@
+#pragma once
+
+// ============================== ТРАССИРОВКА ФАЗ ЦИКЛА ==============================
+// Включается при сборке опцией SERVER_ENABLE_TRACING. Без нее TRACE_SPAN и
+// TRACE_DUMP_* раскрываются в пустоту и не оставляют следа в коде.
+//
+// Каждый поток пишет завершенные интервалы в собственный кольцевой буфер
+// (один писатель, без блокировок). Выгрузка в формат Chrome trace
+// (chrome://tracing, Perfetto) выполняется по сигналу SIGUSR1 или при остановке.
+
+#ifdef SERVER_ENABLE_TRACING
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct TraceEvent {
+    const char* name; // только строковые литералы
+    uint64_t startNs;
+    uint64_t durationNs;
+};
+
+class TraceBuffer {
+public:
+    static constexpr size_t CAPACITY = 1 << 16;
+    static constexpr size_t MASK = CAPACITY - 1;
+
+private:
+    TraceEvent events[CAPACITY];
+    std::atomic<uint64_t> head; // число записанных событий за все время
+    uint32_t threadId;
+
+public:
+    explicit TraceBuffer(uint32_t tid) : head(0), threadId(tid) {}
+
+    uint32_t getThreadId() const { return threadId; }
+
+    void push(const char* name, uint64_t startNs, uint64_t endNs) {
+        uint64_t h = head.load(std::memory_order_relaxed);
+        TraceEvent& e = events[h & MASK];
+        e.name = name;
+        e.startNs = startNs;
+        e.durationNs = endNs - startNs;
+        head.store(h + 1, std::memory_order_release);
+    }
+
+    // Копирует последние события. Писатель может продолжать работу: записи,
+    // которые он успел перезаписать во время копирования, отбрасываются.
+    void snapshot(std::vector<TraceEvent>& out) const {
+        uint64_t before = head.load(std::memory_order_acquire);
+        uint64_t first = before > CAPACITY ? before - CAPACITY : 0;
+        std::vector<TraceEvent> copy;
+        copy.reserve(static_cast<size_t>(before - first));
+        for (uint64_t i = first; i < before; ++i) {
+            copy.push_back(events[i & MASK]);
+        }
+        uint64_t after = head.load(std::memory_order_acquire);
+        uint64_t overwritten = after > CAPACITY ? after - CAPACITY : 0;
+        for (uint64_t i = first; i < before; ++i) {
+            if (i >= overwritten) out.push_back(copy[static_cast<size_t>(i - first)]);
+        }
+    }
+};
+
+class Tracer {
+private:
+    std::mutex mutex; // только регистрация потоков и выгрузка
+    std::vector<std::unique_ptr<TraceBuffer>> buffers;
+    std::chrono::steady_clock::time_point origin;
+    volatile std::sig_atomic_t dumpRequested;
+
+    Tracer() : origin(std::chrono::steady_clock::now()), dumpRequested(0) {}
+
+    TraceBuffer* registerThread() {
+        std::lock_guard<std::mutex> lock(mutex);
+        buffers.push_back(std::make_unique<TraceBuffer>(static_cast<uint32_t>(buffers.size() + 1)));
+        return buffers.back().get();
+    }
+
+public:
+    static Tracer& instance() {
+        static Tracer tracer;
+        return tracer;
+    }
+
+    static uint64_t nowNs() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - instance().origin).count());
+    }
+
+    static TraceBuffer& threadBuffer() {
+        thread_local TraceBuffer* buffer = instance().registerThread();
+        return *buffer;
+    }
+
+    // Безопасно вызывать из обработчика сигнала
+    static void requestDump() { instance().dumpRequested = 1; }
+
+    static bool takeDumpRequest() {
+        Tracer& t = instance();
+        if (!t.dumpRequested) return false;
+        t.dumpRequested = 0;
+        return true;
+    }
+
+    // Путь берется из переменной окружения SERVER_TRACE_FILE
+    static std::string outputPath() {
+        const char* path = std::getenv("SERVER_TRACE_FILE");
+        return path && *path ? path : "server_trace.json";
+    }
+
+    static bool dump(const std::string& path) {
+        Tracer& t = instance();
+        std::ofstream out(path);
+        if (!out) return false;
+
+        out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        bool first = true;
+        std::vector<TraceEvent> events;
+
+        std::lock_guard<std::mutex> lock(t.mutex);
+        for (const auto& buffer : t.buffers) {
+            events.clear();
+            buffer->snapshot(events);
+            for (const TraceEvent& e : events) {
+                out << (first ? "\n" : ",\n")
+                    << "{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+                    << buffer->getThreadId() << ",\"ts\":" << e.startNs / 1000 << '.'
+                    << (e.startNs % 1000) / 100 << (e.startNs % 100) / 10 << e.startNs % 10
+                    << ",\"dur\":" << e.durationNs / 1000 << '.'
+                    << (e.durationNs % 1000) / 100 << (e.durationNs % 100) / 10 << e.durationNs % 10
+                    << "}";
+                first = false;
+            }
+        }
+        out << "\n]}\n";
+        return static_cast<bool>(out);
+    }
+};
+
+class TraceSpan {
+private:
+    const char* name;
+    uint64_t startNs;
+
+public:
+    explicit TraceSpan(const char* spanName) : name(spanName), startNs(Tracer::nowNs()) {}
+    ~TraceSpan() { Tracer::threadBuffer().push(name, startNs, Tracer::nowNs()); }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SPAN(name) TraceSpan TRACE_CONCAT(traceSpan_, __LINE__)(name)
+#define TRACE_DUMP_REQUEST() Tracer::requestDump()
+#define TRACE_DUMP_IF_REQUESTED() \
+    do { if (Tracer::takeDumpRequest()) Tracer::dump(Tracer::outputPath()); } while (0)
+#define TRACE_DUMP() Tracer::dump(Tracer::outputPath())
+
+#else
+
+#define TRACE_SPAN(name)
+#define TRACE_DUMP_REQUEST()
+#define TRACE_DUMP_IF_REQUESTED()
+#define TRACE_DUMP()
+
+#endif
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// ============================== ТРОЙНОЙ БУФЕР ==============================
+// Один писатель и один читатель обмениваются кадрами фиксированной длины без
+// блокировок и копирования. Писатель заполняет свой (задний) буфер и публикует
+// его, меняя местами с промежуточным; читатель забирает последний
+// опубликованный кадр, меняя промежуточный со своим (передним). Кадры, которые
+// читатель не успел забрать, перезаписываются - читатель всегда видит свежий кадр.
+//
+// Передний буфер не меняется до следующего acquire(), поэтому читатель может
+// отдавать его наружу без копии.
+template<typename T>
+class TripleBuffer {
+private:
+    static constexpr uint8_t INDEX_MASK = 0x3;
+    static constexpr uint8_t FRESH = 0x4; // в промежуточном буфере новый кадр
+
+    std::unique_ptr<T[]> buffers[3];
+    int64_t stamps[3];            // метка кадра (задает писатель)
+    size_t length;
+    uint8_t back;                 // принадлежит писателю
+    uint8_t front;                // принадлежит читателю
+    std::atomic<uint8_t> middle;
+
+public:
+    explicit TripleBuffer(size_t frameLength)
+        : length(frameLength), back(0), front(1), middle(2) {
+        for (int i = 0; i < 3; ++i) {
+            buffers[i].reset(new T[frameLength]());
+            stamps[i] = 0;
+        }
+    }
+
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    size_t frameLength() const { return length; }
+
+    // ---------- сторона писателя ----------
+
+    T* backBuffer() { return buffers[back].get(); }
+
+    void publish(int64_t stamp) {
+        stamps[back] = stamp;
+        back = middle.exchange(static_cast<uint8_t>(back | FRESH), std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    // ---------- сторона читателя ----------
+
+    // true, если появился новый кадр и он стал передним
+    bool acquire() {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH)) {
+            return false;
+        }
+        front = middle.exchange(front, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+
+    const T* frontBuffer() const { return buffers[front].get(); }
+    int64_t frontStamp() const { return stamps[front]; }
+};
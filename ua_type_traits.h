@@ -0,0 +1,76 @@
+#pragma once
+
+#include <open62541/types.h>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+// ============================== СООТВЕТСТВИЕ ТИПОВ C++ И UA_TYPES ==============================
+// Описатель типа OPC UA выбирается при компиляции по типу C++. Для неподдерживаемых
+// типов специализации нет, и ошибка возникает при сборке, а не при записи значения.
+//
+//   Element     - тип элемента (для std::array<T, N> - T)
+//   TYPE_INDEX  - индекс в UA_TYPES
+//   ARRAY_LENGTH - 0 для скаляров, N для std::array<T, N>
+template<typename T>
+struct UATypeTraits;
+
+template<typename T, size_t Index>
+struct UAScalarTypeTraits {
+    using Element = T;
+    static constexpr size_t TYPE_INDEX = Index;
+    static constexpr size_t ARRAY_LENGTH = 0;
+
+    static const UA_DataType* type() { return &UA_TYPES[Index]; }
+
+    // Приведение результата вычисляемого тега к типу переменной. Для целых
+    // значение округляется и ограничивается диапазоном типа, NaN дает 0:
+    // приведение double вне диапазона к целому - неопределенное поведение
+    static T fromDouble(double value) {
+        if constexpr (std::is_same<T, bool>::value) {
+            return static_cast<T>(!std::isnan(value) && value != 0.0);
+        } else if constexpr (std::is_integral<T>::value) {
+            if (std::isnan(value)) {
+                return 0;
+            }
+            // Границы int64/uint64 в double округляются вверх, поэтому сравнение нестрогое
+            if (value >= static_cast<double>(std::numeric_limits<T>::max())) {
+                return std::numeric_limits<T>::max();
+            }
+            if (value <= static_cast<double>(std::numeric_limits<T>::min())) {
+                return std::numeric_limits<T>::min();
+            }
+            return static_cast<T>(std::round(value));
+        } else {
+            return static_cast<T>(value);
+        }
+    }
+};
+
+template<> struct UATypeTraits<bool>     : UAScalarTypeTraits<bool, UA_TYPES_BOOLEAN> {};
+template<> struct UATypeTraits<int8_t>   : UAScalarTypeTraits<int8_t, UA_TYPES_SBYTE> {};
+template<> struct UATypeTraits<uint8_t>  : UAScalarTypeTraits<uint8_t, UA_TYPES_BYTE> {};
+template<> struct UATypeTraits<int16_t>  : UAScalarTypeTraits<int16_t, UA_TYPES_INT16> {};
+template<> struct UATypeTraits<uint16_t> : UAScalarTypeTraits<uint16_t, UA_TYPES_UINT16> {};
+template<> struct UATypeTraits<int32_t>  : UAScalarTypeTraits<int32_t, UA_TYPES_INT32> {};
+template<> struct UATypeTraits<uint32_t> : UAScalarTypeTraits<uint32_t, UA_TYPES_UINT32> {};
+template<> struct UATypeTraits<int64_t>  : UAScalarTypeTraits<int64_t, UA_TYPES_INT64> {};
+template<> struct UATypeTraits<uint64_t> : UAScalarTypeTraits<uint64_t, UA_TYPES_UINT64> {};
+template<> struct UATypeTraits<float>    : UAScalarTypeTraits<float, UA_TYPES_FLOAT> {};
+template<> struct UATypeTraits<double>   : UAScalarTypeTraits<double, UA_TYPES_DOUBLE> {};
+
+// Массив фиксированной длины - одномерная переменная с ArrayDimensions = {N}
+template<typename T, size_t N>
+struct UATypeTraits<std::array<T, N>> {
+    static_assert(N > 0, "Пустые массивы не поддерживаются");
+    static_assert(UATypeTraits<T>::ARRAY_LENGTH == 0, "Вложенные массивы не поддерживаются");
+
+    using Element = T;
+    static constexpr size_t TYPE_INDEX = UATypeTraits<T>::TYPE_INDEX;
+    static constexpr size_t ARRAY_LENGTH = N;
+
+    static const UA_DataType* type() { return &UA_TYPES[TYPE_INDEX]; }
+};
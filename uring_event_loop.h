@@ -0,0 +1,982 @@
+#pragma once
+
+#include <open62541/types.h>
+#include <open62541/plugin/eventloop.h>
+#include <open62541/plugin/log_stdout.h>
+#include <liburing.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// ============================== ЦИКЛ СОБЫТИЙ НА IO_URING ==============================
+// Замена циклу событий POSIX из open62541 для сокетов сервера (только Linux,
+// ядро >= 5.19, liburing >= 2.4; сборка с SERVER_IO_URING).
+//
+// Цикл POSIX делает на каждое событие отдельный системный вызов: epoll_wait,
+// затем recv на каждый готовый сокет и send на каждый ответ. Здесь прием
+// соединений (multishot accept), чтение (recv с буферами из общего кольца
+// буферов) и отправка (sendmsg всей очереди ответов соединения) - заявки в одном
+// кольце io_uring. Заявки, накопленные за итерацию, уходят в ядро одним
+// io_uring_enter, а все готовые завершения разбираются пачкой.
+//
+// Таймеры, отложенные вызовы и время остаются за внутренним циклом POSIX без
+// собственных сокетов: он вызывается, только когда наступил срок таймера, и
+// задает время ожидания кольца. Сервер находит менеджер соединений "tcp" в
+// списке eventSources, как и у стандартного цикла.
+//
+// Ограничения: только слушающие сокеты и принятые ими соединения (исходящие
+// TCP-соединения, UDP и обработчик сигналов не поддерживаются); регистрировать
+// другие источники событий нельзя. Заявки ставятся под блокировкой цикла;
+// отправка из чужого потока (SERVER_MULTITHREADED) отдается в ядро сразу.
+struct UringStats {
+    uint64_t iterations = 0;
+    uint64_t enters = 0;        // вызовов io_uring_enter (отправка заявок и ожидание)
+    uint64_t completions = 0;
+    uint64_t accepted = 0;
+    uint64_t bytesReceived = 0;
+    uint64_t bytesSent = 0;
+    uint64_t bufferShortages = 0; // recv без свободного буфера, ждал возврата буфера
+    uint64_t acceptErrors = 0;    // ошибки accept (EMFILE и т.п.), прием приостанавливался
+};
+
+class UringEventLoop {
+public:
+    static constexpr unsigned DEFAULT_QUEUE_DEPTH = 4096;
+    static constexpr unsigned DEFAULT_RECV_BUFFERS = 1024;   // степень двойки
+    static constexpr size_t DEFAULT_RECV_BUFFER_SIZE = 16384;
+
+private:
+    // Коды операций в младших битах user_data; 0 - завершение без обработки
+    static constexpr uint64_t OP_ACCEPT = 1;
+    static constexpr uint64_t OP_RECV = 2;
+    static constexpr uint64_t OP_SEND = 3;
+    static constexpr uint64_t OP_MASK = 7;
+    static constexpr int BUFFER_GROUP = 1;
+    static constexpr size_t MAX_SEND_IOV = 64;
+    static constexpr size_t MAX_QUEUED_BYTES = 16 * 1024 * 1024; // медленный клиент отключается
+    static constexpr unsigned COMPLETION_BATCH = 256;
+    static constexpr UA_DateTime ACCEPT_RETRY_DELAY = 100 * UA_DATETIME_MSEC;
+
+    // open62541 передает указатели на UA_EventLoop/UA_ConnectionManager; объект
+    // находится по ним через эти обертки (стандартная раскладка, поле - первое)
+    struct LoopHandle {
+        UA_EventLoop el;
+        UringEventLoop* self;
+    };
+
+    struct ManagerHandle {
+        UA_ConnectionManager cm;
+        UringEventLoop* self;
+    };
+
+    struct alignas(8) Connection {
+        int fd;
+        bool listening;
+        void* application;
+        void* context;
+        UA_ConnectionManager_connectionCallback callback;
+        bool closing = false;
+        bool closed = false;
+        bool acceptArmed = false;
+        bool recvArmed = false;
+        bool sending = false;
+        bool starved = false;          // recv ждет возврата буфера (в starvedConnections)
+        UA_DateTime acceptRetryAt = 0; // прием приостановлен после ошибки (в pausedListeners)
+        std::deque<UA_ByteString> sendQueue;
+        size_t sendOffset = 0;  // отправлено из sendQueue.front()
+        size_t queuedBytes = 0;
+        std::vector<iovec> iov; // живут до завершения sendmsg
+        msghdr message;
+
+        unsigned inflight() const { return acceptArmed + recvArmed + sending; }
+    };
+
+    LoopHandle loop{};
+    ManagerHandle tcp{};
+    UA_Logger* logger = nullptr;
+    UA_EventLoop* inner = nullptr;
+
+    io_uring ring;
+    bool ringReady = false;
+    io_uring_buf_ring* bufferRing = nullptr;
+    std::unique_ptr<unsigned char[]> bufferMemory;
+    unsigned queueDepth;
+    unsigned bufferCount;
+    size_t bufferSize;
+
+    std::unordered_map<uintptr_t, Connection*> connections;
+    std::vector<Connection*> closingConnections;
+    // Без заявки в кольце: повторный recv сразу после ENOBUFS и accept сразу после
+    // EMFILE завершились бы той же ошибкой, и цикл крутился бы вхолостую
+    std::vector<Connection*> starvedConnections;
+    std::vector<Connection*> pausedListeners;
+    bool bufferReturned = false;
+    std::thread::id loopThread;
+    UringStats counters;
+
+    static UringEventLoop* self(UA_EventLoop* el) { return reinterpret_cast<LoopHandle*>(el)->self; }
+    static UringEventLoop* self(UA_ConnectionManager* cm) { return reinterpret_cast<ManagerHandle*>(cm)->self; }
+    static UringEventLoop* self(UA_EventSource* es) { return reinterpret_cast<ManagerHandle*>(es)->self; }
+
+    void setState(UA_EventLoopState state) {
+        *const_cast<UA_EventLoopState*>(&loop.el.state) = state;
+    }
+
+    void lock() { inner->lock(inner); }
+    void unlock() { inner->unlock(inner); }
+    bool onLoopThread() const { return std::this_thread::get_id() == loopThread; }
+
+    // ---------- кольцо ----------
+
+    void submit() {
+        if (io_uring_sq_ready(&ring) > 0) {
+            io_uring_submit(&ring);
+            ++counters.enters;
+        }
+    }
+
+    io_uring_sqe* nextSqe() {
+        io_uring_sqe* sqe = io_uring_get_sqe(&ring);
+        if (!sqe) {
+            submit(); // очередь заявок заполнена - отдаем ее раньше конца итерации
+            sqe = io_uring_get_sqe(&ring);
+        }
+        return sqe;
+    }
+
+    static uint64_t userData(Connection* conn, uint64_t op) {
+        return reinterpret_cast<uint64_t>(conn) | op;
+    }
+
+    void armAccept(Connection* conn) {
+        io_uring_sqe* sqe = nextSqe();
+        if (!sqe) {
+            beginClose(conn);
+            return;
+        }
+        io_uring_prep_multishot_accept(sqe, conn->fd, nullptr, nullptr, SOCK_CLOEXEC);
+        io_uring_sqe_set_data64(sqe, userData(conn, OP_ACCEPT));
+        conn->acceptArmed = true;
+    }
+
+    void armRecv(Connection* conn) {
+        io_uring_sqe* sqe = nextSqe();
+        if (!sqe) {
+            beginClose(conn);
+            return;
+        }
+        io_uring_prep_recv(sqe, conn->fd, nullptr, bufferSize, 0);
+        sqe->flags |= IOSQE_BUFFER_SELECT;
+        sqe->buf_group = BUFFER_GROUP;
+        io_uring_sqe_set_data64(sqe, userData(conn, OP_RECV));
+        conn->recvArmed = true;
+    }
+
+    // Один sendmsg на всю очередь ответов соединения (до MAX_SEND_IOV буферов)
+    void armSend(Connection* conn) {
+        io_uring_sqe* sqe = nextSqe();
+        if (!sqe) {
+            beginClose(conn);
+            return;
+        }
+        conn->iov.clear();
+        for (const UA_ByteString& buffer : conn->sendQueue) {
+            if (conn->iov.size() == MAX_SEND_IOV) break;
+            size_t skip = conn->iov.empty() ? conn->sendOffset : 0;
+            conn->iov.push_back(iovec{buffer.data + skip, buffer.length - skip});
+        }
+        std::memset(&conn->message, 0, sizeof(conn->message));
+        conn->message.msg_iov = conn->iov.data();
+        conn->message.msg_iovlen = conn->iov.size();
+        io_uring_prep_sendmsg(sqe, conn->fd, &conn->message, MSG_NOSIGNAL);
+        io_uring_sqe_set_data64(sqe, userData(conn, OP_SEND));
+        conn->sending = true;
+    }
+
+    void returnBuffer(unsigned short id) {
+        io_uring_buf_ring_add(bufferRing, bufferMemory.get() + static_cast<size_t>(id) * bufferSize,
+                              static_cast<unsigned>(bufferSize), id, io_uring_buf_ring_mask(bufferCount), 0);
+        io_uring_buf_ring_advance(bufferRing, 1);
+        bufferReturned = true;
+    }
+
+    // Повторяет recv соединений, ждавших буфер, если с прошлого раза хоть один
+    // буфер вернулся в кольцо. Буферы возвращаются при разборе завершений, так
+    // что без возвратов свободных буферов нет, и повтор бесполезен
+    void resumeStarved() {
+        if (!bufferReturned || starvedConnections.empty()) {
+            return;
+        }
+        bufferReturned = false;
+        std::vector<Connection*> pending;
+        pending.swap(starvedConnections);
+        for (Connection* conn : pending) {
+            conn->starved = false;
+            if (!conn->closing) {
+                armRecv(conn);
+            }
+        }
+    }
+
+    // Возобновляет прием на слушающих сокетах, у которых истекла пауза после ошибки
+    void resumeListeners(UA_DateTime now) {
+        for (size_t i = 0; i < pausedListeners.size();) {
+            Connection* conn = pausedListeners[i];
+            if (conn->acceptRetryAt > now && !conn->closing) {
+                ++i;
+                continue;
+            }
+            conn->acceptRetryAt = 0;
+            pausedListeners[i] = pausedListeners.back();
+            pausedListeners.pop_back();
+            if (!conn->closing) {
+                armAccept(conn);
+            }
+        }
+    }
+
+    // Ближайший срок возобновления приема; waitUntil, если приостановленных нет
+    UA_DateTime nextListenerRetry(UA_DateTime waitUntil) const {
+        for (const Connection* conn : pausedListeners) {
+            waitUntil = std::min(waitUntil, conn->acceptRetryAt);
+        }
+        return waitUntil;
+    }
+
+    // ---------- соединения ----------
+
+    // Заявки соединения отменяются; сам сокет закрывается в finishClosing(),
+    // когда их завершения разобраны
+    void beginClose(Connection* conn) {
+        if (conn->closing) {
+            return;
+        }
+        conn->closing = true;
+        closingConnections.push_back(conn);
+        if (conn->listening) {
+            io_uring_sqe* sqe = conn->acceptArmed ? nextSqe() : nullptr;
+            if (sqe) {
+                io_uring_prep_cancel64(sqe, userData(conn, OP_ACCEPT), 0);
+                io_uring_sqe_set_data64(sqe, 0);
+            }
+        } else {
+            ::shutdown(conn->fd, SHUT_RDWR); // recv завершится с 0, sendmsg - с ошибкой
+        }
+    }
+
+    void finishClosing() {
+        std::vector<Connection*> pending;
+        pending.swap(closingConnections);
+        for (size_t i = 0; i < pending.size(); ++i) {
+            Connection* conn = pending[i];
+            if (conn->inflight() > 0) {
+                closingConnections.push_back(conn);
+                continue;
+            }
+            conn->closed = true;
+            if (conn->starved) {
+                starvedConnections.erase(std::find(starvedConnections.begin(), starvedConnections.end(), conn));
+            }
+            if (conn->acceptRetryAt != 0) {
+                pausedListeners.erase(std::find(pausedListeners.begin(), pausedListeners.end(), conn));
+            }
+            conn->callback(&tcp.cm, static_cast<uintptr_t>(conn->fd), conn->application, &conn->context,
+                           UA_CONNECTIONSTATE_CLOSING, &UA_KEYVALUEMAP_NULL, UA_BYTESTRING_NULL);
+            connections.erase(static_cast<uintptr_t>(conn->fd));
+            ::close(conn->fd);
+            for (UA_ByteString& buffer : conn->sendQueue) {
+                UA_ByteString_clear(&buffer);
+            }
+            delete conn;
+        }
+        if (tcp.cm.eventSource.state == UA_EVENTSOURCESTATE_STOPPING && connections.empty()) {
+            tcp.cm.eventSource.state = UA_EVENTSOURCESTATE_STOPPED;
+        }
+    }
+
+    Connection* registerConnection(int fd, bool listening, void* application, void* context,
+                                   UA_ConnectionManager_connectionCallback callback) {
+        Connection* conn = new Connection();
+        conn->fd = fd;
+        conn->listening = listening;
+        conn->application = application;
+        conn->context = context;
+        conn->callback = callback;
+        connections[static_cast<uintptr_t>(fd)] = conn;
+        return conn;
+    }
+
+    static std::string peerAddress(int fd) {
+        sockaddr_storage address;
+        socklen_t length = sizeof(address);
+        char host[NI_MAXHOST] = "";
+        if (::getpeername(fd, reinterpret_cast<sockaddr*>(&address), &length) == 0) {
+            ::getnameinfo(reinterpret_cast<sockaddr*>(&address), length, host, sizeof(host), nullptr, 0,
+                          NI_NUMERICHOST);
+        }
+        return host;
+    }
+
+    void accepted(Connection* listener, int fd) {
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        ++counters.accepted;
+
+        // Начальный контекст - контекст слушающего сокета (как у цикла POSIX)
+        Connection* conn = registerConnection(fd, false, listener->application, listener->context,
+                                              listener->callback);
+        std::string remote = peerAddress(fd);
+        UA_String remoteString = UA_STRING(const_cast<char*>(remote.c_str()));
+        UA_KeyValuePair pair;
+        pair.key = UA_QUALIFIEDNAME(0, const_cast<char*>("remote-address"));
+        UA_Variant_setScalar(&pair.value, &remoteString, &UA_TYPES[UA_TYPES_STRING]);
+        UA_KeyValueMap params = {1, &pair};
+        conn->callback(&tcp.cm, static_cast<uintptr_t>(fd), conn->application, &conn->context,
+                       UA_CONNECTIONSTATE_ESTABLISHED, &params, UA_BYTESTRING_NULL);
+        if (!conn->closing) {
+            armRecv(conn);
+        }
+    }
+
+    // ---------- завершения ----------
+
+    void onAccept(Connection* conn, int res, unsigned flags) {
+        if (!(flags & IORING_CQE_F_MORE)) {
+            conn->acceptArmed = false;
+        }
+        if (res >= 0) {
+            if (conn->closing) {
+                ::close(res);
+            } else {
+                accepted(conn, res);
+            }
+        } else if (res != -ECANCELED) {
+            // Чаще всего EMFILE/ENFILE: до закрытия чужих сокетов accept будет
+            // завершаться так же, поэтому прием приостанавливается на паузу
+            ++counters.acceptErrors;
+            std::cerr << "UringEventLoop: accept: " << std::strerror(-res) << ", повтор через "
+                      << ACCEPT_RETRY_DELAY / UA_DATETIME_MSEC << " мс" << std::endl;
+            if (!conn->acceptArmed && !conn->closing && conn->acceptRetryAt == 0) {
+                conn->acceptRetryAt = inner->dateTime_nowMonotonic(inner) + ACCEPT_RETRY_DELAY;
+                pausedListeners.push_back(conn);
+            }
+        }
+        if (!conn->acceptArmed && !conn->closing && conn->acceptRetryAt == 0) {
+            armAccept(conn);
+        }
+    }
+
+    void onReceive(Connection* conn, int res, unsigned flags) {
+        conn->recvArmed = false;
+        if (res > 0 && (flags & IORING_CQE_F_BUFFER)) {
+            unsigned short id = static_cast<unsigned short>(flags >> IORING_CQE_BUFFER_SHIFT);
+            counters.bytesReceived += static_cast<uint64_t>(res);
+            if (!conn->closing) {
+                UA_ByteString message;
+                message.length = static_cast<size_t>(res);
+                message.data = bufferMemory.get() + static_cast<size_t>(id) * bufferSize;
+                conn->callback(&tcp.cm, static_cast<uintptr_t>(conn->fd), conn->application, &conn->context,
+                               UA_CONNECTIONSTATE_ESTABLISHED, &UA_KEYVALUEMAP_NULL, message);
+            }
+            returnBuffer(id);
+        } else if (res == -ENOBUFS) {
+            // Все буферы заняты - соединение ждет возврата буфера (resumeStarved)
+            ++counters.bufferShortages;
+            if (!conn->closing) {
+                conn->starved = true;
+                starvedConnections.push_back(conn);
+            }
+            return;
+        } else {
+            beginClose(conn); // 0 - соединение закрыто клиентом
+        }
+        if (!conn->closing) {
+            armRecv(conn);
+        }
+    }
+
+    void onSent(Connection* conn, int res) {
+        conn->sending = false;
+        if (res < 0) {
+            beginClose(conn);
+            return;
+        }
+        counters.bytesSent += static_cast<uint64_t>(res);
+        size_t sent = static_cast<size_t>(res);
+        while (sent > 0 && !conn->sendQueue.empty()) {
+            UA_ByteString& front = conn->sendQueue.front();
+            size_t remaining = front.length - conn->sendOffset;
+            if (sent < remaining) {
+                conn->sendOffset += sent;
+                break;
+            }
+            sent -= remaining;
+            conn->queuedBytes -= front.length;
+            UA_ByteString_clear(&front);
+            conn->sendQueue.pop_front();
+            conn->sendOffset = 0;
+        }
+        if (!conn->sendQueue.empty() && !conn->closing) {
+            armSend(conn);
+        }
+    }
+
+    void processCompletions() {
+        io_uring_cqe* cqes[COMPLETION_BATCH];
+        for (;;) {
+            unsigned count = io_uring_peek_batch_cqe(&ring, cqes, COMPLETION_BATCH);
+            for (unsigned i = 0; i < count; ++i) {
+                uint64_t data = io_uring_cqe_get_data64(cqes[i]);
+                Connection* conn = reinterpret_cast<Connection*>(data & ~OP_MASK);
+                switch (data & OP_MASK) {
+                case OP_ACCEPT: onAccept(conn, cqes[i]->res, cqes[i]->flags); break;
+                case OP_RECV: onReceive(conn, cqes[i]->res, cqes[i]->flags); break;
+                case OP_SEND: onSent(conn, cqes[i]->res); break;
+                default: break; // отмена
+                }
+            }
+            io_uring_cq_advance(&ring, count);
+            counters.completions += count;
+            if (count < COMPLETION_BATCH) {
+                break;
+            }
+        }
+    }
+
+    // ---------- UA_EventLoop ----------
+
+    static UA_StatusCode start(UA_EventLoop* el) {
+        UringEventLoop* loop = self(el);
+        if (el->state != UA_EVENTLOOPSTATE_FRESH && el->state != UA_EVENTLOOPSTATE_STOPPED) {
+            return UA_STATUSCODE_BADINTERNALERROR;
+        }
+        UA_StatusCode status = loop->inner->start(loop->inner);
+        if (status != UA_STATUSCODE_GOOD) {
+            return status;
+        }
+        loop->setState(UA_EVENTLOOPSTATE_STARTED);
+        for (UA_EventSource* es = el->eventSources; es; es = es->next) {
+            if (es->state == UA_EVENTSOURCESTATE_FRESH || es->state == UA_EVENTSOURCESTATE_STOPPED) {
+                es->start(es);
+            }
+        }
+        return UA_STATUSCODE_GOOD;
+    }
+
+    static void stop(UA_EventLoop* el) {
+        UringEventLoop* loop = self(el);
+        if (el->state != UA_EVENTLOOPSTATE_STARTED) {
+            return;
+        }
+        loop->setState(UA_EVENTLOOPSTATE_STOPPING);
+        for (UA_EventSource* es = el->eventSources; es; es = es->next) {
+            if (es->state == UA_EVENTSOURCESTATE_STARTED) {
+                es->stop(es);
+            }
+        }
+        loop->inner->stop(loop->inner);
+    }
+
+    static UA_StatusCode run(UA_EventLoop* el, UA_UInt32 timeout) {
+        UringEventLoop* loop = self(el);
+        if (el->state != UA_EVENTLOOPSTATE_STARTED && el->state != UA_EVENTLOOPSTATE_STOPPING) {
+            return UA_STATUSCODE_BADINTERNALERROR;
+        }
+        loop->iterate(timeout);
+        return UA_STATUSCODE_GOOD;
+    }
+
+    void iterate(UA_UInt32 timeoutMs) {
+        lock();
+        loopThread = std::this_thread::get_id();
+        ++counters.iterations;
+
+        // Таймеры и отложенные вызовы; без наступивших сроков цикл POSIX не
+        // вызывается вовсе (он сделал бы лишний epoll_wait)
+        UA_DateTime now = inner->dateTime_nowMonotonic(inner);
+        bool innerRunning = inner->state == UA_EVENTLOOPSTATE_STARTED ||
+                            inner->state == UA_EVENTLOOPSTATE_STOPPING;
+        if (innerRunning && (inner->nextCyclicTime(inner) <= now || inner->state == UA_EVENTLOOPSTATE_STOPPING)) {
+            inner->run(inner, 0);
+            now = inner->dateTime_nowMonotonic(inner);
+        }
+
+        // Заявки таймеров и прошлой итерации - одним вызовом, затем ожидание
+        submit();
+        UA_DateTime waitUntil = now + static_cast<UA_DateTime>(timeoutMs) * UA_DATETIME_MSEC;
+        if (inner->state == UA_EVENTLOOPSTATE_STARTED) {
+            waitUntil = std::min(waitUntil, inner->nextCyclicTime(inner));
+        }
+        waitUntil = nextListenerRetry(waitUntil);
+        int64_t waitNs = waitUntil > now ? (waitUntil - now) * 100 : 0;
+        unlock();
+
+        if (io_uring_cq_ready(&ring) == 0 && waitNs > 0) {
+            __kernel_timespec ts;
+            ts.tv_sec = waitNs / 1000000000;
+            ts.tv_nsec = waitNs % 1000000000;
+            io_uring_cqe* cqe = nullptr;
+            io_uring_wait_cqe_timeout(&ring, &cqe, &ts); // -ETIME по таймауту
+            ++counters.enters;
+        }
+
+        lock();
+        processCompletions();
+        resumeStarved();
+        resumeListeners(inner->dateTime_nowMonotonic(inner));
+        finishClosing();
+        submit(); // ответы этой итерации уходят сразу, не дожидаясь следующего вызова run
+        if (loop.el.state == UA_EVENTLOOPSTATE_STOPPING &&
+            tcp.cm.eventSource.state != UA_EVENTSOURCESTATE_STOPPING &&
+            tcp.cm.eventSource.state != UA_EVENTSOURCESTATE_STARTED &&
+            inner->state != UA_EVENTLOOPSTATE_STOPPING && inner->state != UA_EVENTLOOPSTATE_STARTED) {
+            setState(UA_EVENTLOOPSTATE_STOPPED);
+        }
+        unlock();
+    }
+
+    // Ресурсы освобождает деструктор
+    static UA_StatusCode freeLoop(UA_EventLoop* el) {
+        return el->state == UA_EVENTLOOPSTATE_STARTED || el->state == UA_EVENTLOOPSTATE_STOPPING
+            ? UA_STATUSCODE_BADINTERNALERROR : UA_STATUSCODE_GOOD;
+    }
+
+    static UA_DateTime dateTimeNow(UA_EventLoop* el) {
+        UA_EventLoop* inner = self(el)->inner;
+        return inner->dateTime_now(inner);
+    }
+
+    static UA_DateTime dateTimeNowMonotonic(UA_EventLoop* el) {
+        UA_EventLoop* inner = self(el)->inner;
+        return inner->dateTime_nowMonotonic(inner);
+    }
+
+    static UA_Int64 dateTimeLocalTimeUtcOffset(UA_EventLoop* el) {
+        UA_EventLoop* inner = self(el)->inner;
+        return inner->dateTime_localTimeUtcOffset(inner);
+    }
+
+    static UA_DateTime nextCyclicTime(UA_EventLoop* el) {
+        UA_EventLoop* inner = self(el)->inner;
+        return inner->nextCyclicTime(inner);
+    }
+
+    static UA_StatusCode addCyclicCallback(UA_EventLoop* el, UA_Callback cb, void* application, void* data,
+                                           UA_Double intervalMs, UA_DateTime* baseTime,
+                                           UA_TimerPolicy timerPolicy, UA_UInt64* callbackId) {
+        UA_EventLoop* inner = self(el)->inner;
+        return inner->addCyclicCallback(inner, cb, application, data, intervalMs, baseTime, timerPolicy,
+                                        callbackId);
+    }
+
+    static UA_StatusCode modifyCyclicCallback(UA_EventLoop* el, UA_UInt64 callbackId, UA_Double intervalMs,
+                                              UA_DateTime* baseTime, UA_TimerPolicy timerPolicy) {
+        UA_EventLoop* inner = self(el)->inner;
+        return inner->modifyCyclicCallback(inner, callbackId, intervalMs, baseTime, timerPolicy);
+    }
+
+    static void removeCyclicCallback(UA_EventLoop* el, UA_UInt64 callbackId) {
+        UA_EventLoop* inner = self(el)->inner;
+        inner->removeCyclicCallback(inner, callbackId);
+    }
+
+    static UA_StatusCode addTimedCallback(UA_EventLoop* el, UA_Callback cb, void* application, void* data,
+                                          UA_DateTime date, UA_UInt64* callbackId) {
+        UA_EventLoop* inner = self(el)->inner;
+        return inner->addTimedCallback(inner, cb, application, data, date, callbackId);
+    }
+
+    static void addDelayedCallback(UA_EventLoop* el, UA_DelayedCallback* dc) {
+        UA_EventLoop* inner = self(el)->inner;
+        inner->addDelayedCallback(inner, dc);
+    }
+
+    static void removeDelayedCallback(UA_EventLoop* el, UA_DelayedCallback* dc) {
+        UA_EventLoop* inner = self(el)->inner;
+        inner->removeDelayedCallback(inner, dc);
+    }
+
+    // Только собственный менеджер "tcp" (см. ограничения выше)
+    static UA_StatusCode registerEventSource(UA_EventLoop* el, UA_EventSource* es) {
+        UringEventLoop* loop = self(el);
+        if (es != &loop->tcp.cm.eventSource) {
+            std::cerr << "UringEventLoop: источники событий, кроме TCP сервера, не поддерживаются" << std::endl;
+            return UA_STATUSCODE_BADNOTSUPPORTED;
+        }
+        for (UA_EventSource* it = el->eventSources; it; it = it->next) {
+            if (it == es) return UA_STATUSCODE_BADINTERNALERROR;
+        }
+        es->next = el->eventSources;
+        el->eventSources = es;
+        es->eventLoop = el;
+        es->state = UA_EVENTSOURCESTATE_STOPPED;
+        return el->state == UA_EVENTLOOPSTATE_STARTED ? es->start(es) : UA_STATUSCODE_GOOD;
+    }
+
+    static UA_StatusCode deregisterEventSource(UA_EventLoop* el, UA_EventSource* es) {
+        if (es->state != UA_EVENTSOURCESTATE_FRESH && es->state != UA_EVENTSOURCESTATE_STOPPED) {
+            return UA_STATUSCODE_BADINTERNALERROR;
+        }
+        for (UA_EventSource** it = &el->eventSources; *it; it = &(*it)->next) {
+            if (*it == es) {
+                *it = es->next;
+                es->next = nullptr;
+                es->eventLoop = nullptr;
+                return UA_STATUSCODE_GOOD;
+            }
+        }
+        return UA_STATUSCODE_BADNOTFOUND;
+    }
+
+    static void lockLoop(UA_EventLoop* el) { self(el)->lock(); }
+    static void unlockLoop(UA_EventLoop* el) { self(el)->unlock(); }
+
+    // ---------- UA_ConnectionManager "tcp" ----------
+
+    static UA_StatusCode startManager(UA_EventSource* es) {
+        if (es->eventLoop != &self(es)->loop.el) {
+            return UA_STATUSCODE_BADINTERNALERROR;
+        }
+        es->state = UA_EVENTSOURCESTATE_STARTED;
+        return UA_STATUSCODE_GOOD;
+    }
+
+    static void stopManager(UA_EventSource* es) {
+        UringEventLoop* loop = self(es);
+        loop->lock();
+        if (es->state == UA_EVENTSOURCESTATE_STARTED) {
+            es->state = loop->connections.empty() ? UA_EVENTSOURCESTATE_STOPPED : UA_EVENTSOURCESTATE_STOPPING;
+            for (auto& entry : loop->connections) {
+                loop->beginClose(entry.second);
+            }
+        }
+        loop->unlock();
+    }
+
+    static UA_StatusCode freeManager(UA_EventSource* es) {
+        return es->state == UA_EVENTSOURCESTATE_FRESH || es->state == UA_EVENTSOURCESTATE_STOPPED
+            ? UA_STATUSCODE_GOOD : UA_STATUSCODE_BADINTERNALERROR;
+    }
+
+    // Слушающие сокеты для host (nullptr - все интерфейсы); число открытых
+    size_t listenOn(const char* host, UA_UInt16 port, bool validate, void* application, void* context,
+                    UA_ConnectionManager_connectionCallback callback) {
+        addrinfo hints;
+        std::memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_protocol = IPPROTO_TCP;
+        hints.ai_flags = AI_PASSIVE;
+        addrinfo* result = nullptr;
+        std::string service = std::to_string(port);
+        int error = ::getaddrinfo(host, service.c_str(), &hints, &result);
+        if (error != 0) {
+            std::cerr << "UringEventLoop: " << (host ? host : "*") << ": " << gai_strerror(error) << std::endl;
+            return 0;
+        }
+
+        size_t opened = 0;
+        for (addrinfo* ai = result; ai; ai = ai->ai_next) {
+            int fd = ::socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol);
+            if (fd < 0) continue;
+            int one = 1;
+            ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+            if (ai->ai_family == AF_INET6) {
+                ::setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &one, sizeof(one));
+            }
+            if (::bind(fd, ai->ai_addr, ai->ai_addrlen) != 0 || ::listen(fd, SOMAXCONN) != 0) {
+                std::cerr << "UringEventLoop: порт " << port << ": " << std::strerror(errno) << std::endl;
+                ::close(fd);
+                continue;
+            }
+            ++opened;
+            if (validate) {
+                ::close(fd);
+                continue;
+            }
+
+            char address[NI_MAXHOST] = "";
+            ::getnameinfo(ai->ai_addr, ai->ai_addrlen, address, sizeof(address), nullptr, 0, NI_NUMERICHOST);
+            Connection* conn = registerConnection(fd, true, application, context, callback);
+            UA_String addressString = UA_STRING(address);
+            UA_UInt16 listenPort = port;
+            UA_KeyValuePair pairs[2];
+            pairs[0].key = UA_QUALIFIEDNAME(0, const_cast<char*>("listen-address"));
+            UA_Variant_setScalar(&pairs[0].value, &addressString, &UA_TYPES[UA_TYPES_STRING]);
+            pairs[1].key = UA_QUALIFIEDNAME(0, const_cast<char*>("listen-port"));
+            UA_Variant_setScalar(&pairs[1].value, &listenPort, &UA_TYPES[UA_TYPES_UINT16]);
+            UA_KeyValueMap params = {2, pairs};
+            conn->callback(&tcp.cm, static_cast<uintptr_t>(fd), application, &conn->context,
+                           UA_CONNECTIONSTATE_ESTABLISHED, &params, UA_BYTESTRING_NULL);
+            if (!conn->closing) {
+                armAccept(conn);
+            }
+        }
+        ::freeaddrinfo(result);
+        return opened;
+    }
+
+    static UA_StatusCode openConnection(UA_ConnectionManager* cm, const UA_KeyValueMap* params,
+                                        void* application, void* context,
+                                        UA_ConnectionManager_connectionCallback callback) {
+        UringEventLoop* loop = self(cm);
+        if (cm->eventSource.state != UA_EVENTSOURCESTATE_STARTED) {
+            return UA_STATUSCODE_BADINTERNALERROR;
+        }
+        const UA_UInt16* port = static_cast<const UA_UInt16*>(
+            UA_KeyValueMap_getScalar(params, UA_QUALIFIEDNAME(0, const_cast<char*>("port")),
+                                     &UA_TYPES[UA_TYPES_UINT16]));
+        const UA_Boolean* listen = static_cast<const UA_Boolean*>(
+            UA_KeyValueMap_getScalar(params, UA_QUALIFIEDNAME(0, const_cast<char*>("listen")),
+                                     &UA_TYPES[UA_TYPES_BOOLEAN]));
+        const UA_Boolean* validate = static_cast<const UA_Boolean*>(
+            UA_KeyValueMap_getScalar(params, UA_QUALIFIEDNAME(0, const_cast<char*>("validate")),
+                                     &UA_TYPES[UA_TYPES_BOOLEAN]));
+        if (!port) {
+            return UA_STATUSCODE_BADINTERNALERROR;
+        }
+        if (!listen || !*listen) {
+            std::cerr << "UringEventLoop: исходящие TCP-соединения не поддерживаются" << std::endl;
+            return UA_STATUSCODE_BADNOTSUPPORTED;
+        }
+
+        // Адрес - строка или массив строк; без него - все интерфейсы
+        std::vector<std::string> hosts;
+        const UA_Variant* address = UA_KeyValueMap_get(params, UA_QUALIFIEDNAME(0, const_cast<char*>("address")));
+        if (address && address->type == &UA_TYPES[UA_TYPES_STRING]) {
+            const UA_String* names = static_cast<const UA_String*>(address->data);
+            size_t count = UA_Variant_isScalar(address) ? 1 : address->arrayLength;
+            for (size_t i = 0; i < count; ++i) {
+                hosts.emplace_back(reinterpret_cast<const char*>(names[i].data), names[i].length);
+            }
+        }
+
+        loop->lock();
+        size_t opened = 0;
+        bool dryRun = validate && *validate;
+        if (hosts.empty()) {
+            opened = loop->listenOn(nullptr, *port, dryRun, application, context, callback);
+        }
+        for (const std::string& host : hosts) {
+            opened += loop->listenOn(host.c_str(), *port, dryRun, application, context, callback);
+        }
+        if (!loop->onLoopThread()) {
+            loop->submit();
+        }
+        loop->unlock();
+        return opened > 0 ? UA_STATUSCODE_GOOD : UA_STATUSCODE_BADCOMMUNICATIONERROR;
+    }
+
+    // Буфер переходит циклу и освобождается после отправки (и при ошибке)
+    static UA_StatusCode sendWithConnection(UA_ConnectionManager* cm, uintptr_t connectionId,
+                                            const UA_KeyValueMap*, UA_ByteString* buf) {
+        UringEventLoop* loop = self(cm);
+        loop->lock();
+        auto it = loop->connections.find(connectionId);
+        Connection* conn = it != loop->connections.end() ? it->second : nullptr;
+        if (!conn || conn->closing || conn->listening) {
+            loop->unlock();
+            UA_ByteString_clear(buf);
+            return UA_STATUSCODE_BADCONNECTIONCLOSED;
+        }
+        if (buf->length == 0) {
+            loop->unlock();
+            UA_ByteString_clear(buf);
+            return UA_STATUSCODE_GOOD;
+        }
+        conn->queuedBytes += buf->length;
+        conn->sendQueue.push_back(*buf);
+        UA_ByteString_init(buf);
+        if (conn->queuedBytes > MAX_QUEUED_BYTES) {
+            std::cerr << "UringEventLoop: клиент не успевает принимать ответы, соединение закрыто" << std::endl;
+            loop->beginClose(conn);
+        } else if (!conn->sending) {
+            loop->armSend(conn);
+        }
+        if (!loop->onLoopThread()) {
+            loop->submit();
+        }
+        loop->unlock();
+        return UA_STATUSCODE_GOOD;
+    }
+
+    static UA_StatusCode closeConnection(UA_ConnectionManager* cm, uintptr_t connectionId) {
+        UringEventLoop* loop = self(cm);
+        loop->lock();
+        auto it = loop->connections.find(connectionId);
+        if (it == loop->connections.end() || it->second->closing) {
+            loop->unlock();
+            return UA_STATUSCODE_BADCONNECTIONCLOSED;
+        }
+        loop->beginClose(it->second);
+        if (!loop->onLoopThread()) {
+            loop->submit();
+        }
+        loop->unlock();
+        return UA_STATUSCODE_GOOD;
+    }
+
+    static UA_StatusCode allocNetworkBuffer(UA_ConnectionManager*, uintptr_t, UA_ByteString* buf, size_t bufSize) {
+        return UA_ByteString_allocBuffer(buf, bufSize);
+    }
+
+    static void freeNetworkBuffer(UA_ConnectionManager*, uintptr_t, UA_ByteString* buf) {
+        UA_ByteString_clear(buf);
+    }
+
+public:
+    explicit UringEventLoop(unsigned depth = DEFAULT_QUEUE_DEPTH, unsigned recvBuffers = DEFAULT_RECV_BUFFERS,
+                            size_t recvBufferSize = DEFAULT_RECV_BUFFER_SIZE)
+        : queueDepth(depth), bufferCount(recvBuffers), bufferSize(recvBufferSize) {
+        std::memset(&ring, 0, sizeof(ring));
+    }
+
+    ~UringEventLoop() {
+        shutdown();
+        for (auto& entry : connections) {
+            ::close(entry.second->fd);
+            for (UA_ByteString& buffer : entry.second->sendQueue) {
+                UA_ByteString_clear(&buffer);
+            }
+            delete entry.second;
+        }
+        if (bufferRing) {
+            io_uring_free_buf_ring(&ring, bufferRing, bufferCount, BUFFER_GROUP);
+        }
+        if (ringReady) {
+            io_uring_queue_exit(&ring);
+        }
+        if (inner) {
+            inner->free(inner);
+        }
+        if (logger && logger->clear) {
+            logger->clear(logger);
+        }
+    }
+
+    UringEventLoop(const UringEventLoop&) = delete;
+    UringEventLoop& operator=(const UringEventLoop&) = delete;
+
+    // Кольцо, буферы приема и внутренний цикл POSIX; false, если ядро не
+    // поддерживает нужные возможности io_uring
+    bool initialize() {
+        int status = io_uring_queue_init(queueDepth, &ring, 0);
+        if (status < 0) {
+            std::cerr << "UringEventLoop: io_uring_queue_init: " << std::strerror(-status) << std::endl;
+            return false;
+        }
+        ringReady = true;
+        if (!(ring.features & IORING_FEAT_EXT_ARG)) {
+            std::cerr << "UringEventLoop: ядро без IORING_FEAT_EXT_ARG (нужно >= 5.19)" << std::endl;
+            return false;
+        }
+
+        bufferMemory.reset(new (std::nothrow) unsigned char[static_cast<size_t>(bufferCount) * bufferSize]);
+        bufferRing = bufferMemory ? io_uring_setup_buf_ring(&ring, bufferCount, BUFFER_GROUP, 0, &status) : nullptr;
+        if (!bufferRing) {
+            std::cerr << "UringEventLoop: кольцо буферов приема: " << std::strerror(bufferMemory ? -status : ENOMEM)
+                      << std::endl;
+            return false;
+        }
+        for (unsigned id = 0; id < bufferCount; ++id) {
+            io_uring_buf_ring_add(bufferRing, bufferMemory.get() + static_cast<size_t>(id) * bufferSize,
+                                  static_cast<unsigned>(bufferSize), static_cast<unsigned short>(id),
+                                  io_uring_buf_ring_mask(bufferCount), static_cast<int>(id));
+        }
+        io_uring_buf_ring_advance(bufferRing, static_cast<int>(bufferCount));
+
+        logger = UA_Log_Stdout_new(UA_LOGLEVEL_WARNING);
+        inner = UA_EventLoop_new_POSIX(logger);
+        if (!inner) {
+            std::cerr << "UringEventLoop: не удалось создать цикл таймеров" << std::endl;
+            return false;
+        }
+
+        loop.self = this;
+        UA_EventLoop& el = loop.el;
+        el.logger = logger;
+        el.start = &UringEventLoop::start;
+        el.stop = &UringEventLoop::stop;
+        el.run = &UringEventLoop::run;
+        el.free = &UringEventLoop::freeLoop;
+        el.dateTime_now = &UringEventLoop::dateTimeNow;
+        el.dateTime_nowMonotonic = &UringEventLoop::dateTimeNowMonotonic;
+        el.dateTime_localTimeUtcOffset = &UringEventLoop::dateTimeLocalTimeUtcOffset;
+        el.nextCyclicTime = &UringEventLoop::nextCyclicTime;
+        el.addCyclicCallback = &UringEventLoop::addCyclicCallback;
+        el.modifyCyclicCallback = &UringEventLoop::modifyCyclicCallback;
+        el.removeCyclicCallback = &UringEventLoop::removeCyclicCallback;
+        el.addTimedCallback = &UringEventLoop::addTimedCallback;
+        el.addDelayedCallback = &UringEventLoop::addDelayedCallback;
+        el.removeDelayedCallback = &UringEventLoop::removeDelayedCallback;
+        el.registerEventSource = &UringEventLoop::registerEventSource;
+        el.deregisterEventSource = &UringEventLoop::deregisterEventSource;
+        el.lock = &UringEventLoop::lockLoop;
+        el.unlock = &UringEventLoop::unlockLoop;
+
+        tcp.self = this;
+        UA_ConnectionManager& cm = tcp.cm;
+        cm.eventSource.eventSourceType = UA_EVENTSOURCETYPE_CONNECTIONMANAGER;
+        cm.eventSource.name = UA_STRING(const_cast<char*>("io_uring tcp connection manager"));
+        cm.eventSource.start = &UringEventLoop::startManager;
+        cm.eventSource.stop = &UringEventLoop::stopManager;
+        cm.eventSource.free = &UringEventLoop::freeManager;
+        cm.protocol = UA_STRING(const_cast<char*>("tcp"));
+        cm.openConnection = &UringEventLoop::openConnection;
+        cm.sendWithConnection = &UringEventLoop::sendWithConnection;
+        cm.closeConnection = &UringEventLoop::closeConnection;
+        cm.allocNetworkBuffer = &UringEventLoop::allocNetworkBuffer;
+        cm.freeNetworkBuffer = &UringEventLoop::freeNetworkBuffer;
+        return registerEventSource(&el, &cm.eventSource) == UA_STATUSCODE_GOOD;
+    }
+
+    // Для UA_ServerConfig::eventLoop (externalEventLoop = true: цикл
+    // принадлежит этому объекту)
+    UA_EventLoop* getEventLoop() { return &loop.el; }
+
+    // Закрывает соединения и останавливает цикл; вызывать после
+    // UA_Server_run_shutdown и до UA_Server_delete
+    void shutdown() {
+        if (!inner) {
+            return;
+        }
+        stop(&loop.el);
+        while (loop.el.state == UA_EVENTLOOPSTATE_STOPPING) {
+            iterate(10);
+        }
+    }
+
+    UringStats stats() const { return counters; }
+
+    void print(std::ostream& out) const {
+        out << "io_uring: итераций " << counters.iterations << ", вызовов io_uring_enter " << counters.enters
+            << ", завершений " << counters.completions;
+        if (counters.enters > 0) {
+            out << std::fixed << std::setprecision(1) << " (" << static_cast<double>(counters.completions) / counters.enters
+                << " на вызов)";
+        }
+        out << ", соединений " << counters.accepted;
+        if (counters.bufferShortages > 0) {
+            out << ", нехватка буферов приема: " << counters.bufferShortages;
+        }
+        if (counters.acceptErrors > 0) {
+            out << ", ошибок accept: " << counters.acceptErrors;
+        }
+        out << std::endl;
+    }
+};
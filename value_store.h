@@ -0,0 +1,747 @@
+#pragma once
+
+#include <open62541/server.h>
+#include <open62541/plugin/nodestore.h>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <unordered_map>
+#include <stdexcept>
+#include <cstring>
+#include <cstdint>
+
+#include "command_queue.h"
+
+// ============================== ХРАНИЛИЩЕ ЗНАЧЕНИЙ ==============================
+// Значения переменных оборудования лежат в плотном массиве слотов, а узлы
+// сервера подключены к нему как DataSource. Запись значения симулятором -
+// это memcpy в слот без обращения к узлу; чтение клиентом - копирование из слота.
+// Слот занимает ровно столько байт, сколько его тип (Boolean - 1, Float - 4),
+// с выравниванием по размеру элемента; массивы фиксированной длины хранятся подряд.
+//
+// Значения пишет поток симуляции, читают потоки сервисов. Каждый слот защищен
+// счетчиком последовательности (seqlock): писатель делает его нечетным на время
+// записи, читатель повторяет копирование, если счетчик изменился.
+//
+// Слоты выделяются и освобождаются и во время работы (устройства добавляются и
+// удаляются без перезапуска, см. DeviceFleet). Массивы слотов и значений
+// резервируются в конструкторе и не перераспределяются, поэтому читатели не
+// блокируются; освобожденный слот достается следующей переменной, которая в
+// нем помещается (сначала того же размера и выравнивания, иначе наименьший
+// подходящий). Выделяет и освобождает слоты один поток (поток
+// симуляции); таблица NodeId -> слот защищена мьютексом.
+//
+// Номер слота одновременно служит "ручкой" (handle) для быстрого доступа:
+// NodeId вида ns=<ns>;i=HANDLE_BASE+(поколение<<SLOT_BITS)+slot разрешается
+// индексом в массиве. Поколение растет при каждом повторном использовании
+// слота, так что ручка удаленной переменной не указывает на чужое значение.
+class ValueStore {
+public:
+    using Slot = uint32_t;
+    static constexpr UA_UInt32 HANDLE_BASE = 0x80000000u;
+    static constexpr unsigned SLOT_BITS = 16;
+    static constexpr size_t MAX_SLOTS = size_t(1) << SLOT_BITS;
+    static constexpr size_t DEFAULT_SLOT_CAPACITY = 16384;
+    static constexpr size_t DEFAULT_ARENA_BYTES = 1024 * 1024;
+
+private:
+    static constexpr uint32_t GENERATION_MASK = (1u << (31 - SLOT_BITS)) - 1;
+    static constexpr uint32_t NOT_WATCHED = UINT32_MAX;
+
+    struct SlotInfo {
+        UA_NodeId nodeId;
+        const UA_DataType* type;
+        size_t offset;        // в байтах от начала arena
+        size_t byteSize;      // type->memSize * число элементов
+        uint64_t shape;       // shapeKey места в arena: не меньше byteSize
+        size_t arrayLength;   // 0 - скаляр
+        UA_DateTime sourceTimestamp;
+        std::atomic<uint32_t> sequence; // нечетное - идет запись
+        std::atomic<uint32_t> watchers; // MonitoredItems на значении узла
+        uint32_t watchedIndex;          // позиция в watched, NOT_WATCHED - нет подписчиков
+        uint32_t pushedSequence;        // sequence при последней выборке (см. forEachChanged)
+        std::atomic<uint32_t> tag;      // (поколение << 1) | 1, пока слот занят
+
+        SlotInfo(const UA_NodeId& id, const UA_DataType* t, size_t off, size_t size, uint64_t place,
+                 size_t length)
+            : nodeId(id), type(t), offset(off), byteSize(size), shape(place), arrayLength(length),
+              sourceTimestamp(UA_DateTime_now()), sequence(0), watchers(0), watchedIndex(NOT_WATCHED), pushedSequence(0), tag(1) {}
+
+        // Нужен std::vector; емкость зарезервирована, и копирование не происходит
+        SlotInfo(const SlotInfo& other)
+            : nodeId(other.nodeId), type(other.type), offset(other.offset),
+              byteSize(other.byteSize), shape(other.shape), arrayLength(other.arrayLength),
+              sourceTimestamp(other.sourceTimestamp),
+              sequence(other.sequence.load(std::memory_order_relaxed)),
+              watchers(other.watchers.load(std::memory_order_relaxed)),
+              watchedIndex(other.watchedIndex),
+              pushedSequence(other.pushedSequence),
+              tag(other.tag.load(std::memory_order_relaxed)) {}
+    };
+
+    std::vector<SlotInfo> slots;
+    std::vector<uint64_t> arena; // хранилище значений, выровненное по 8 байт
+    size_t arenaBytes = 0;
+    std::atomic<size_t> arenaUsed{0}; // arenaBytes для потоков сервисов
+    size_t slotCapacity;
+    size_t arenaCapacity;
+    std::atomic<size_t> slotCount{0}; // slots.size() для потоков сервисов
+    std::unordered_map<uint64_t, std::vector<Slot>> freeSlots; // по размеру и выравниванию места
+    std::atomic<size_t> freeScalarCount{0}; // свободных слотов, вмещающих любой скаляр (см. available)
+    mutable std::mutex indexLock;
+    std::unordered_map<uint64_t, Slot> slotByNodeId;
+    // Слоты с подписчиками: forEachChanged обходит только их, а не все слоты
+    std::mutex watchLock;
+    std::vector<Slot> watched;
+    std::vector<Slot> watchedSnapshot; // копия watched на время обхода
+
+    static uint64_t key(UA_UInt16 ns, UA_UInt32 id) {
+        return (static_cast<uint64_t>(ns) << 32) | id;
+    }
+
+    static size_t alignmentOf(const UA_DataType* type) {
+        return type->memSize < sizeof(uint64_t) ? type->memSize : sizeof(uint64_t);
+    }
+
+    static uint64_t shapeKey(size_t byteSize, size_t align) {
+        return (static_cast<uint64_t>(byteSize) << 8) | align;
+    }
+
+    // Вмещает ли место формы shape значение размера byteSize с выравниванием align
+    // (выравнивания - степени двойки, смещение места кратно его выравниванию)
+    static bool fits(uint64_t shape, size_t byteSize, size_t align) {
+        return (shape >> 8) >= byteSize && (shape & 0xff) >= align;
+    }
+
+    static bool holdsAnyScalar(uint64_t shape) {
+        return fits(shape, sizeof(uint64_t), sizeof(uint64_t));
+    }
+
+    // Свободный слот для значения: той же формы, иначе наименьший подходящий;
+    // false, если такого нет
+    bool takeFree(size_t byteSize, size_t align, Slot& slot) {
+        auto best = freeSlots.find(shapeKey(byteSize, align));
+        if (best == freeSlots.end() || best->second.empty()) {
+            best = freeSlots.end();
+            for (auto it = freeSlots.begin(); it != freeSlots.end(); ++it) {
+                if (!it->second.empty() && fits(it->first, byteSize, align) &&
+                    (best == freeSlots.end() || it->first < best->first)) {
+                    best = it;
+                }
+            }
+            if (best == freeSlots.end()) {
+                return false;
+            }
+        }
+        slot = best->second.back();
+        best->second.pop_back();
+        if (holdsAnyScalar(best->first)) {
+            freeScalarCount.fetch_sub(1, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    unsigned char* bytes(size_t offset) {
+        return reinterpret_cast<unsigned char*>(arena.data()) + offset;
+    }
+
+    const unsigned char* bytes(size_t offset) const {
+        return reinterpret_cast<const unsigned char*>(arena.data()) + offset;
+    }
+
+    // Писателей может быть несколько (симуляция и запись клиентом), поэтому
+    // нечетное значение захватывается через CAS
+    static void beginWrite(SlotInfo& info) {
+        uint32_t seq = info.sequence.load(std::memory_order_relaxed);
+        for (;;) {
+            if (!(seq & 1) && info.sequence.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire,
+                                                                  std::memory_order_relaxed)) {
+                break;
+            }
+            seq = info.sequence.load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    static void endWrite(SlotInfo& info) {
+        info.sourceTimestamp = UA_DateTime_now();
+        info.sequence.fetch_add(1, std::memory_order_release);
+    }
+
+public:
+    explicit ValueStore(size_t maxSlots = DEFAULT_SLOT_CAPACITY, size_t maxArenaBytes = DEFAULT_ARENA_BYTES)
+        : slotCapacity(maxSlots < MAX_SLOTS ? maxSlots : MAX_SLOTS), arenaCapacity(maxArenaBytes) {
+        slots.reserve(slotCapacity);
+        arena.reserve((arenaCapacity + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+    }
+    ValueStore(const ValueStore&) = delete;
+    ValueStore& operator=(const ValueStore&) = delete;
+
+    // Поддерживаются типы без указателей (double, Int32, Boolean, ...), скаляры
+    // (arrayLength = 0) и массивы фиксированной длины; только числовые NodeId.
+    // Бросает std::length_error, если емкость хранилища исчерпана.
+    Slot allocate(const UA_NodeId& nodeId, const UA_DataType* type, const void* initialValue,
+                  size_t arrayLength = 0) {
+        size_t align = alignmentOf(type);
+        size_t byteSize = type->memSize * (arrayLength ? arrayLength : 1);
+
+        Slot slot;
+        if (takeFree(byteSize, align, slot)) {
+            SlotInfo& info = slots[slot];
+            info.nodeId = nodeId;
+            info.type = type;
+            info.byteSize = byteSize;
+            info.arrayLength = arrayLength;
+            info.sourceTimestamp = UA_DateTime_now();
+            info.pushedSequence = info.sequence.load(std::memory_order_relaxed);
+            std::memcpy(bytes(info.offset), initialValue, byteSize);
+            uint32_t generation = ((info.tag.load(std::memory_order_relaxed) >> 1) + 1) & GENERATION_MASK;
+            info.tag.store((generation << 1) | 1, std::memory_order_release);
+        } else {
+            size_t offset = (arenaBytes + align - 1) / align * align;
+            if (slots.size() >= slotCapacity || offset + byteSize > arenaCapacity) {
+                throw std::length_error("ValueStore: емкость хранилища исчерпана");
+            }
+            slot = static_cast<Slot>(slots.size());
+            arenaBytes = offset + byteSize;
+            arenaUsed.store(arenaBytes, std::memory_order_relaxed);
+            arena.resize((arenaBytes + sizeof(uint64_t) - 1) / sizeof(uint64_t), 0);
+            std::memcpy(bytes(offset), initialValue, byteSize);
+
+            slots.emplace_back(nodeId, type, offset, byteSize, shapeKey(byteSize, align), arrayLength);
+            slotCount.store(slots.size(), std::memory_order_release);
+        }
+
+        if (nodeId.identifierType == UA_NODEIDTYPE_NUMERIC) {
+            std::lock_guard<std::mutex> guard(indexLock);
+            slotByNodeId[key(nodeId.namespaceIndex, nodeId.identifier.numeric)] = slot;
+        }
+        return slot;
+    }
+
+    // Слот удаленной переменной: ручки перестают разрешаться сразу, сам слот
+    // переходит следующей переменной. Вызывать, когда обращений к переменной
+    // уже не может быть (узел удален, см. DeviceFleet).
+    void release(Slot slot) {
+        SlotInfo& info = slots[slot];
+        uint32_t tag = info.tag.load(std::memory_order_relaxed);
+        if (!(tag & 1)) {
+            return;
+        }
+        info.tag.store(tag & ~1u, std::memory_order_release);
+        {
+            std::lock_guard<std::mutex> guard(watchLock);
+            info.watchers.store(0, std::memory_order_relaxed);
+            unwatch(slot);
+        }
+        if (info.nodeId.identifierType == UA_NODEIDTYPE_NUMERIC) {
+            std::lock_guard<std::mutex> guard(indexLock);
+            auto it = slotByNodeId.find(key(info.nodeId.namespaceIndex, info.nodeId.identifier.numeric));
+            if (it != slotByNodeId.end() && it->second == slot) {
+                slotByNodeId.erase(it);
+            }
+        }
+        freeSlots[info.shape].push_back(slot);
+        if (holdsAnyScalar(info.shape)) {
+            freeScalarCount.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    size_t size() const { return slots.size(); }
+    size_t capacity() const { return slotCapacity; }
+    size_t byteSize() const { return arenaBytes; }
+    
+    // Сколько скаляров (до 8 байт) гарантированно поместится: свободные слоты,
+    // вмещающие любой скаляр, и новые слоты в остатке arena по 16 байт на слот
+    // (8 байт значения и худший отступ выравнивания). Меньшие свободные слоты
+    // не учитываются - оценка с запасом
+    size_t available() const {
+        size_t freshSlots = slotCapacity - slotCount.load(std::memory_order_relaxed);
+        size_t freshBytes = arenaCapacity - arenaUsed.load(std::memory_order_relaxed);
+        return std::min(freshSlots, freshBytes / 16) + freeScalarCount.load(std::memory_order_relaxed);
+    }
+
+    const UA_DataType* getType(Slot slot) const { return slots[slot].type; }
+    size_t getArrayLength(Slot slot) const { return slots[slot].arrayLength; }
+    const void* data(Slot slot) const { return bytes(slots[slot].offset); }
+    const UA_NodeId& getNodeId(Slot slot) const { return slots[slot].nodeId; }
+
+    void write(Slot slot, const void* value) {
+        SlotInfo& info = slots[slot];
+        beginWrite(info);
+        std::memcpy(bytes(info.offset), value, info.byteSize);
+        endWrite(info);
+    }
+
+    // Запись с известным при компиляции размером; тип T должен совпадать с типом слота
+    // (гарантируется OPCUAVariable<T>)
+    template<typename T>
+    void writeAs(Slot slot, const T& value) {
+        SlotInfo& info = slots[slot];
+        beginWrite(info);
+        std::memcpy(bytes(info.offset), &value, sizeof(T));
+        endWrite(info);
+    }
+
+    // ---------- ручки ----------
+
+    bool findSlot(const UA_NodeId& nodeId, Slot& slot) const {
+        if (nodeId.identifierType != UA_NODEIDTYPE_NUMERIC) {
+            return false;
+        }
+        if (nodeId.identifier.numeric >= HANDLE_BASE) {
+            return resolveHandle(nodeId, slot);
+        }
+        std::lock_guard<std::mutex> guard(indexLock);
+        auto it = slotByNodeId.find(key(nodeId.namespaceIndex, nodeId.identifier.numeric));
+        if (it == slotByNodeId.end()) {
+            return false;
+        }
+        slot = it->second;
+        return true;
+    }
+
+    UA_NodeId handleNodeId(Slot slot) const {
+        const SlotInfo& info = slots[slot];
+        UA_UInt32 generation = info.tag.load(std::memory_order_relaxed) >> 1;
+        return UA_NODEID_NUMERIC(info.nodeId.namespaceIndex, HANDLE_BASE + (generation << SLOT_BITS) + slot);
+    }
+
+    // Прямой доступ по индексу; false, если это не ручка данного хранилища
+    // или слот с тех пор освобожден
+    bool resolveHandle(const UA_NodeId& nodeId, Slot& slot) const {
+        if (nodeId.identifierType != UA_NODEIDTYPE_NUMERIC ||
+            nodeId.identifier.numeric < HANDLE_BASE) {
+            return false;
+        }
+        UA_UInt32 index = nodeId.identifier.numeric - HANDLE_BASE;
+        Slot candidate = index & (MAX_SLOTS - 1);
+        if (candidate >= slotCount.load(std::memory_order_acquire)) {
+            return false;
+        }
+        const SlotInfo& info = slots[candidate];
+        if (info.tag.load(std::memory_order_acquire) != (((index >> SLOT_BITS) << 1) | 1) ||
+            info.nodeId.namespaceIndex != nodeId.namespaceIndex) {
+            return false;
+        }
+        slot = candidate;
+        return true;
+    }
+
+    const UA_NodeId* resolveHandle(const UA_NodeId& nodeId) const {
+        Slot slot;
+        return resolveHandle(nodeId, slot) ? &slots[slot].nodeId : nullptr;
+    }
+
+    // ---------- подписчики ----------
+
+private:
+    // Под watchLock; удаление перестановкой последнего элемента на место слота
+    void unwatch(Slot slot) {
+        uint32_t index = slots[slot].watchedIndex;
+        if (index == NOT_WATCHED) {
+            return;
+        }
+        Slot last = watched.back();
+        watched[index] = last;
+        slots[last].watchedIndex = index;
+        watched.pop_back();
+        slots[slot].watchedIndex = NOT_WATCHED;
+    }
+
+public:
+    // Счетчик MonitoredItems на слоте; меняется из потока сервисов. Первый
+    // подписчик вносит слот в список обхода forEachChanged
+    void addWatcher(Slot slot) {
+        std::lock_guard<std::mutex> guard(watchLock);
+        SlotInfo& info = slots[slot];
+        if (info.watchers.fetch_add(1, std::memory_order_relaxed) == 0 && info.watchedIndex == NOT_WATCHED) {
+            info.watchedIndex = static_cast<uint32_t>(watched.size());
+            watched.push_back(slot);
+        }
+    }
+
+    // Не уходит ниже нуля: MonitoredItem мог пережить освобождение слота
+    void removeWatcher(Slot slot) {
+        std::lock_guard<std::mutex> guard(watchLock);
+        std::atomic<uint32_t>& watchers = slots[slot].watchers;
+        uint32_t n = watchers.load(std::memory_order_relaxed);
+        if (n > 0) {
+            watchers.store(n - 1, std::memory_order_relaxed);
+            if (n == 1) {
+                unwatch(slot);
+            }
+        }
+    }
+
+    size_t watchedCount() {
+        std::lock_guard<std::mutex> guard(watchLock);
+        return watched.size();
+    }
+
+    uint32_t watcherCount(Slot slot) const {
+        return slots[slot].watchers.load(std::memory_order_relaxed);
+    }
+
+    // Вызывает fn(slot) для слотов с подписчиками, записанных с прошлого вызова;
+    // возвращает число таких слотов. Слот, запись в который идет прямо сейчас,
+    // попадет в следующий вызов. Стоимость пропорциональна числу слотов с
+    // подписчиками, а не всем слотам. fn вызывается без watchLock (запись в
+    // сервер берет блокировку сервера, под которой идут addWatcher/removeWatcher).
+    // Вызывать из одного потока - того же, что выделяет и освобождает слоты.
+    template<typename Fn>
+    size_t forEachChanged(Fn&& fn) {
+        {
+            std::lock_guard<std::mutex> guard(watchLock);
+            watchedSnapshot.assign(watched.begin(), watched.end());
+        }
+        size_t changed = 0;
+        for (Slot slot : watchedSnapshot) {
+            SlotInfo& info = slots[slot];
+            if (info.watchers.load(std::memory_order_relaxed) == 0) {
+                continue; // последний подписчик ушел после снимка
+            }
+            uint32_t seq = info.sequence.load(std::memory_order_acquire);
+            if ((seq & 1) || seq == info.pushedSequence) {
+                continue;
+            }
+            info.pushedSequence = seq;
+            fn(slot);
+            ++changed;
+        }
+        return changed;
+    }
+
+    // ---------- обмен с сервисами OPC UA ----------
+
+    // range допускается только для массивов
+    UA_StatusCode read(Slot slot, UA_Boolean includeSourceTimestamp, const UA_NumericRange* range,
+                       UA_DataValue* value) const {
+        const SlotInfo& info = slots[slot];
+        if (info.arrayLength == 0 && range) {
+            value->hasStatus = true;
+            value->status = UA_STATUSCODE_BADINDEXRANGEINVALID;
+            return UA_STATUSCODE_GOOD;
+        }
+
+        void* src = const_cast<unsigned char*>(bytes(info.offset));
+        UA_DateTime timestamp;
+        for (;;) {
+            uint32_t before = info.sequence.load(std::memory_order_acquire);
+            if (before & 1) {
+                continue; // запись в процессе
+            }
+            UA_StatusCode status;
+            if (info.arrayLength == 0) {
+                status = UA_Variant_setScalarCopy(&value->value, src, info.type);
+            } else if (range) {
+                UA_Variant whole;
+                UA_Variant_setArray(&whole, src, info.arrayLength, info.type);
+                status = UA_Variant_copyRange(&whole, &value->value, *range);
+            } else {
+                status = UA_Variant_setArrayCopy(&value->value, src, info.arrayLength, info.type);
+            }
+            if (status != UA_STATUSCODE_GOOD) {
+                return status;
+            }
+            timestamp = info.sourceTimestamp;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (info.sequence.load(std::memory_order_relaxed) == before) {
+                break;
+            }
+            UA_Variant_clear(&value->value); // значение изменилось во время копирования
+        }
+
+        value->hasValue = true;
+        if (includeSourceTimestamp) {
+            value->sourceTimestamp = timestamp;
+            value->hasSourceTimestamp = true;
+        }
+        return UA_STATUSCODE_GOOD;
+    }
+
+    // Значение числового скаляра, приведенное к double (для потребителей вне
+    // OPC UA); false для массивов и нечисловых типов
+    bool readNumeric(Slot slot, double& out) const {
+        const SlotInfo& info = slots[slot];
+        if (info.arrayLength != 0 || info.byteSize > sizeof(uint64_t)) {
+            return false;
+        }
+
+        unsigned char raw[sizeof(uint64_t)];
+        for (;;) {
+            uint32_t before = info.sequence.load(std::memory_order_acquire);
+            if (before & 1) {
+                continue;
+            }
+            std::memcpy(raw, bytes(info.offset), info.byteSize);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (info.sequence.load(std::memory_order_relaxed) == before) {
+                break;
+            }
+        }
+
+        switch (info.type->typeKind) {
+        case UA_DATATYPEKIND_BOOLEAN: out = *reinterpret_cast<UA_Boolean*>(raw) ? 1.0 : 0.0; return true;
+        case UA_DATATYPEKIND_SBYTE:   out = *reinterpret_cast<UA_SByte*>(raw); return true;
+        case UA_DATATYPEKIND_BYTE:    out = *reinterpret_cast<UA_Byte*>(raw); return true;
+        case UA_DATATYPEKIND_INT16:   out = *reinterpret_cast<UA_Int16*>(raw); return true;
+        case UA_DATATYPEKIND_UINT16:  out = *reinterpret_cast<UA_UInt16*>(raw); return true;
+        case UA_DATATYPEKIND_INT32:   out = *reinterpret_cast<UA_Int32*>(raw); return true;
+        case UA_DATATYPEKIND_UINT32:  out = *reinterpret_cast<UA_UInt32*>(raw); return true;
+        case UA_DATATYPEKIND_INT64:   out = static_cast<double>(*reinterpret_cast<UA_Int64*>(raw)); return true;
+        case UA_DATATYPEKIND_UINT64:  out = static_cast<double>(*reinterpret_cast<UA_UInt64*>(raw)); return true;
+        case UA_DATATYPEKIND_FLOAT:   out = *reinterpret_cast<UA_Float*>(raw); return true;
+        case UA_DATATYPEKIND_DOUBLE:  out = *reinterpret_cast<UA_Double*>(raw); return true;
+        default: return false;
+        }
+    }
+
+    UA_StatusCode writeFromClient(Slot slot, const UA_DataValue* value) {
+        const SlotInfo& info = slots[slot];
+        if (!value->hasValue || value->value.type != info.type) {
+            return UA_STATUSCODE_BADTYPEMISMATCH;
+        }
+        bool scalar = UA_Variant_isScalar(&value->value);
+        if (info.arrayLength == 0 ? !scalar
+                                  : scalar || value->value.arrayLength != info.arrayLength) {
+            return UA_STATUSCODE_BADTYPEMISMATCH;
+        }
+        write(slot, value->value.data);
+        return UA_STATUSCODE_GOOD;
+    }
+};
+
+// ============================== ОБЕРТКА НАД NODESTORE ==============================
+// Оборачивает стандартный nodestore сервера; хранилище значений и очередь
+// команд уставок принадлежат обертке и удаляются вместе с сервером.
+//
+// getNode по ручке не ищет узел в хеш-таблице стандартного nodestore: узел
+// берется по номеру слота из массива копий. Копия узла переменной снимается при
+// первом обращении по ручке и сбрасывается, когда узел заменяется (новые
+// ссылки, атрибуты) или удаляется. Копий две на слот: новая пишется на место
+// предпоследней, а сервисы держат узел только на время одного запроса, и
+// замены узлов идут под той же блокировкой сервера. releaseNode узнает копию по
+// адресу и в стандартный nodestore ее не передает. Копии освобожденного слота
+// живут до его повторного использования - как и само значение в ValueStore.
+// Остальные запросы (и ручки в getNodeCopy/removeNode) делегируются с
+// переводом ручки в настоящий NodeId.
+class EquipmentNodestore {
+public:
+    // Номера узлов, для которых NodeId не задан (аргументы методов и т.п.);
+    // выдаются здесь, чтобы ни один узел не получил номер из диапазона ручек
+    static constexpr UA_UInt32 AUTO_ID_BASE = 0x60000000u;
+    static_assert(AUTO_ID_BASE < ValueStore::HANDLE_BASE, "Автоматические номера - ниже диапазона ручек");
+
+private:
+    static constexpr size_t COMMAND_QUEUE_CAPACITY = 4096;
+
+    struct HandleNode {
+        std::atomic<const UA_Node*> current{nullptr};
+        unsigned next = 0;
+        bool filled[2] = {false, false};
+    };
+
+    UA_Nodestore inner;
+    ValueStore store;
+    SetpointQueue commands;
+    std::unique_ptr<HandleNode[]> handleNodes;   // по номеру слота
+    std::unique_ptr<UA_Node[]> handleCopies;     // две на слот; память не трогается до первой копии
+    std::mutex handleLock;
+    UA_UInt32 nextAutoId = AUTO_ID_BASE;
+
+    explicit EquipmentNodestore(const UA_Nodestore& wrapped)
+        : inner(wrapped), commands(COMMAND_QUEUE_CAPACITY),
+          handleNodes(new HandleNode[store.capacity()]),
+          handleCopies(new UA_Node[store.capacity() * 2]) {}
+
+    ~EquipmentNodestore() {
+        for (size_t slot = 0; slot < store.capacity(); ++slot) {
+            for (unsigned i = 0; i < 2; ++i) {
+                if (handleNodes[slot].filled[i]) {
+                    UA_Node_clear(&handleCopies[slot * 2 + i]);
+                }
+            }
+        }
+    }
+
+    static EquipmentNodestore* self(void* ctx) { return static_cast<EquipmentNodestore*>(ctx); }
+
+    bool isHandleCopy(const UA_Node* node) const {
+        uintptr_t address = reinterpret_cast<uintptr_t>(node);
+        uintptr_t begin = reinterpret_cast<uintptr_t>(handleCopies.get());
+        return address >= begin && address < begin + store.capacity() * 2 * sizeof(UA_Node);
+    }
+
+    // Узел переменной по ручке; nullptr, если узла уже нет
+    const UA_Node* handleNode(ValueStore::Slot slot) {
+        const UA_Node* node = handleNodes[slot].current.load(std::memory_order_acquire);
+        if (node && UA_NodeId_equal(&node->head.nodeId, &store.getNodeId(slot))) {
+            return node;
+        }
+        return copyForHandle(slot);
+    }
+
+    const UA_Node* copyForHandle(ValueStore::Slot slot) {
+        std::lock_guard<std::mutex> guard(handleLock);
+        HandleNode& entry = handleNodes[slot];
+        const UA_NodeId& target = store.getNodeId(slot);
+        const UA_Node* current = entry.current.load(std::memory_order_relaxed);
+        if (current && UA_NodeId_equal(&current->head.nodeId, &target)) {
+            return current;
+        }
+
+        const UA_Node* original = inner.getNode(inner.context, &target, UA_NODEATTRIBUTESMASK_ALL,
+                                                UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+        if (!original) {
+            return nullptr;
+        }
+        UA_Node* copy = &handleCopies[slot * 2 + entry.next];
+        if (entry.filled[entry.next]) {
+            UA_Node_clear(copy);
+            entry.filled[entry.next] = false;
+        }
+        std::memset(copy, 0, sizeof(UA_Node));
+        copy->head.nodeClass = original->head.nodeClass; // UA_Node_copy требует совпадения
+        UA_StatusCode status = UA_Node_copy(original, copy);
+        inner.releaseNode(inner.context, original);
+        if (status != UA_STATUSCODE_GOOD) {
+            return nullptr;
+        }
+        entry.filled[entry.next] = true;
+        entry.next ^= 1;
+        entry.current.store(copy, std::memory_order_release);
+        return copy;
+    }
+
+    // Узел изменился или удален: следующее обращение по ручке снимет новую копию
+    void dropHandleNode(const UA_NodeId& nodeId) {
+        ValueStore::Slot slot;
+        if (nodeId.namespaceIndex != 0 && store.findSlot(nodeId, slot)) {
+            handleNodes[slot].current.store(nullptr, std::memory_order_release);
+        }
+    }
+
+    const UA_NodeId* translate(const UA_NodeId* nodeId) const {
+        const UA_NodeId* target = store.resolveHandle(*nodeId);
+        return target ? target : nodeId;
+    }
+
+    static void clear(void* ctx) {
+        EquipmentNodestore* ns = self(ctx);
+        ns->inner.clear(ns->inner.context);
+        delete ns;
+    }
+
+    static UA_Node* newNode(void* ctx, UA_NodeClass nodeClass) {
+        return self(ctx)->inner.newNode(self(ctx)->inner.context, nodeClass);
+    }
+
+    static void deleteNode(void* ctx, UA_Node* node) {
+        self(ctx)->inner.deleteNode(self(ctx)->inner.context, node);
+    }
+
+    static const UA_Node* getNode(void* ctx, const UA_NodeId* nodeId, UA_UInt32 attributeMask,
+                                  UA_ReferenceTypeSet references, UA_BrowseDirection directions) {
+        EquipmentNodestore* ns = self(ctx);
+        ValueStore::Slot slot;
+        if (ns->store.resolveHandle(*nodeId, slot)) {
+            if (const UA_Node* node = ns->handleNode(slot)) {
+                return node;
+            }
+        }
+        return ns->inner.getNode(ns->inner.context, ns->translate(nodeId), attributeMask,
+                                 references, directions);
+    }
+
+    static const UA_Node* getNodeFromPtr(void* ctx, UA_NodePointer ptr, UA_UInt32 attributeMask,
+                                         UA_ReferenceTypeSet references, UA_BrowseDirection directions) {
+        EquipmentNodestore* ns = self(ctx);
+        return ns->inner.getNodeFromPtr(ns->inner.context, ptr, attributeMask, references, directions);
+    }
+
+    static void releaseNode(void* ctx, const UA_Node* node) {
+        EquipmentNodestore* ns = self(ctx);
+        if (ns->isHandleCopy(node)) {
+            return;
+        }
+        ns->inner.releaseNode(ns->inner.context, node);
+    }
+
+    static UA_StatusCode getNodeCopy(void* ctx, const UA_NodeId* nodeId, UA_Node** outNode) {
+        EquipmentNodestore* ns = self(ctx);
+        return ns->inner.getNodeCopy(ns->inner.context, ns->translate(nodeId), outNode);
+    }
+
+    static UA_StatusCode insertNode(void* ctx, UA_Node* node, UA_NodeId* addedNodeId) {
+        EquipmentNodestore* ns = self(ctx);
+        UA_NodeId& id = node->head.nodeId;
+        if (id.namespaceIndex != 0 && id.identifierType == UA_NODEIDTYPE_NUMERIC && id.identifier.numeric == 0 &&
+            ns->nextAutoId < ValueStore::HANDLE_BASE) {
+            id.identifier.numeric = ns->nextAutoId++;
+        }
+        return ns->inner.insertNode(ns->inner.context, node, addedNodeId);
+    }
+
+    static UA_StatusCode replaceNode(void* ctx, UA_Node* node) {
+        EquipmentNodestore* ns = self(ctx);
+        UA_NodeId nodeId = node->head.nodeId; // после успешной замены узел принадлежит nodestore
+        UA_StatusCode status = ns->inner.replaceNode(ns->inner.context, node);
+        if (status == UA_STATUSCODE_GOOD) {
+            ns->dropHandleNode(nodeId);
+        }
+        return status;
+    }
+
+    static UA_StatusCode removeNode(void* ctx, const UA_NodeId* nodeId) {
+        EquipmentNodestore* ns = self(ctx);
+        ns->dropHandleNode(*nodeId);
+        return ns->inner.removeNode(ns->inner.context, ns->translate(nodeId));
+    }
+
+    static const UA_NodeId* getReferenceTypeId(void* ctx, UA_Byte refTypeIndex) {
+        return self(ctx)->inner.getReferenceTypeId(self(ctx)->inner.context, refTypeIndex);
+    }
+
+    static void iterate(void* ctx, UA_NodestoreVisitor visitor, void* visitorCtx) {
+        self(ctx)->inner.iterate(self(ctx)->inner.context, visitor, visitorCtx);
+    }
+
+    // При первом обращении устанавливает обертку.
+    // Вызывать до запуска сервера (UA_Server_run_startup).
+    static EquipmentNodestore& install(UA_Server* server) {
+        UA_Nodestore& ns = UA_Server_getConfig(server)->nodestore;
+        if (ns.getNode == &EquipmentNodestore::getNode) {
+            return *self(ns.context);
+        }
+
+        EquipmentNodestore* wrapper = new EquipmentNodestore(ns);
+        ns.context = wrapper;
+        ns.clear = &EquipmentNodestore::clear;
+        ns.newNode = &EquipmentNodestore::newNode;
+        ns.deleteNode = &EquipmentNodestore::deleteNode;
+        ns.getNode = &EquipmentNodestore::getNode;
+        ns.getNodeFromPtr = &EquipmentNodestore::getNodeFromPtr;
+        ns.releaseNode = &EquipmentNodestore::releaseNode;
+        ns.getNodeCopy = &EquipmentNodestore::getNodeCopy;
+        ns.insertNode = &EquipmentNodestore::insertNode;
+        ns.replaceNode = &EquipmentNodestore::replaceNode;
+        ns.removeNode = &EquipmentNodestore::removeNode;
+        ns.getReferenceTypeId = &EquipmentNodestore::getReferenceTypeId;
+        ns.iterate = &EquipmentNodestore::iterate;
+        return *wrapper;
+    }
+
+public:
+    // Хранилище значений сервера
+    static ValueStore& storeFor(UA_Server* server) {
+        return install(server).store;
+    }
+
+    // Очередь записей клиентов в уставки; разбирается циклом симуляции
+    static SetpointQueue& commandsFor(UA_Server* server) {
+        return install(server).commands;
+    }
+};